@@ -0,0 +1,195 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#define P_USE_USER_MAIN
+#include "colorramp.h"
+#include "processing.h"
+#include "colorspace.h"
+#include "pparallel.h"
+#include <algorithm>
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+PROCESSING_BEGIN_NAMESPACE
+
+// Hue in sixths of the circle, saturation from 0 to 1 and brightness from
+// 0 to 255, the ranges ColorSpace takes them in below
+static void toHSB(unsigned int argb, float hsb[3])
+{
+    float r = (argb >> 16) & 0xFF;
+    float g = (argb >> 8) & 0xFF;
+    float b = argb & 0xFF;
+    float high = std::max(std::max(r, g), b);
+    float range = high - std::min(std::min(r, g), b);
+    float h = 0;
+    if (range > 0)
+    {
+        if (high == r)
+            h = (g - b) / range;
+        else if (high == g)
+            h = 2 + (b - r) / range;
+        else
+            h = 4 + (r - g) / range;
+        if (h < 0)
+            h += 6;
+    }
+    hsb[0] = h;
+    hsb[1] = (high > 0 ? range / high : 0);
+    hsb[2] = high;
+}
+
+static void lookup(const unsigned int *table, float top, float scale, float offset,
+        const float *values, unsigned int *out, int count)
+{
+    int i = 0;
+#ifdef __SSE2__
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 last = _mm_set1_ps(top);
+    const __m128 a = _mm_set1_ps(scale);
+    const __m128 b = _mm_set1_ps(offset);
+    for (; i + 4 <= count; i += 4)
+    {
+        // NaN takes the first entry, max returns its second operand
+        __m128 x = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(values + i), a), b);
+        __m128i index = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(x, zero), last));
+#ifdef __AVX2__
+        _mm_storeu_si128((__m128i *) (out + i), _mm_i32gather_epi32((const int *) table, index, 4));
+#else
+        int k[4];
+        _mm_storeu_si128((__m128i *) k, index);
+        out[i] = table[k[0]];
+        out[i + 1] = table[k[1]];
+        out[i + 2] = table[k[2]];
+        out[i + 3] = table[k[3]];
+#endif
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float x = values[i] * scale + offset;
+        out[i] = table[std::lrint(std::min(top, std::max(0.0f, x)))];
+    }
+}
+
+ColorRamp::ColorRamp(int size, ColorMode mode)
+    : mode(mode)
+{
+    if (size < 2)
+        throw "ColorRamp(): size must be at least 2";
+    table.resize(size);
+    build();
+}
+
+ColorRamp::ColorRamp(color from, color to, int size, ColorMode mode)
+    : ColorRamp(size, mode)
+{
+    addStop(0, from);
+    addStop(1, to);
+}
+
+void ColorRamp::addStop(float position, color c)
+{
+    // A stop at the position of another comes after it, for a hard edge
+    Stop stop = { std::min(std::max(position, 0.0f), 1.0f), c.argb() };
+    std::vector<Stop>::iterator it = stops.begin();
+    while (it != stops.end() && it->position <= stop.position)
+        ++it;
+    stops.insert(it, stop);
+    build();
+}
+
+void ColorRamp::clearStops()
+{
+    stops.clear();
+    build();
+}
+
+color ColorRamp::get(float amt) const
+{
+    float top = (float) (table.size() - 1);
+    return color::fromARGB(table[std::lrint(std::min(top, std::max(0.0f, amt * top)))]);
+}
+
+void ColorRamp::map(const float *values, int count, unsigned int *out, float low, float high) const
+{
+    if (low == high)
+        throw "map(): low and high are the same";
+
+    float top = (float) (table.size() - 1);
+    float scale = top / (high - low);
+    float offset = -low * scale;
+    const unsigned int *entries = table.data();
+    parallelFor(count, P_PARALLEL_GRAIN, [=](int begin, int end) {
+        lookup(entries, top, scale, offset, values + begin, out + begin, end - begin);
+    });
+}
+
+void ColorRamp::build()
+{
+    if (stops.empty())
+    {
+        std::fill(table.begin(), table.end(), 0u);
+        return;
+    }
+
+    ColorSpace hsb;
+    hsb.setMode(HSB, 6, 1, 255, 255);
+    int n = (int) table.size();
+    size_t k = 0;
+    for (int i = 0; i < n; i++)
+    {
+        float t = (float) i / (n - 1);
+        while (k < stops.size() && stops[k].position <= t)
+            k++;
+        if (k == 0 || k == stops.size())
+        {
+            table[i] = stops[k ? k - 1 : 0].argb;
+            continue;
+        }
+
+        const Stop &s0 = stops[k - 1];
+        const Stop &s1 = stops[k];
+        float amt = (t - s0.position) / (s1.position - s0.position);
+        float a0 = s0.argb >> 24;
+        float alpha = a0 + ((s1.argb >> 24) - a0) * amt;
+        if (mode == HSB)
+        {
+            float c0[3], c1[3];
+            toHSB(s0.argb, c0);
+            toHSB(s1.argb, c1);
+            // A grey has no hue of its own and black no saturation either,
+            // they take the other end's
+            if (c0[1] == 0)
+                c0[0] = c1[0];
+            if (c1[1] == 0)
+                c1[0] = c0[0];
+            if (c0[2] == 0)
+                c0[1] = c1[1];
+            if (c1[2] == 0)
+                c1[1] = c0[1];
+            float turn = c1[0] - c0[0];
+            turn += (turn > 3 ? -6 : (turn < -3 ? 6 : 0));
+            float h = c0[0] + turn * amt;
+            h += (h < 0 ? 6 : (h >= 6 ? -6 : 0));
+            table[i] = hsb.toARGB(h, c0[1] + (c1[1] - c0[1]) * amt, c0[2] + (c1[2] - c0[2]) * amt, alpha);
+        }
+        else
+        {
+            unsigned int argb = (unsigned int) std::lrint(alpha) << 24;
+            for (int shift = 0; shift < 24; shift += 8)
+            {
+                float v0 = (s0.argb >> shift) & 0xFF;
+                float v1 = (s1.argb >> shift) & 0xFF;
+                argb |= (unsigned int) std::lrint(v0 + (v1 - v0) * amt) << shift;
+            }
+            table[i] = argb;
+        }
+    }
+}
+
+PROCESSING_END_NAMESPACE
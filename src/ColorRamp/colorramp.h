@@ -0,0 +1,60 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef COLORRAMP_H
+#define COLORRAMP_H
+
+#include "pglobal.h"
+#include <vector>
+
+#define P_COLOR_RAMP_SIZE 256
+
+PROCESSING_BEGIN_NAMESPACE
+
+class color;
+
+/**
+ * A gradient through color stops, sampled once into a table of packed
+ * ARGB colors. Mapping a value is then a table lookup, so a whole field of
+ * values, a heatmap or a noise field, goes into pixels[] at memory speed.
+ *
+ * Stops are at positions from 0 to 1 and are blended in RGB, or in HSB
+ * around the shorter way of the hue circle. 256 entries are enough for
+ * 8-bit steps, 4096 keep long smooth ramps free of banding.
+ */
+class ColorRamp
+{
+public:
+    explicit ColorRamp(int size=P_COLOR_RAMP_SIZE, ColorMode mode=RGB);
+    ColorRamp(color from, color to, int size=P_COLOR_RAMP_SIZE, ColorMode mode=RGB);
+
+    void addStop(float position, color c);
+    void clearStops();
+
+    int size() const { return (int) table.size(); }
+    ColorMode getMode() const { return mode; }
+    const unsigned int * data() const { return table.data(); }
+
+    color get(float amt) const;
+
+    // Values from low to high go from the first entry to the last, the
+    // rest are clamped. Large arrays are split across threads.
+    void map(const float *values, int count, unsigned int *out, float low=0, float high=1) const;
+
+private:
+    struct Stop
+    {
+        float position;
+        unsigned int argb;
+    };
+
+    void build();
+
+    ColorMode mode;
+    std::vector<Stop> stops;
+    std::vector<unsigned int> table;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // COLORRAMP_H
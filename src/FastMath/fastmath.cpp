@@ -0,0 +1,212 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "fastmath.h"
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+PROCESSING_BEGIN_NAMESPACE
+
+// A quarter turn in three parts, the first two exact in a float, so the
+// angle loses little when the quarter turns are taken out of it
+#define P_TRIG_QUARTER_1 1.5703125f
+#define P_TRIG_QUARTER_2 4.837512969970703125e-4f
+#define P_TRIG_QUARTER_3 7.54978995489188216e-8f
+#define P_TRIG_TWO_OVER_PI 0.636619772367581343f
+
+// Minimax polynomials on a quarter turn around 0, from Cephes
+static inline float sinPoly(float r, float z)
+{
+    return ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+}
+
+static inline float cosPoly(float z)
+{
+    return ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z
+         - 0.5f * z + 1.0f;
+}
+
+// Minimax polynomial for atan() on 0 to 1
+static inline float atanPoly(float a)
+{
+    float s = a * a;
+    return a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s * (-0.11643287f
+         + s * (0.05265332f + s * -0.01172120f)))));
+}
+
+static inline float flipSign(float v, bool negative)
+{
+    return negative ? -v : v;
+}
+
+void fastSinCos(float x, float &s, float &c)
+{
+    // x is q quarter turns and r, the quarter turn tells which polynomial
+    // and sign each one takes
+    int q = (int) std::lrint(x * P_TRIG_TWO_OVER_PI);
+    float qf = (float) q;
+    float r = ((x - qf * P_TRIG_QUARTER_1) - qf * P_TRIG_QUARTER_2) - qf * P_TRIG_QUARTER_3;
+    float z = r * r;
+    float sr = sinPoly(r, z);
+    float cr = cosPoly(z);
+    bool swap = q & 1;
+    s = flipSign(swap ? cr : sr, q & 2);
+    c = flipSign(swap ? sr : cr, (q + 1) & 2);
+}
+
+float fastSin(float x)
+{
+    float s, c;
+    fastSinCos(x, s, c);
+    return s;
+}
+
+float fastCos(float x)
+{
+    float s, c;
+    fastSinCos(x, s, c);
+    return c;
+}
+
+float fastAtan2(float y, float x)
+{
+    float ax = std::fabs(x);
+    float ay = std::fabs(y);
+    float high = std::fmax(ax, ay);
+    float a = (high > 0 ? std::fmin(ax, ay) / high : 0.0f);
+    float r = atanPoly(a);
+    r = (ay > ax ? (float) (M_PI / 2) - r : r);
+    r = (std::signbit(x) ? (float) M_PI - r : r);
+    return std::copysign(r, y);
+}
+
+struct SinTable
+{
+    SinTable()
+    {
+        for (int i = 0; i <= P_SIN_TABLE_SIZE; i++)
+            values[i] = (float) std::sin(2 * M_PI * i / P_SIN_TABLE_SIZE);
+    }
+
+    float lookup(float turns) const
+    {
+        float i = std::floor(turns);
+        float f = turns - i;
+        const float *v = values + ((int) i & (P_SIN_TABLE_SIZE - 1));
+        return v[0] + f * (v[1] - v[0]);
+    }
+
+    float values[P_SIN_TABLE_SIZE + 1];
+};
+
+static const SinTable & sinTable()
+{
+    static const SinTable table;
+    return table;
+}
+
+float tableSin(float x)
+{
+    return sinTable().lookup(x * (float) (P_SIN_TABLE_SIZE / (2 * M_PI)));
+}
+
+float tableCos(float x)
+{
+    return sinTable().lookup(x * (float) (P_SIN_TABLE_SIZE / (2 * M_PI)) + P_SIN_TABLE_SIZE / 4);
+}
+
+#ifdef __SSE2__
+static inline void sinCos4(__m128 x, __m128 &s, __m128 &c)
+{
+    __m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(P_TRIG_TWO_OVER_PI)));
+    __m128 qf = _mm_cvtepi32_ps(q);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(qf, _mm_set1_ps(P_TRIG_QUARTER_1)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(P_TRIG_QUARTER_2)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(P_TRIG_QUARTER_3)));
+    __m128 z = _mm_mul_ps(r, r);
+
+    __m128 sr = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(-1.9515295891e-4f)), _mm_set1_ps(8.3321608736e-3f));
+    sr = _mm_sub_ps(_mm_mul_ps(sr, z), _mm_set1_ps(1.6666654611e-1f));
+    sr = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sr, z), r), r);
+
+    __m128 cr = _mm_sub_ps(_mm_mul_ps(z, _mm_set1_ps(2.443315711809948e-5f)), _mm_set1_ps(1.388731625493765e-3f));
+    cr = _mm_add_ps(_mm_mul_ps(cr, z), _mm_set1_ps(4.166664568298827e-2f));
+    cr = _mm_mul_ps(_mm_mul_ps(cr, z), z);
+    cr = _mm_add_ps(_mm_sub_ps(cr, _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_set1_ps(1.0f));
+
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30));
+    s = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cr), _mm_andnot_ps(swap, sr)), sinSign);
+    c = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sr), _mm_andnot_ps(swap, cr)), cosSign);
+}
+#endif
+
+void fastSin(const float *x, float *out, int count)
+{
+    int i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 s, c;
+        sinCos4(_mm_loadu_ps(x + i), s, c);
+        _mm_storeu_ps(out + i, s);
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = fastSin(x[i]);
+}
+
+void fastCos(const float *x, float *out, int count)
+{
+    int i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 s, c;
+        sinCos4(_mm_loadu_ps(x + i), s, c);
+        _mm_storeu_ps(out + i, c);
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = fastCos(x[i]);
+}
+
+void fastAtan2(const float *y, const float *x, float *out, int count)
+{
+    int i = 0;
+#ifdef __SSE2__
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 ax = _mm_andnot_ps(signBit, vx);
+        __m128 ay = _mm_andnot_ps(signBit, vy);
+        __m128 high = _mm_max_ps(ax, ay);
+        __m128 a = _mm_and_ps(_mm_div_ps(_mm_min_ps(ax, ay), high), _mm_cmpgt_ps(high, _mm_setzero_ps()));
+
+        __m128 s = _mm_mul_ps(a, a);
+        __m128 r = _mm_add_ps(_mm_set1_ps(0.05265332f), _mm_mul_ps(s, _mm_set1_ps(-0.01172120f)));
+        r = _mm_add_ps(_mm_set1_ps(-0.11643287f), _mm_mul_ps(s, r));
+        r = _mm_add_ps(_mm_set1_ps(0.19354346f), _mm_mul_ps(s, r));
+        r = _mm_add_ps(_mm_set1_ps(-0.33262347f), _mm_mul_ps(s, r));
+        r = _mm_add_ps(_mm_set1_ps(0.99997726f), _mm_mul_ps(s, r));
+        r = _mm_mul_ps(a, r);
+
+        __m128 steep = _mm_cmpgt_ps(ay, ax);
+        r = _mm_or_ps(_mm_and_ps(steep, _mm_sub_ps(_mm_set1_ps((float) (M_PI / 2)), r)), _mm_andnot_ps(steep, r));
+        __m128 behind = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(vx), 31));
+        r = _mm_or_ps(_mm_and_ps(behind, _mm_sub_ps(_mm_set1_ps((float) M_PI), r)), _mm_andnot_ps(behind, r));
+        _mm_storeu_ps(out + i, _mm_or_ps(r, _mm_and_ps(vy, signBit)));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = fastAtan2(y[i], x[i]);
+}
+
+PROCESSING_END_NAMESPACE
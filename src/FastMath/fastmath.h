@@ -0,0 +1,41 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+#include "pglobal.h"
+
+// Entries in one turn of the sine table
+#define P_SIN_TABLE_SIZE 4096
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * Approximate trigonometry for sketches that call it millions of times a
+ * frame. Nothing here branches on the input, so the array forms run four
+ * values at a time with SSE and give what the single value forms give.
+ *
+ * fastSin() and fastCos() reduce the angle to a quarter turn and evaluate
+ * a polynomial: within 1e-7 of sin() and cos() while |x| < 10000 and 1e-6
+ * while |x| < 100000. Past that the reduction fails and the result is
+ * meaningless. tableSin() and tableCos() interpolate a table of
+ * P_SIN_TABLE_SIZE entries and are within 1e-6 while |x| < 10. Beyond
+ * that the float table index loses bits and the error grows with |x|,
+ * staying within 1.5e-7 |x|: 1.5e-5 at 100, 1.3e-5 measured.
+ * fastAtan2() is within 2e-6 radians of atan2() everywhere.
+ */
+float fastSin(float x);
+float fastCos(float x);
+void fastSinCos(float x, float &s, float &c);
+float fastAtan2(float y, float x);
+float tableSin(float x);
+float tableCos(float x);
+
+void fastSin(const float *x, float *out, int count);
+void fastCos(const float *x, float *out, int count);
+void fastAtan2(const float *y, const float *x, float *out, int count);
+
+PROCESSING_END_NAMESPACE
+
+#endif // FASTMATH_H
@@ -4,9 +4,11 @@
 #include "canvas.h"
 #include "pelement.h"
 #include <iostream>
+#include <chrono>
 
 PROCESSING_BEGIN_NAMESPACE
 
+extern int frameRate;
 int frameCount;
 
 bool isMousePressed;
@@ -23,7 +25,8 @@ Canvas::Canvas()
     : m_mouseX(0), m_mouseY(0),
       mouseState(S_MOUSE_NONE),
       mouseStateNext(S_MOUSE_NONE),
-      keyState(S_KEY_NONE)
+      keyState(S_KEY_NONE),
+      presenting(true)
 {
     frameCount = 0;
 }
@@ -87,6 +90,11 @@ void Canvas::animate()
     // Clear the queue
     clearAllElements();
 
+    // Every frame starts from the identity
+    matrix.reset();
+    matrix_stack.clear();
+    matrixChanged();
+
     // Create mouse event for the client
     pmouseX = mouseX;
     pmouseY = mouseY;
@@ -101,11 +109,40 @@ void Canvas::animate()
     mouseState = mouseStateNext;
 
     // The client creates draw elements and add to the queue
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
     if (callbacks["draw"])
         callbacks["draw"]();
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
 
     keyState = S_KEY_NONE;
     frameCount++;
+
+    // Presentation of the previous frame counts against this frame's budget
+    governor.setBudget(frameRate > 0 ? 1000.0f / frameRate : 0);
+    Quality level = governor.update(elapsed.count() + stats.presentTime);
+    if (level != stats.quality)
+        applyQuality(level);
+
+    // Only every other frame is presented at the lowest quality level
+    presenting = (level < QUALITY_SKIP_FRAMES || (frameCount & 1) == 0);
+    if (!presenting)
+        stats.skippedFrames++;
+
+    stats.frameCount = frameCount;
+    stats.frameBudget = governor.getBudget();
+    stats.drawTime = elapsed.count();
+    stats.averageFrameTime = governor.averageFrameTime();
+    stats.quality = level;
+}
+
+void Canvas::adaptiveQuality(bool enable)
+{
+    governor.setEnabled(enable);
+    if (governor.quality() != stats.quality)
+    {
+        applyQuality(governor.quality());
+        stats.quality = governor.quality();
+    }
 }
 
 void Canvas::pushStyle()
@@ -163,6 +200,31 @@ void Canvas::triangle(float x1, float y1, float x2, float y2, float x3, float y3
     draw_queue.push_back(new PTriangle(x1, y1, x2, y2, x3, y3));
 }
 
+void Canvas::shape(const PShape &s, float x, float y)
+{
+    pushMatrix();
+    translate(x, y);
+    if (!s.getMatrix().isIdentity())
+        applyMatrix(s.getMatrix());
+    drawShape(s);
+    popMatrix();
+}
+
+void Canvas::shape(const PShape &s, float a, float b, float c, float d)
+{
+    // Stretched from the corner to the given size
+    pushMatrix();
+    translate(a, b);
+    float w = s.getWidth();
+    float h = s.getHeight();
+    if (w > 0 && h > 0)
+        scale(c / w, d / h);
+    if (!s.getMatrix().isIdentity())
+        applyMatrix(s.getMatrix());
+    drawShape(s);
+    popMatrix();
+}
+
 void Canvas::colorMode(ColorMode mode)
 {
     (void) mode;
@@ -177,6 +239,12 @@ void Canvas::colorMode(ColorMode mode, float max1, float max2, float max3, float
     (void) maxA;
 }
 
+const ColorSpace & Canvas::colorSpace() const
+{
+    static const ColorSpace rgb;
+    return rgb;
+}
+
 void Canvas::background(int rgb)
 {
     background(rgb, rgb, rgb);
@@ -217,6 +285,22 @@ void Canvas::noStroke()
     draw_queue.push_back(new PNoStroke);
 }
 
+// The queue has no color mode of its own, the channels are RGB already
+void Canvas::backgroundARGB(unsigned int argb)
+{
+    background((argb >> 16) & 0xFF, (argb >> 8) & 0xFF, argb & 0xFF, argb >> 24);
+}
+
+void Canvas::fillARGB(unsigned int argb)
+{
+    fill((argb >> 16) & 0xFF, (argb >> 8) & 0xFF, argb & 0xFF, argb >> 24);
+}
+
+void Canvas::strokeARGB(unsigned int argb)
+{
+    stroke((argb >> 16) & 0xFF, (argb >> 8) & 0xFF, argb & 0xFF, argb >> 24);
+}
+
 void Canvas::ellipseMode(DrawMode mode)
 {
     draw_queue.push_back(new PEllipseMode(mode));
@@ -232,14 +316,50 @@ void Canvas::strokeWeight(int weight)
     draw_queue.push_back(new PStrokeWeight(weight));
 }
 
+void Canvas::pushMatrix()
+{
+    matrix_stack.push_back(matrix);
+}
+
+void Canvas::popMatrix()
+{
+    if (matrix_stack.empty())
+        throw "popMatrix() is called more times than pushMatrix()";
+    matrix = matrix_stack.back();
+    matrix_stack.pop_back();
+    matrixChanged();
+}
+
+void Canvas::resetMatrix()
+{
+    matrix.reset();
+    matrixChanged();
+}
+
+void Canvas::applyMatrix(const PMatrix2D &m)
+{
+    matrix.apply(m);
+    matrixChanged();
+}
+
+// Transforms are kept in the matrix instead of being queued, so recorded
+// geometry can be mapped to device space in one pass
 void Canvas::rotate(float angle)
 {
-    draw_queue.push_back(new PRotate(angle));
+    matrix.rotate(angle);
+    matrixChanged();
+}
+
+void Canvas::scale(float x, float y)
+{
+    matrix.scale(x, y);
+    matrixChanged();
 }
 
 void Canvas::translate(float x, float y)
 {
-    draw_queue.push_back(new PTranslate(x, y));
+    matrix.translate(x, y);
+    matrixChanged();
 }
 
 PROCESSING_END_NAMESPACE
@@ -5,7 +5,15 @@
 #define PCANVAS_H
 
 #include "pglobal.h"
+#include "pstats.h"
+#include "governor.h"
+#include "colorspace.h"
+#include "pmatrix.h"
+#include "pshape.h"
+#include "pfont.h"
 #include <list>
+#include <string>
+#include <vector>
 
 PROCESSING_BEGIN_NAMESPACE
 
@@ -46,8 +54,33 @@ public:
     virtual void rect(float a, float b, float c, float d, float tl, float tr, float br, float bl);
     virtual void triangle(float x1, float y1, float x2, float y2, float x3, float y3);
 
+    virtual void box(float w, float h, float d) { (void) w; (void) h; (void) d; }
+    virtual void sphere(float r) { (void) r; }
+    virtual void sphereDetail(int res) { (void) res; }
+    virtual void beginShape(ShapeKind kind=POLYGON) { (void) kind; }
+    virtual void vertex(float x, float y) { vertex(x, y, 0); }
+    virtual void vertex(float x, float y, float z) { (void) x; (void) y; (void) z; }
+    virtual void endShape(EndMode mode=END_OPEN) { (void) mode; }
+    virtual void bezier(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4)
+    {
+        (void) x1; (void) y1; (void) x2; (void) y2; (void) x3; (void) y3; (void) x4; (void) y4;
+    }
+    virtual void bezierVertex(float x2, float y2, float x3, float y3, float x4, float y4)
+    {
+        (void) x2; (void) y2; (void) x3; (void) y3; (void) x4; (void) y4;
+    }
+    virtual void curve(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4)
+    {
+        (void) x1; (void) y1; (void) x2; (void) y2; (void) x3; (void) y3; (void) x4; (void) y4;
+    }
+    virtual void curveVertex(float x, float y) { (void) x; (void) y; }
+    virtual void curveTightness(float tightness) { (void) tightness; }
+    virtual void shape(const PShape &s, float x, float y);
+    virtual void shape(const PShape &s, float a, float b, float c, float d);
+
     virtual void colorMode(ColorMode mode);
     virtual void colorMode(ColorMode mode, float max1, float max2, float max3, float maxA);
+    virtual const ColorSpace & colorSpace() const;
     virtual void background(int rgb);
     virtual void background(int v1, int v2, int v3, int alpha=255);
     virtual void fill(int gray, int alpha=255);
@@ -56,19 +89,81 @@ public:
     virtual void stroke(int gray, int alpha=255);
     virtual void stroke(int v1, int v2, int v3, int alpha=255);
     virtual void noStroke();
+    // Packed 0xAARRGGBB, whatever the color mode is
+    virtual void backgroundARGB(unsigned int argb);
+    virtual void fillARGB(unsigned int argb);
+    virtual void strokeARGB(unsigned int argb);
  
     virtual void ellipseMode(DrawMode mode);
     virtual void rectMode(DrawMode mode);
     virtual void strokeWeight(int weight);
+    virtual void clip(float a, float b, float c, float d) { (void) a; (void) b; (void) c; (void) d; }
+    virtual void noClip() {}
+
+    virtual void text(const std::string &str, float x, float y) { (void) str; (void) x; (void) y; }
+    virtual void textFont(const PFont &font, float size) { (void) font; (void) size; }
+    virtual void textSize(float size) { (void) size; }
+    virtual float textWidth(const std::string &str) { (void) str; return 0; }
  
+    virtual void pushMatrix();
+    virtual void popMatrix();
+    virtual void resetMatrix();
+    virtual void applyMatrix(const PMatrix2D &m);
+    virtual void applyMatrix(const PMatrix3D &m) { (void) m; }
     virtual void rotate(float angle);
+    virtual void scale(float x, float y);
+    virtual void scale(float x, float y, float z) { (void) z; scale(x, y); }
     virtual void translate(float x, float y);
+    virtual void translate(float x, float y, float z) { (void) x; (void) y; (void) z; }
+    virtual void rotateX(float angle) { (void) angle; }
+    virtual void rotateY(float angle) { (void) angle; }
+    virtual void rotateZ(float angle) { rotate(angle); }
+    virtual float screenX(float x, float y, float z=0) const { (void) z; return matrix.multX(x, y); }
+    virtual float screenY(float x, float y, float z=0) const { (void) z; return matrix.multY(x, y); }
+    virtual float screenZ(float x, float y, float z) const { (void) x; (void) y; (void) z; return 0; }
+    const PMatrix2D & getMatrix() const { return matrix; }
+
+    virtual void lights() {}
+    virtual void noLights() {}
+    virtual void camera() {}
+    virtual void camera(float eyeX, float eyeY, float eyeZ, float centerX, float centerY, float centerZ,
+            float upX, float upY, float upZ)
+    {
+        (void) eyeX; (void) eyeY; (void) eyeZ;
+        (void) centerX; (void) centerY; (void) centerZ;
+        (void) upX; (void) upY; (void) upZ;
+    }
+    virtual void perspective() {}
+    virtual void perspective(float fovy, float aspect, float zNear, float zFar)
+    {
+        (void) fovy; (void) aspect; (void) zNear; (void) zFar;
+    }
+    virtual void ortho() {}
+    virtual void ortho(float left, float right, float bottom, float top, float zNear, float zFar)
+    {
+        (void) left; (void) right; (void) bottom; (void) top; (void) zNear; (void) zFar;
+    }
+
+    virtual void pixelDensity(int density) { (void) density; }
+    virtual int displayDensity() const { return 1; }
+    virtual void renderScale(float scale) { (void) scale; }
+    virtual void smooth(int level) { (void) level; }
+    virtual void noSmooth() {}
+
+    virtual unsigned int * loadPixels() { return 0; }
+    virtual void updatePixels() {}
+    virtual void saveFrame(const char *filename) { (void) filename; }
 
     virtual void setFixedSize(int width, int height) = 0;
+    virtual void setResizable(bool resizable) { (void) resizable; }
     virtual bool hasParent() const { return true; } // default is Window
     virtual void animate();
     void registerCallbacks(PFunctions &cbs) { callbacks = cbs; }
 
+    void adaptiveQuality(bool enable);
+    Quality quality() const { return governor.quality(); }
+    const PStats & getStats() const { return stats; }
+
     const std::list<PElement *> & getDrawQueue() const { return draw_queue; }
     void setAllElementsPersistent();
     void copyAllElementsFrom(const Canvas &);
@@ -78,6 +173,11 @@ protected:
     Canvas();
     Canvas & operator=(const Canvas &);
 
+    virtual void applyQuality(Quality level) { (void) level; }
+    virtual void matrixChanged() {}
+    virtual void drawShape(const PShape &s) { (void) s; }
+    bool isPresenting() const { return presenting; }
+
     int m_mouseX;
     int m_mouseY;
     MouseState mouseState;
@@ -85,6 +185,11 @@ protected:
     KeyState keyState;
     std::list<PElement *> draw_queue;
     PFunctions callbacks;
+    PMatrix2D matrix;
+    std::vector<PMatrix2D> matrix_stack;
+    QualityGovernor governor;
+    PStats stats;
+    bool presenting;
 };
 
 PROCESSING_END_NAMESPACE
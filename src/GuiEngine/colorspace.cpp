@@ -0,0 +1,156 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "colorspace.h"
+#include <algorithm>
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+PROCESSING_BEGIN_NAMESPACE
+
+// One channel of a hue: full brightness within a sixth of the circle on
+// either side of n, ramping down to the grey level over the next sixth
+static inline float hueChannel(float n, float h, float s, float v)
+{
+    float k = n + h;
+    k -= (k >= 6 ? 6 : 0);
+    float t = std::min(std::max(std::min(k, 4 - k), 0.0f), 1.0f);
+    return v - v * s * t;
+}
+
+static inline unsigned int pack(float r, float g, float b, float a)
+{
+    return (unsigned int) std::lrint(a) << 24 | (unsigned int) std::lrint(r) << 16
+         | (unsigned int) std::lrint(g) << 8 | (unsigned int) std::lrint(b);
+}
+
+#ifdef __SSE2__
+static inline __m128 hueChannel4(float n, __m128 h, __m128 s, __m128 v)
+{
+    const __m128 six = _mm_set1_ps(6);
+    __m128 k = _mm_add_ps(_mm_set1_ps(n), h);
+    k = _mm_sub_ps(k, _mm_and_ps(_mm_cmpge_ps(k, six), six));
+    __m128 t = _mm_min_ps(k, _mm_sub_ps(_mm_set1_ps(4), k));
+    t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(1));
+    return _mm_sub_ps(v, _mm_mul_ps(_mm_mul_ps(v, s), t));
+}
+
+static inline __m128i pack4(__m128 r, __m128 g, __m128 b, __m128 a)
+{
+    __m128i argb = _mm_slli_epi32(_mm_cvtps_epi32(a), 24);
+    argb = _mm_or_si128(argb, _mm_slli_epi32(_mm_cvtps_epi32(r), 16));
+    argb = _mm_or_si128(argb, _mm_slli_epi32(_mm_cvtps_epi32(g), 8));
+    return _mm_or_si128(argb, _mm_cvtps_epi32(b));
+}
+#endif
+
+ColorSpace::ColorSpace()
+{
+    setMode(RGB, 255, 255, 255, 255);
+}
+
+void ColorSpace::setMode(ColorMode mode)
+{
+    setMode(mode, max[0], max[1], max[2], max[3]);
+}
+
+void ColorSpace::setMode(ColorMode mode, float max1, float max2, float max3, float maxA)
+{
+    colorMode = mode;
+    max[0] = max1;
+    max[1] = max2;
+    max[2] = max3;
+    max[3] = maxA;
+    for (int i = 0; i < 4; i++)
+        unit[i] = 255 / max[i];
+    if (mode == HSB)
+    {
+        unit[0] = 6 / max1;
+        unit[1] = 1 / max2;
+    }
+}
+
+unsigned int ColorSpace::toARGB(float v1, float v2, float v3, float alpha) const
+{
+    float c1 = std::min(std::max(v1, 0.0f), max[0]) * unit[0];
+    float c2 = std::min(std::max(v2, 0.0f), max[1]) * unit[1];
+    float c3 = std::min(std::max(v3, 0.0f), max[2]) * unit[2];
+    float a = std::min(std::max(alpha, 0.0f), max[3]) * unit[3];
+    if (colorMode == HSB)
+        return pack(hueChannel(5, c1, c2, c3), hueChannel(3, c1, c2, c3), hueChannel(1, c1, c2, c3), a);
+    return pack(c1, c2, c3, a);
+}
+
+void ColorSpace::toARGB(const float *values, int channels, int count, unsigned int *out) const
+{
+    int i = 0;
+#ifdef __SSE2__
+    const __m128 zero = _mm_setzero_ps();
+    __m128 maxs[4], units[4];
+    for (int c = 0; c < 4; c++)
+    {
+        maxs[c] = _mm_set1_ps(max[c]);
+        units[c] = _mm_set1_ps(unit[c]);
+    }
+    for (; i + 4 <= count; i += 4)
+    {
+        const float *v = values + i * channels;
+        __m128 ch[4];
+        if (channels == 4)
+        {
+            ch[0] = _mm_loadu_ps(v);
+            ch[1] = _mm_loadu_ps(v + 4);
+            ch[2] = _mm_loadu_ps(v + 8);
+            ch[3] = _mm_loadu_ps(v + 12);
+            _MM_TRANSPOSE4_PS(ch[0], ch[1], ch[2], ch[3]);
+        }
+        else
+        {
+            for (int c = 0; c < 3; c++)
+                ch[c] = _mm_set_ps(v[9 + c], v[6 + c], v[3 + c], v[c]);
+            ch[3] = maxs[3];
+        }
+        for (int c = 0; c < 4; c++)
+            ch[c] = _mm_mul_ps(_mm_min_ps(_mm_max_ps(ch[c], zero), maxs[c]), units[c]);
+
+        __m128i argb;
+        if (colorMode == HSB)
+            argb = pack4(hueChannel4(5, ch[0], ch[1], ch[2]), hueChannel4(3, ch[0], ch[1], ch[2]),
+                         hueChannel4(1, ch[0], ch[1], ch[2]), ch[3]);
+        else
+            argb = pack4(ch[0], ch[1], ch[2], ch[3]);
+        _mm_storeu_si128((__m128i *) (out + i), argb);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        const float *v = values + i * channels;
+        out[i] = toARGB(v[0], v[1], v[2], channels == 4 ? v[3] : max[3]);
+    }
+}
+
+void ColorSpace::toHSB(unsigned int argb, float *hsb) const
+{
+    float r = (argb >> 16) & 0xFF;
+    float g = (argb >> 8) & 0xFF;
+    float b = argb & 0xFF;
+    float hi = std::max(std::max(r, g), b);
+    float delta = hi - std::min(std::min(r, g), b);
+    float h = 0;
+    if (delta > 0)
+    {
+        if (hi == r)
+            h = (g - b) / delta + (g < b ? 6 : 0);
+        else if (hi == g)
+            h = (b - r) / delta + 2;
+        else
+            h = (r - g) / delta + 4;
+    }
+    hsb[0] = h / 6 * max[0];
+    hsb[1] = (hi > 0 ? delta / hi : 0) * max[1];
+    hsb[2] = hi / 255 * max[2];
+}
+
+PROCESSING_END_NAMESPACE
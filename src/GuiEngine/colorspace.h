@@ -0,0 +1,49 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef P_COLORSPACE_H
+#define P_COLORSPACE_H
+
+#include "pglobal.h"
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * The colorMode() a sketch gives its colors in, turned into packed
+ * 0xAARRGGBB. The ranges are inverted once when the mode is set, so a
+ * color costs a few multiplies and no divisions, and hue goes to RGB
+ * without branches. Arrays are converted four colors at a time with SSE.
+ *
+ * Values are clamped to their range. Hue is a fraction of the circle, as
+ * in Processing, so colorMode(HSB, 360, 100, 100) takes degrees.
+ */
+class ColorSpace
+{
+public:
+    ColorSpace();
+
+    void setMode(ColorMode mode);
+    void setMode(ColorMode mode, float max1, float max2, float max3, float maxA);
+    ColorMode mode() const { return colorMode; }
+
+    unsigned int toARGB(float v1, float v2, float v3, float alpha) const;
+
+    // Values are channel triples, or quadruples with alpha last
+    void toARGB(const float *values, int channels, int count, unsigned int *out) const;
+
+    // The other way, hue, saturation and brightness scaled to the first
+    // three ranges whatever the mode is, as Processing does
+    void toHSB(unsigned int argb, float *hsb) const;
+
+private:
+    ColorMode colorMode;
+    float max[4];
+
+    // What one unit of each channel is worth: 255 / max for RGB and alpha,
+    // sixths of the circle for hue, 1 / max for saturation
+    float unit[4];
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // P_COLORSPACE_H
@@ -0,0 +1,64 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "governor.h"
+
+PROCESSING_BEGIN_NAMESPACE
+
+// Weight of the newest frame in the moving average
+static const float SMOOTHING = 0.1f;
+
+// Consecutive frames needed before changing the level. Restoring is slower
+// and needs a wider margin, otherwise the levels oscillate.
+static const int DEGRADE_FRAMES = 10;
+static const int RESTORE_FRAMES = 60;
+static const float RESTORE_RATIO = 0.6f;
+
+QualityGovernor::QualityGovernor()
+    : enabled(false), budget(0), average(0),
+      overruns(0), headroom(0), level(QUALITY_FULL)
+{
+}
+
+void QualityGovernor::setEnabled(bool enabled_)
+{
+    enabled = enabled_;
+    overruns = 0;
+    headroom = 0;
+    if (!enabled)
+        level = QUALITY_FULL;
+}
+
+Quality QualityGovernor::update(float frameTime)
+{
+    average = (average ? average + SMOOTHING * (frameTime - average) : frameTime);
+    if (!enabled || budget <= 0)
+        return level;
+
+    if (average > budget)
+    {
+        headroom = 0;
+        if (++overruns >= DEGRADE_FRAMES && level < QUALITY_SKIP_FRAMES)
+        {
+            level = (Quality) (level + 1);
+            overruns = 0;
+        }
+    }
+    else if (average < budget * RESTORE_RATIO)
+    {
+        overruns = 0;
+        if (++headroom >= RESTORE_FRAMES && level > QUALITY_FULL)
+        {
+            level = (Quality) (level - 1);
+            headroom = 0;
+        }
+    }
+    else
+    {
+        overruns = 0;
+        headroom = 0;
+    }
+    return level;
+}
+
+PROCESSING_END_NAMESPACE
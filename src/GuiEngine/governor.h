@@ -0,0 +1,40 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef P_GOVERNOR_H
+#define P_GOVERNOR_H
+
+#include "pglobal.h"
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * Tracks frame time against the frame budget and steps the rendering
+ * quality down while frames overrun, back up once there is headroom.
+ */
+class QualityGovernor
+{
+public:
+    QualityGovernor();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+    void setBudget(float ms) { budget = ms; }
+    float getBudget() const { return budget; }
+
+    Quality update(float frameTime);
+    Quality quality() const { return level; }
+    float averageFrameTime() const { return average; }
+
+private:
+    bool enabled;
+    float budget;
+    float average;
+    int overruns;
+    int headroom;
+    Quality level;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // P_GOVERNOR_H
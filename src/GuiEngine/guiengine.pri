@@ -3,7 +3,13 @@ HEADERS += $$PWD/guiengine.h
 HEADERS += $$PWD/window.h
 HEADERS += $$PWD/canvas.h
 HEADERS += $$PWD/pelement.h
+HEADERS += $$PWD/governor.h
+HEADERS += $$PWD/tessellator.h
+HEADERS += $$PWD/colorspace.h
 SOURCES += $$PWD/guiengine.cpp
 SOURCES += $$PWD/window.cpp
 SOURCES += $$PWD/canvas.cpp
 SOURCES += $$PWD/pelement.cpp
+SOURCES += $$PWD/governor.cpp
+SOURCES += $$PWD/tessellator.cpp
+SOURCES += $$PWD/colorspace.cpp
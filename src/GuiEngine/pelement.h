@@ -32,9 +32,7 @@ public:
         NoStroke,
         EllipseMode,
         RectMode,
-        StrokeWeight,
-        Rotate,
-        Translate
+        StrokeWeight
     };
 
 public:
@@ -342,35 +340,6 @@ private:
     int m_weight;
 };
 
-class PRotate : public PElement
-{
-public:
-    PRotate(float angle)
-        : m_angle(angle) {}
-
-    PElement::PElementType type() const { return PElement::Rotate; }
-    PElement * clone() const { return new PRotate(m_angle); }
-    float angle() const { return m_angle; }
-
-private:
-    float m_angle;
-};
-
-class PTranslate : public PElement
-{
-public:
-    PTranslate(float x, float y)
-        : m_x(x), m_y(y) {}
-
-    PElement::PElementType type() const { return PElement::Translate; }
-    PElement * clone() const { return new PTranslate(m_x, m_y); }
-    float x() const { return m_x; }
-    float y() const { return m_y; }
-
-private:
-    float m_x, m_y;
-};
-
 PROCESSING_END_NAMESPACE
 
 #endif // P_PELEMENT_H
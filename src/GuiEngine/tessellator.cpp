@@ -0,0 +1,458 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "tessellator.h"
+#include <algorithm>
+#include <cmath>
+
+PROCESSING_BEGIN_NAMESPACE
+
+// Largest distance of a tessellated arc from the real curve, in pixels
+#define P_TESSELLATOR_TOLERANCE 0.25f
+
+#define X(k) xy[2 * ring[k]]
+#define Y(k) xy[2 * ring[k] + 1]
+
+static inline float cross(float ax, float ay, float bx, float by, float cx, float cy)
+{
+    return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+static inline void addPoint(std::vector<float> &out, float x, float y)
+{
+    out.push_back(x);
+    out.push_back(y);
+}
+
+static inline void addTriangle(std::vector<float> &out, float ax, float ay, float bx, float by, float cx, float cy)
+{
+    addPoint(out, ax, ay);
+    addPoint(out, bx, by);
+    addPoint(out, cx, cy);
+}
+
+static int circleSegments(float radius)
+{
+    if (radius <= P_TESSELLATOR_TOLERANCE)
+        return 8;
+    int n = (int) std::ceil(M_PI / std::acos(1.0 - P_TESSELLATOR_TOLERANCE / radius));
+    return std::min(std::max(n, 8), 256);
+}
+
+// A fan around (cx, cy) from the offset (vx, vy), turning by sweep
+static void addFan(std::vector<float> &out, float cx, float cy, float vx, float vy, float sweep, int fullCircle)
+{
+    int n = std::max(1, (int) std::ceil(fullCircle * std::fabs(sweep) / (2 * M_PI)));
+    float step = sweep / n;
+    float c = std::cos(step), s = std::sin(step);
+    for (int k = 0; k < n; k++)
+    {
+        float wx = vx * c - vy * s;
+        float wy = vx * s + vy * c;
+        addTriangle(out, cx, cy, cx + vx, cy + vy, cx + wx, cy + wy);
+        vx = wx;
+        vy = wy;
+    }
+}
+
+static bool between(float a, float b, float v)
+{
+    return std::min(a, b) <= v && v <= std::max(a, b);
+}
+
+static bool segmentsTouch(const float *p1, const float *p2, const float *p3, const float *p4)
+{
+    float d1 = cross(p3[0], p3[1], p4[0], p4[1], p1[0], p1[1]);
+    float d2 = cross(p3[0], p3[1], p4[0], p4[1], p2[0], p2[1]);
+    float d3 = cross(p1[0], p1[1], p2[0], p2[1], p3[0], p3[1]);
+    float d4 = cross(p1[0], p1[1], p2[0], p2[1], p4[0], p4[1]);
+    if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0)))
+        return true;
+
+    // An end lying on the other segment
+    if (d1 == 0 && between(p3[0], p4[0], p1[0]) && between(p3[1], p4[1], p1[1]))
+        return true;
+    if (d2 == 0 && between(p3[0], p4[0], p2[0]) && between(p3[1], p4[1], p2[1]))
+        return true;
+    if (d3 == 0 && between(p1[0], p2[0], p3[0]) && between(p1[1], p2[1], p3[1]))
+        return true;
+    if (d4 == 0 && between(p1[0], p2[0], p4[0]) && between(p1[1], p2[1], p4[1]))
+        return true;
+    return false;
+}
+
+Tessellator::Tessellator()
+{
+}
+
+bool Tessellator::isConvex(const float *xy, int count)
+{
+    // Every turn the same way, and the outline goes back and forth at
+    // most once along each axis, which rules out stars
+    int turn = 0, xFlips = 0, yFlips = 0, xSign = 0, ySign = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const float *a = xy + 2 * i;
+        const float *b = xy + 2 * ((i + 1) % count);
+        const float *c = xy + 2 * ((i + 2) % count);
+        float z = cross(a[0], a[1], b[0], b[1], c[0], c[1]);
+        if (z != 0)
+        {
+            int sign = (z > 0 ? 1 : -1);
+            if (turn != 0 && sign != turn)
+                return false;
+            turn = sign;
+        }
+        float dx = b[0] - a[0], dy = b[1] - a[1];
+        if (dx != 0)
+        {
+            int sign = (dx > 0 ? 1 : -1);
+            if (xSign != 0 && sign != xSign)
+                xFlips++;
+            xSign = sign;
+        }
+        if (dy != 0)
+        {
+            int sign = (dy > 0 ? 1 : -1);
+            if (ySign != 0 && sign != ySign)
+                yFlips++;
+            ySign = sign;
+        }
+    }
+    return xFlips <= 2 && yFlips <= 2;
+}
+
+void Tessellator::collectRing(const float *xy, int count)
+{
+    // Repeated points would make zero length edges
+    ring.clear();
+    for (int i = 0; i < count; i++)
+    {
+        if (!ring.empty() && xy[2 * i] == xy[2 * ring.back()] && xy[2 * i + 1] == xy[2 * ring.back() + 1])
+            continue;
+        ring.push_back(i);
+    }
+    if (ring.size() > 1 && X(0) == X(ring.size() - 1) && Y(0) == Y(ring.size() - 1))
+        ring.pop_back();
+}
+
+void Tessellator::fill(const float *xy, int count, std::vector<float> &out)
+{
+    if (count < 3)
+        return;
+    collectRing(xy, count);
+    int m = ring.size();
+    if (m < 3)
+        return;
+    if (isConvex(xy, count))
+    {
+        for (int k = 1; k + 1 < m; k++)
+            addTriangle(out, X(0), Y(0), X(k), Y(k), X(k + 1), Y(k + 1));
+        return;
+    }
+    if (crossesItself(xy))
+    {
+        fillSlabs(xy, out);
+        return;
+    }
+    triangles.clear();
+    clipEars(xy, triangles);
+    for (size_t i = 0; i < triangles.size(); i++)
+        addPoint(out, xy[2 * triangles[i]], xy[2 * triangles[i] + 1]);
+}
+
+bool Tessellator::triangulate(const float *xy, int count, std::vector<int> &out)
+{
+    if (count < 3)
+        return true;
+    collectRing(xy, count);
+    int m = ring.size();
+    if (m < 3)
+        return true;
+    if (isConvex(xy, count))
+    {
+        for (int k = 1; k + 1 < m; k++)
+        {
+            out.push_back(ring[0]);
+            out.push_back(ring[k]);
+            out.push_back(ring[k + 1]);
+        }
+        return true;
+    }
+    if (crossesItself(xy))
+        return false;
+    clipEars(xy, out);
+    return true;
+}
+
+bool Tessellator::crossesItself(const float *xy)
+{
+    // Edges sorted by their top, each only meets the ones starting
+    // before its bottom
+    int m = ring.size();
+    edges.resize(m);
+    for (int e = 0; e < m; e++)
+        edges[e] = e;
+    std::sort(edges.begin(), edges.end(), [&](int a, int b) {
+        return std::min(Y(a), Y((a + 1) % m)) < std::min(Y(b), Y((b + 1) % m));
+    });
+    for (int i = 0; i < m; i++)
+    {
+        int a = edges[i];
+        const float *a0 = xy + 2 * ring[a];
+        const float *a1 = xy + 2 * ring[(a + 1) % m];
+        float bottom = std::max(a0[1], a1[1]);
+        for (int j = i + 1; j < m; j++)
+        {
+            int b = edges[j];
+            const float *b0 = xy + 2 * ring[b];
+            const float *b1 = xy + 2 * ring[(b + 1) % m];
+            if (std::min(b0[1], b1[1]) > bottom)
+                break;
+            if (b == (a + 1) % m || a == (b + 1) % m)
+                continue;
+            if (segmentsTouch(a0, a1, b0, b1))
+                return true;
+        }
+    }
+    return false;
+}
+
+void Tessellator::clipEars(const float *xy, std::vector<int> &out)
+{
+    int m = ring.size();
+    double area = 0;
+    for (int k = 0; k < m; k++)
+        area += (double) X(k) * Y((k + 1) % m) - (double) X((k + 1) % m) * Y(k);
+    if (area == 0)
+        return;
+    float orient = (area > 0 ? 1 : -1);
+
+    prev.resize(m);
+    next.resize(m);
+    for (int k = 0; k < m; k++)
+    {
+        prev[k] = (k + m - 1) % m;
+        next[k] = (k + 1) % m;
+    }
+
+    // An ear turns the same way as the polygon and has no other vertex
+    // inside. Should rounding leave none, the next corner is cut anyway.
+    int remaining = m, i = 0, stalls = 0;
+    while (remaining > 3)
+    {
+        int a = prev[i], c = next[i];
+        float ax = X(a), ay = Y(a), bx = X(i), by = Y(i), cx = X(c), cy = Y(c);
+        bool ear = (cross(ax, ay, bx, by, cx, cy) * orient > 0);
+        for (int v = next[c]; ear && v != a; v = next[v])
+        {
+            float vx = X(v), vy = Y(v);
+            if ((vx == ax && vy == ay) || (vx == bx && vy == by) || (vx == cx && vy == cy))
+                continue;
+            if (cross(ax, ay, bx, by, vx, vy) * orient >= 0 && cross(bx, by, cx, cy, vx, vy) * orient >= 0
+                    && cross(cx, cy, ax, ay, vx, vy) * orient >= 0)
+                ear = false;
+        }
+        if (!ear && stalls < remaining)
+        {
+            i = c;
+            stalls++;
+            continue;
+        }
+        out.push_back(ring[a]);
+        out.push_back(ring[i]);
+        out.push_back(ring[c]);
+        next[a] = c;
+        prev[c] = a;
+        remaining--;
+        stalls = 0;
+        i = c;
+    }
+    out.push_back(ring[prev[i]]);
+    out.push_back(ring[i]);
+    out.push_back(ring[next[i]]);
+}
+
+void Tessellator::fillSlabs(const float *xy, std::vector<float> &out)
+{
+    // Between two consecutive vertex or crossing heights no edges cross,
+    // so each slab is a row of trapezoids. crossesItself() has sorted the
+    // edges by their top.
+    int m = ring.size();
+    ys.clear();
+    for (int k = 0; k < m; k++)
+        ys.push_back(Y(k));
+    for (int i = 0; i < m; i++)
+    {
+        int a = edges[i];
+        const float *a0 = xy + 2 * ring[a];
+        const float *a1 = xy + 2 * ring[(a + 1) % m];
+        float bottom = std::max(a0[1], a1[1]);
+        for (int j = i + 1; j < m; j++)
+        {
+            int b = edges[j];
+            const float *b0 = xy + 2 * ring[b];
+            const float *b1 = xy + 2 * ring[(b + 1) % m];
+            if (std::min(b0[1], b1[1]) > bottom)
+                break;
+            float dx = a1[0] - a0[0], dy = a1[1] - a0[1];
+            float ex = b1[0] - b0[0], ey = b1[1] - b0[1];
+            float d = dx * ey - dy * ex;
+            if (d == 0)
+                continue;
+            float t = ((b0[0] - a0[0]) * ey - (b0[1] - a0[1]) * ex) / d;
+            float u = ((b0[0] - a0[0]) * dy - (b0[1] - a0[1]) * dx) / d;
+            if (t > 0 && t < 1 && u > 0 && u < 1)
+                ys.push_back(a0[1] + t * dy);
+        }
+    }
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+    for (size_t s = 0; s + 1 < ys.size(); s++)
+    {
+        float y0 = ys[s], y1 = ys[s + 1], ym = 0.5f * (y0 + y1);
+        spans.clear();
+        for (int i = 0; i < m; i++)
+        {
+            int e = edges[i];
+            float xa = X(e), ya = Y(e), xb = X((e + 1) % m), yb = Y((e + 1) % m);
+            if (std::min(ya, yb) > y0)
+                break;
+            if (std::max(ya, yb) < y1)
+                continue;
+            float slope = (xb - xa) / (yb - ya);
+            Span span;
+            span.top = xa + (y0 - ya) * slope;
+            span.bottom = xa + (y1 - ya) * slope;
+            span.middle = xa + (ym - ya) * slope;
+            span.winding = (yb > ya ? 1 : -1);
+            spans.push_back(span);
+        }
+        std::sort(spans.begin(), spans.end(), [](const Span &a, const Span &b) {
+            return a.middle < b.middle;
+        });
+
+        int winding = 0;
+        size_t left = 0;
+        for (size_t k = 0; k < spans.size(); k++)
+        {
+            int before = winding;
+            winding += spans[k].winding;
+            if (before == 0 && winding != 0)
+                left = k;
+            else if (before != 0 && winding == 0)
+            {
+                const Span &l = spans[left], &r = spans[k];
+                addTriangle(out, l.top, y0, r.top, y0, r.bottom, y1);
+                addTriangle(out, l.top, y0, r.bottom, y1, l.bottom, y1);
+            }
+        }
+    }
+}
+
+void Tessellator::stroke(const float *xy, int count, bool closed, const Stroke &style, float scale,
+        std::vector<float> &out)
+{
+    if (count < 1)
+        return;
+    collectRing(xy, count);
+    int m = ring.size();
+    float hw = 0.5f * (style.weight > 0 ? style.weight : 1);
+    int circle = circleSegments(hw * scale);
+
+    // A single point is the cap of a zero length line
+    if (m == 1)
+    {
+        if (style.cap == ROUND_CAP)
+            addFan(out, X(0), Y(0), hw, 0, 2 * M_PI, circle);
+        else if (style.cap == SQUARE_CAP)
+        {
+            addTriangle(out, X(0) - hw, Y(0) - hw, X(0) + hw, Y(0) - hw, X(0) + hw, Y(0) + hw);
+            addTriangle(out, X(0) - hw, Y(0) - hw, X(0) + hw, Y(0) + hw, X(0) - hw, Y(0) + hw);
+        }
+        return;
+    }
+    if (m < 3)
+        closed = false;
+
+    int segments = (closed ? m : m - 1);
+    for (int i = 0; i < segments; i++)
+    {
+        float x0 = X(i), y0 = Y(i);
+        float x1 = X((i + 1) % m), y1 = Y((i + 1) % m);
+        float length = std::sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+        float dx = (x1 - x0) / length, dy = (y1 - y0) / length;
+        if (!closed && style.cap == SQUARE_CAP)
+        {
+            if (i == 0)
+            {
+                x0 -= dx * hw;
+                y0 -= dy * hw;
+            }
+            if (i == segments - 1)
+            {
+                x1 += dx * hw;
+                y1 += dy * hw;
+            }
+        }
+        float nx = -dy * hw, ny = dx * hw;
+        addTriangle(out, x0 + nx, y0 + ny, x0 - nx, y0 - ny, x1 + nx, y1 + ny);
+        addTriangle(out, x1 + nx, y1 + ny, x0 - nx, y0 - ny, x1 - nx, y1 - ny);
+    }
+
+    // Joins fill the wedge on the outer side of each turn
+    int first = (closed ? 0 : 1);
+    int last = (closed ? m : m - 1);
+    for (int i = first; i < last; i++)
+    {
+        int a = (i + m - 1) % m, c = (i + 1) % m;
+        float px = X(i), py = Y(i);
+        float d0x = px - X(a), d0y = py - Y(a);
+        float d1x = X(c) - px, d1y = Y(c) - py;
+        float l0 = std::sqrt(d0x * d0x + d0y * d0y), l1 = std::sqrt(d1x * d1x + d1y * d1y);
+        d0x /= l0;
+        d0y /= l0;
+        d1x /= l1;
+        d1y /= l1;
+        float turn = d0x * d1y - d0y * d1x;
+        if (turn == 0 && d0x * d1x + d0y * d1y > 0)
+            continue;
+
+        // The outer side is the one the path turns away from
+        float side = (turn > 0 ? -1 : 1);
+        float ax = -d0y * side * hw, ay = d0x * side * hw;
+        float bx = -d1y * side * hw, by = d1x * side * hw;
+        if (style.join == ROUND_JOIN)
+        {
+            float sweep = std::atan2(ax * by - ay * bx, ax * bx + ay * by);
+            addFan(out, px, py, ax, ay, sweep, circle);
+            continue;
+        }
+        float mx = ax + bx, my = ay + by;
+        float ml = std::sqrt(mx * mx + my * my);
+        float cosine = (ml > 0 ? (mx * ax + my * ay) / (ml * hw) : 0);
+        if (style.join == MITER_JOIN && cosine > 0 && 1 / cosine <= style.miterLimit)
+        {
+            float tx = px + mx / ml * (hw / cosine), ty = py + my / ml * (hw / cosine);
+            addTriangle(out, px, py, px + ax, py + ay, tx, ty);
+            addTriangle(out, px, py, tx, ty, px + bx, py + by);
+        }
+        else
+            addTriangle(out, px, py, px + ax, py + ay, px + bx, py + by);
+    }
+
+    if (!closed && style.cap == ROUND_CAP)
+    {
+        // Half discs turning from the left side around the end
+        float dx = X(1) - X(0), dy = Y(1) - Y(0);
+        float l = std::sqrt(dx * dx + dy * dy);
+        addFan(out, X(0), Y(0), -dy / l * hw, dx / l * hw, M_PI, circle);
+        dx = X(m - 1) - X(m - 2);
+        dy = Y(m - 1) - Y(m - 2);
+        l = std::sqrt(dx * dx + dy * dy);
+        addFan(out, X(m - 1), Y(m - 1), dy / l * hw, -dx / l * hw, M_PI, circle);
+    }
+}
+
+PROCESSING_END_NAMESPACE
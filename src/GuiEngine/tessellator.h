@@ -0,0 +1,78 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef P_TESSELLATOR_H
+#define P_TESSELLATOR_H
+
+#include "pglobal.h"
+#include <vector>
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * Turns polygons and polylines into triangles for the renderers. Points
+ * come in as x, y pairs and triangles go out as three of them, appended
+ * to the caller's buffer. The working memory is kept between calls, once
+ * it has grown to the largest shape nothing more is allocated.
+ *
+ * Fills follow the nonzero rule: convex polygons become a fan, simple
+ * ones are ear clipped and self-intersecting ones are cut into horizontal
+ * trapezoids at every vertex and crossing.
+ */
+class Tessellator
+{
+public:
+    enum Join { MITER_JOIN, BEVEL_JOIN, ROUND_JOIN };
+    enum Cap { FLAT_CAP, SQUARE_CAP, ROUND_CAP };
+
+    struct Stroke
+    {
+        Stroke() : weight(1), join(MITER_JOIN), cap(ROUND_CAP), miterLimit(4) {}
+
+        float weight;
+        Join join;
+        Cap cap;
+        float miterLimit;
+    };
+
+public:
+    Tessellator();
+
+    void fill(const float *xy, int count, std::vector<float> &out);
+
+    // Triangles as indices of the points. False, with nothing added, when
+    // the polygon crosses itself and new points would be needed.
+    bool triangulate(const float *xy, int count, std::vector<int> &out);
+
+    // Round joins and caps are split finely enough for the given scale
+    void stroke(const float *xy, int count, bool closed, const Stroke &style, float scale,
+            std::vector<float> &out);
+
+    static bool isConvex(const float *xy, int count);
+
+private:
+    struct Span
+    {
+        float top;
+        float bottom;
+        float middle;
+        int winding;
+    };
+
+    void collectRing(const float *xy, int count);
+    bool crossesItself(const float *xy);
+    void clipEars(const float *xy, std::vector<int> &out);
+    void fillSlabs(const float *xy, std::vector<float> &out);
+
+    std::vector<int> ring;
+    std::vector<int> prev;
+    std::vector<int> next;
+    std::vector<int> edges;
+    std::vector<int> triangles;
+    std::vector<float> ys;
+    std::vector<Span> spans;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // P_TESSELLATOR_H
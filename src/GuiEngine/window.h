@@ -17,6 +17,7 @@ public:
 
     virtual void setWindowTitle(const char *title) = 0;
     virtual void setFixedSize(int width, int height) = 0;
+    virtual void setResizable(bool resizable) = 0;
     virtual bool hasParent() const { return false; }
     virtual void show() = 0;
     virtual void start(int fps) = 0;
@@ -25,6 +26,9 @@ public:
 
     virtual void loop() = 0;
     virtual void noLoop() = 0;
+    virtual void loopOnInput() = 0;
+    virtual void redraw() = 0;
+    virtual bool isLooping() const = 0;
 
 protected:
     Window();
@@ -0,0 +1,390 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "kdtree.h"
+#include "pparallel.h"
+#include <algorithm>
+#include <cfloat>
+#include <thread>
+
+PROCESSING_BEGIN_NAMESPACE
+
+// Nodes are numbered as in a heap, node (1 << level) - 1 + i being the
+// i-th of its level, and every leaf is at the same depth. The points of
+// node i on a level are [n * i, n * (i + 1)) >> level in tree order, so
+// neither ranges nor children are stored, only the bounding boxes.
+static inline int first(int n, int level, int i)
+{
+    return (int) (((long long) n * i) >> level);
+}
+
+static void bounds(const float *x, const float *y, const float *z, int begin, int end, float *box)
+{
+    float lo[3] = { FLT_MAX, FLT_MAX, z ? FLT_MAX : 0 };
+    float hi[3] = { -FLT_MAX, -FLT_MAX, z ? -FLT_MAX : 0 };
+    for (int i = begin; i < end; i++)
+    {
+        lo[0] = std::min(lo[0], x[i]);
+        hi[0] = std::max(hi[0], x[i]);
+        lo[1] = std::min(lo[1], y[i]);
+        hi[1] = std::max(hi[1], y[i]);
+    }
+    if (z)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            lo[2] = std::min(lo[2], z[i]);
+            hi[2] = std::max(hi[2], z[i]);
+        }
+    }
+    std::copy(lo, lo + 3, box);
+    std::copy(hi, hi + 3, box + 3);
+}
+
+KdTree::KdTree()
+    : dims(2), depth(0)
+{
+}
+
+KdTree::KdTree(const PVectorArray &points)
+    : dims(2), depth(0)
+{
+    build(points);
+}
+
+KdTree::KdTree(const std::vector<PVector> &points)
+    : dims(2), depth(0)
+{
+    build(points);
+}
+
+void KdTree::build(const PVectorArray &points)
+{
+    int n = points.size();
+    dims = (points.is3D() ? 3 : 2);
+    depth = 0;
+    while (((long long) P_KDTREE_LEAF_SIZE << depth) < n)
+        depth++;
+    boxes.assign(6 * ((2 << depth) - 1), 0.0f);
+
+    std::vector<Entry> entries(n);
+    const float *x = points.xData();
+    const float *y = points.yData();
+    const float *z = (dims == 3 ? points.zData() : 0);
+    for (int i = 0; i < n; i++)
+    {
+        Entry e = { { x[i], y[i], z ? z[i] : 0 }, i };
+        entries[i] = e;
+    }
+
+    // Fork a thread per split on the top levels until there is one per core
+    order.resize(n);
+    px.resize(n);
+    py.resize(n);
+    pz.resize(dims == 3 ? n : 0);
+    int forks = 0;
+    while ((1u << forks) < std::thread::hardware_concurrency())
+        forks++;
+    float box[6];
+    bounds(x, y, z, 0, n, box);
+    if (n)
+        split(entries.data(), 0, 0, box, forks);
+
+    for (int i = 0; i < n; i++)
+    {
+        order[i] = entries[i].index;
+        px[i] = entries[i].p[0];
+        py[i] = entries[i].p[1];
+    }
+    for (size_t i = 0; i < pz.size(); i++)
+        pz[i] = entries[i].p[2];
+    refit();
+}
+
+void KdTree::build(const std::vector<PVector> &points)
+{
+    PVectorArray array((int) points.size(), points.empty() ? PVector::V2D : points[0].type());
+    for (size_t i = 0; i < points.size(); i++)
+        array.set((int) i, points[i]);
+    build(array);
+}
+
+void KdTree::update(const PVectorArray &points)
+{
+    if (points.size() != size() || (points.is3D() ? 3 : 2) != dims)
+    {
+        build(points);
+        return;
+    }
+
+    const float *x = points.xData();
+    const float *y = points.yData();
+    const float *z = points.zData();
+    parallelFor(size(), P_PARALLEL_GRAIN, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+        {
+            px[i] = x[order[i]];
+            py[i] = y[order[i]];
+        }
+        if (dims == 3)
+            for (int i = begin; i < end; i++)
+                pz[i] = z[order[i]];
+    });
+    refit();
+}
+
+void KdTree::clear()
+{
+    depth = 0;
+    order.clear();
+    px.clear();
+    py.clear();
+    pz.clear();
+    boxes.clear();
+}
+
+// The axis is the widest of the bounds narrowed down by the medians above,
+// the exact boxes come after from refit()
+void KdTree::split(Entry *entries, int node, int level, float *box, int forks)
+{
+    if (level == depth)
+        return;
+
+    int axis = 0;
+    for (int k = 1; k < dims; k++)
+        if (box[3 + k] - box[k] > box[3 + axis] - box[axis])
+            axis = k;
+    int begin, end;
+    range(node, level, begin, end);
+    int mid = first(size(), level + 1, 2 * (node - ((1 << level) - 1)) + 1);
+    std::nth_element(entries + begin, entries + mid, entries + end, [axis](const Entry &a, const Entry &b) {
+        return a.p[axis] < b.p[axis];
+    });
+
+    float left[6], right[6];
+    std::copy(box, box + 6, left);
+    std::copy(box, box + 6, right);
+    left[3 + axis] = right[axis] = entries[mid].p[axis];
+    if (forks > 0 && end - begin >= P_PARALLEL_GRAIN)
+    {
+        std::thread worker(&KdTree::split, this, entries, 2 * node + 1, level + 1, left, forks - 1);
+        split(entries, 2 * node + 2, level + 1, right, forks - 1);
+        worker.join();
+        return;
+    }
+    split(entries, 2 * node + 1, level + 1, left, 0);
+    split(entries, 2 * node + 2, level + 1, right, 0);
+}
+
+void KdTree::refit()
+{
+    // Leaves from their points, then every level from the one below
+    int leaves = 1 << depth;
+    const float *z = (dims == 3 ? pz.data() : 0);
+    parallelFor(leaves, P_PARALLEL_GRAIN / P_KDTREE_LEAF_SIZE, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+        {
+            int node = leaves - 1 + i;
+            int from, to;
+            range(node, depth, from, to);
+            bounds(px.data(), py.data(), z, from, to, &boxes[6 * node]);
+        }
+    });
+    for (int node = leaves - 2; node >= 0; node--)
+    {
+        float *box = &boxes[6 * node];
+        const float *left = &boxes[6 * (2 * node + 1)];
+        const float *right = &boxes[6 * (2 * node + 2)];
+        for (int k = 0; k < 3; k++)
+        {
+            box[k] = std::min(left[k], right[k]);
+            box[3 + k] = std::max(left[3 + k], right[3 + k]);
+        }
+    }
+}
+
+void KdTree::range(int node, int level, int &begin, int &end) const
+{
+    int i = node - ((1 << level) - 1);
+    begin = first(size(), level, i);
+    end = first(size(), level, i + 1);
+}
+
+float KdTree::dist2(int i, const float *q) const
+{
+    float dx = px[i] - q[0];
+    float dy = py[i] - q[1];
+    float d = dx * dx + dy * dy;
+    if (dims == 3)
+    {
+        float dz = pz[i] - q[2];
+        d += dz * dz;
+    }
+    return d;
+}
+
+float KdTree::boxDist2(int node, const float *q) const
+{
+    const float *box = &boxes[6 * node];
+    float d = 0;
+    for (int k = 0; k < dims; k++)
+    {
+        float t = std::max(std::max(box[k] - q[k], q[k] - box[3 + k]), 0.0f);
+        d += t * t;
+    }
+    return d;
+}
+
+// Nearest first, so the k found soon rule out the farther boxes
+void KdTree::search(int node, int level, float d2, const float *q, int k, Neighbor *best, int &found) const
+{
+    if (found == k && d2 >= best[k - 1].d2)
+        return;
+    if (level == depth)
+    {
+        int begin, end;
+        range(node, level, begin, end);
+        for (int i = begin; i < end; i++)
+        {
+            float d = dist2(i, q);
+            if (found == k && d >= best[k - 1].d2)
+                continue;
+            int j = (found < k ? found++ : k - 1);
+            for (; j > 0 && best[j - 1].d2 > d; j--)
+                best[j] = best[j - 1];
+            best[j].d2 = d;
+            best[j].index = order[i];
+        }
+        return;
+    }
+
+    int left = 2 * node + 1;
+    int right = left + 1;
+    float dl = boxDist2(left, q);
+    float dr = boxDist2(right, q);
+    if (dl <= dr)
+    {
+        search(left, level + 1, dl, q, k, best, found);
+        search(right, level + 1, dr, q, k, best, found);
+    }
+    else
+    {
+        search(right, level + 1, dr, q, k, best, found);
+        search(left, level + 1, dl, q, k, best, found);
+    }
+}
+
+void KdTree::search(int node, int level, const float *q, float r2, std::vector<int> &result) const
+{
+    if (boxDist2(node, q) > r2)
+        return;
+
+    // A box inside the circle is taken whole without measuring its points
+    const float *box = &boxes[6 * node];
+    float far2 = 0;
+    for (int k = 0; k < dims; k++)
+    {
+        float t = std::max(q[k] - box[k], box[3 + k] - q[k]);
+        far2 += t * t;
+    }
+    if (level == depth || far2 <= r2)
+    {
+        int begin, end;
+        range(node, level, begin, end);
+        if (far2 <= r2)
+        {
+            result.insert(result.end(), order.begin() + begin, order.begin() + end);
+            return;
+        }
+        for (int i = begin; i < end; i++)
+            if (dist2(i, q) <= r2)
+                result.push_back(order[i]);
+        return;
+    }
+    search(2 * node + 1, level + 1, q, r2, result);
+    search(2 * node + 2, level + 1, q, r2, result);
+}
+
+static inline void point(const PVector &p, float *q)
+{
+    q[0] = p.x();
+    q[1] = p.y();
+    q[2] = (p.is3D() ? p.z() : 0);
+}
+
+int KdTree::nearest(const PVector &p) const
+{
+    std::vector<int> result;
+    nearest(p, 1, result);
+    return (result.empty() ? -1 : result[0]);
+}
+
+void KdTree::nearest(const PVector &p, int k, std::vector<int> &result) const
+{
+    if (k < 1)
+        throw "nearest(): k must be at least 1";
+    result.clear();
+    if (!size())
+        return;
+
+    float q[3];
+    point(p, q);
+    std::vector<Neighbor> best(k);
+    int found = 0;
+    search(0, 0, boxDist2(0, q), q, k, best.data(), found);
+    for (int i = 0; i < found; i++)
+        result.push_back(best[i].index);
+}
+
+void KdTree::within(const PVector &p, float radius, std::vector<int> &result) const
+{
+    result.clear();
+    if (!size())
+        return;
+
+    float q[3];
+    point(p, q);
+    search(0, 0, q, radius * radius, result);
+}
+
+void KdTree::nearest(const PVectorArray &queries, int k, int *result) const
+{
+    if (k < 1)
+        throw "nearest(): k must be at least 1";
+
+    const float *x = queries.xData();
+    const float *y = queries.yData();
+    const float *z = (queries.is3D() ? queries.zData() : 0);
+    parallelFor(queries.size(), P_KDTREE_QUERY_GRAIN, [&](int begin, int end) {
+        std::vector<Neighbor> best(k);
+        for (int i = begin; i < end; i++)
+        {
+            float q[3] = { x[i], y[i], z ? z[i] : 0 };
+            int found = 0;
+            if (size())
+                search(0, 0, boxDist2(0, q), q, k, best.data(), found);
+            int *out = result + (long long) i * k;
+            for (int j = 0; j < k; j++)
+                out[j] = (j < found ? best[j].index : -1);
+        }
+    });
+}
+
+void KdTree::within(const PVectorArray &queries, float radius, std::vector< std::vector<int> > &result) const
+{
+    const float *x = queries.xData();
+    const float *y = queries.yData();
+    const float *z = (queries.is3D() ? queries.zData() : 0);
+    result.resize(queries.size());
+    parallelFor(queries.size(), P_KDTREE_QUERY_GRAIN, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+        {
+            float q[3] = { x[i], y[i], z ? z[i] : 0 };
+            result[i].clear();
+            if (size())
+                search(0, 0, q, radius * radius, result[i]);
+        }
+    });
+}
+
+PROCESSING_END_NAMESPACE
@@ -0,0 +1,89 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include "pglobal.h"
+#include "pvector.h"
+#include <vector>
+
+// Most points in a leaf, scanned one after another
+#define P_KDTREE_LEAF_SIZE 8
+// Queries per thread below which a batch query stays on one thread
+#define P_KDTREE_QUERY_GRAIN 1024
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * Nearest neighbor index over a set of 2D or 3D points, for flocking and
+ * proximity sketches that would otherwise compare every pair.
+ *
+ * build() splits the points at the median of their widest axis down to
+ * leaves of P_KDTREE_LEAF_SIZE, in parallel for large sets, so rebuilding
+ * every frame is cheap. When points only move a little, update() keeps
+ * the tree and refits the bounding box of every node instead, which
+ * leaves the answers exact and only makes queries slower as the points
+ * drift. Results are indices into the points as given, a point finds
+ * itself, and a 2D vector has z 0.
+ *
+ * The forms taking a PVectorArray of queries split them across threads.
+ */
+class KdTree
+{
+public:
+    KdTree();
+    explicit KdTree(const PVectorArray &points);
+    explicit KdTree(const std::vector<PVector> &points);
+
+    void build(const PVectorArray &points);
+    void build(const std::vector<PVector> &points);
+    void update(const PVectorArray &points);
+    void clear();
+
+    int size() const { return (int) order.size(); }
+    bool is3D() const { return dims == 3; }
+
+    // -1 for an empty tree, k results closest first or fewer when the
+    // tree is smaller
+    int nearest(const PVector &p) const;
+    void nearest(const PVector &p, int k, std::vector<int> &result) const;
+    void within(const PVector &p, float radius, std::vector<int> &result) const;
+
+    // k results per query, -1 where the tree has fewer than k points
+    void nearest(const PVectorArray &queries, int k, int *result) const;
+    void within(const PVectorArray &queries, float radius, std::vector< std::vector<int> > &result) const;
+
+private:
+    struct Entry
+    {
+        float p[3];
+        int index;
+    };
+
+    struct Neighbor
+    {
+        float d2;
+        int index;
+    };
+
+    void split(Entry *entries, int node, int level, float *box, int forks);
+    void refit();
+    void range(int node, int level, int &begin, int &end) const;
+    float dist2(int i, const float *q) const;
+    float boxDist2(int node, const float *q) const;
+    void search(int node, int level, float d2, const float *q, int k, Neighbor *best, int &found) const;
+    void search(int node, int level, const float *q, float r2, std::vector<int> &result) const;
+
+    int dims;
+    int depth;
+    std::vector<int> order;
+    std::vector<float> px;
+    std::vector<float> py;
+    std::vector<float> pz;
+    std::vector<float> boxes;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // KDTREE_H
@@ -0,0 +1,28 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "pfont.h"
+
+PROCESSING_BEGIN_NAMESPACE
+
+// As in Processing, text is 12 pixels until a size is set
+#define P_FONT_DEFAULT_SIZE 12
+
+PFont::PFont()
+    : size(P_FONT_DEFAULT_SIZE), smooth(true)
+{
+}
+
+PFont::PFont(const std::string &name, float size, bool smooth)
+    : name(name), size(size), smooth(smooth)
+{
+    if (size <= 0)
+        throw "createFont(): size must be positive";
+}
+
+bool PFont::operator==(const PFont &other) const
+{
+    return name == other.name && size == other.size && smooth == other.smooth;
+}
+
+PROCESSING_END_NAMESPACE
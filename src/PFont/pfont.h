@@ -0,0 +1,38 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef PFONT_H
+#define PFONT_H
+
+#include "pglobal.h"
+#include <string>
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * A font family at a size in pixels, from createFont(). An empty name is
+ * the system's default family. Renderers shape and rasterize text once
+ * per font and keep the result, a PFont itself is only the description.
+ */
+class PFont
+{
+public:
+    PFont();
+    PFont(const std::string &name, float size, bool smooth=true);
+
+    const std::string & getName() const { return name; }
+    float getSize() const { return size; }
+    bool isSmooth() const { return smooth; }
+
+    bool operator==(const PFont &other) const;
+    bool operator!=(const PFont &other) const { return !(*this == other); }
+
+private:
+    std::string name;
+    float size;
+    bool smooth;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // PFONT_H
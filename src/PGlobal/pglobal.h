@@ -28,6 +28,7 @@
 #define P_HEIGHT_MINIMUM    100
 #define P_FRAMERATE_MINIMUM 1
 #define P_FRAMERATE_DEFAULT 30
+#define P_FRAMERATE_IDLE    1
 
 #define PFUNCTIONS \
     PB(setup) \
@@ -41,7 +42,8 @@
     PB(mouseWheel) \
     PB(keyPressed) \
     PB(keyReleased) \
-    PB(keyTyped)
+    PB(keyTyped) \
+    PB(windowResized)
 
 #ifndef __has_feature      // Optional of course.
 #define __has_feature(x) 0 // Compatibility with non-clang compilers.
@@ -591,12 +593,50 @@ enum DrawMode
     CORNERS
 };
 
+enum ShapeKind
+{
+    POLYGON,
+    POINTS,
+    LINES,
+    TRIANGLES,
+    TRIANGLE_FAN,
+    TRIANGLE_STRIP,
+    QUADS,
+    QUAD_STRIP
+};
+
+enum ShapeFamily
+{
+    PATH,
+    POINT,
+    LINE,
+    TRIANGLE,
+    QUAD,
+    RECT,
+    ELLIPSE,
+    ARC
+};
+
+enum EndMode
+{
+    END_OPEN,
+    CLOSE
+};
+
 enum ColorMode
 {
     RGB,
     HSB
 };
 
+enum Quality
+{
+    QUALITY_FULL,
+    QUALITY_NO_SMOOTH,
+    QUALITY_LOW_RES,
+    QUALITY_SKIP_FRAMES
+};
+
 typedef void (*PCALLBACK)();
 typedef std::map<std::string,PCALLBACK> PFunctions;
 typedef bool boolean;
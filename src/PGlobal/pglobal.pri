@@ -1,2 +1,3 @@
 # Author: Gary Huang <gh.nctu+code@gmail.com>
 HEADERS += $$PWD/pglobal.h
+HEADERS += $$PWD/pparallel.h
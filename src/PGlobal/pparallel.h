@@ -0,0 +1,48 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef PPARALLEL_H
+#define PPARALLEL_H
+
+#include "pglobal.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Items per thread below which splitting work does not pay for the threads
+#define P_PARALLEL_GRAIN 16384
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * Runs fn(begin, end) over [0, count) split into one contiguous range per
+ * hardware thread, the calling thread taking the first range. Ranges are
+ * at least grain items, so small work stays on the calling thread.
+ */
+template <class F>
+inline void parallelFor(int count, int grain, F fn)
+{
+    int threads = std::min((int) std::thread::hardware_concurrency(), count / std::max(grain, 1));
+    if (threads <= 1)
+    {
+        if (count > 0)
+            fn(0, count);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (int t = 1; t < threads; t++)
+    {
+        int begin = (int) ((long long) count * t / threads);
+        int end = (int) ((long long) count * (t + 1) / threads);
+        workers.push_back(std::thread(fn, begin, end));
+    }
+    fn(0, (int) ((long long) count / threads));
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+PROCESSING_END_NAMESPACE
+
+#endif // PPARALLEL_H
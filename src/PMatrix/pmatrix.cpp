@@ -0,0 +1,801 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "pmatrix.h"
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * PMatrix2D class
+ */
+PMatrix2D::PMatrix2D()
+{
+    reset();
+}
+
+PMatrix2D::PMatrix2D(float m00, float m01, float m02, float m10, float m11, float m12)
+{
+    set(m00, m01, m02, m10, m11, m12);
+}
+
+void PMatrix2D::reset()
+{
+    set(1, 0, 0, 0, 1, 0);
+}
+
+void PMatrix2D::set(float n00, float n01, float n02, float n10, float n11, float n12)
+{
+    m00 = n00; m01 = n01; m02 = n02;
+    m10 = n10; m11 = n11; m12 = n12;
+}
+
+void PMatrix2D::set(const PMatrix2D &m)
+{
+    *this = m;
+}
+
+void PMatrix2D::get(float *target) const
+{
+    target[0] = m00; target[1] = m01; target[2] = m02;
+    target[3] = m10; target[4] = m11; target[5] = m12;
+}
+
+void PMatrix2D::translate(float tx, float ty)
+{
+    m02 = tx * m00 + ty * m01 + m02;
+    m12 = tx * m10 + ty * m11 + m12;
+}
+
+void PMatrix2D::rotate(float angle)
+{
+    float s = sinf(angle);
+    float c = cosf(angle);
+    float t00 = m00, t01 = m01;
+    m00 = c * t00 + s * t01;
+    m01 = -s * t00 + c * t01;
+    float t10 = m10, t11 = m11;
+    m10 = c * t10 + s * t11;
+    m11 = -s * t10 + c * t11;
+}
+
+void PMatrix2D::scale(float s)
+{
+    scale(s, s);
+}
+
+void PMatrix2D::scale(float sx, float sy)
+{
+    m00 *= sx; m01 *= sy;
+    m10 *= sx; m11 *= sy;
+}
+
+void PMatrix2D::shearX(float angle)
+{
+    apply(1, tanf(angle), 0, 0, 1, 0);
+}
+
+void PMatrix2D::shearY(float angle)
+{
+    apply(1, 0, 0, tanf(angle), 1, 0);
+}
+
+void PMatrix2D::apply(const PMatrix2D &m)
+{
+    apply(m.m00, m.m01, m.m02, m.m10, m.m11, m.m12);
+}
+
+void PMatrix2D::apply(float n00, float n01, float n02, float n10, float n11, float n12)
+{
+    float t0 = m00, t1 = m01;
+    m00 = t0 * n00 + t1 * n10;
+    m01 = t0 * n01 + t1 * n11;
+    m02 += t0 * n02 + t1 * n12;
+    t0 = m10; t1 = m11;
+    m10 = t0 * n00 + t1 * n10;
+    m11 = t0 * n01 + t1 * n11;
+    m12 += t0 * n02 + t1 * n12;
+}
+
+void PMatrix2D::preApply(const PMatrix2D &m)
+{
+    preApply(m.m00, m.m01, m.m02, m.m10, m.m11, m.m12);
+}
+
+void PMatrix2D::preApply(float n00, float n01, float n02, float n10, float n11, float n12)
+{
+    float t0 = m02, t1 = m12;
+    n02 += t0 * n00 + t1 * n01;
+    n12 += t0 * n10 + t1 * n11;
+    m02 = n02;
+    m12 = n12;
+    t0 = m00; t1 = m10;
+    m00 = t0 * n00 + t1 * n01;
+    m10 = t0 * n10 + t1 * n11;
+    t0 = m01; t1 = m11;
+    m01 = t0 * n00 + t1 * n01;
+    m11 = t0 * n10 + t1 * n11;
+}
+
+PVector PMatrix2D::mult(const PVector &source) const
+{
+    return PVector(multX(source.x(), source.y()), multY(source.x(), source.y()));
+}
+
+void PMatrix2D::mult(const float *source, float *target, int count) const
+{
+    // Interleaved x, y pairs, target may be the source
+    const float a = m00, b = m01, c = m02, d = m10, e = m11, f = m12;
+    for (int i = 0; i < count; i++)
+    {
+        float x = source[2 * i];
+        float y = source[2 * i + 1];
+        target[2 * i] = a * x + b * y + c;
+        target[2 * i + 1] = d * x + e * y + f;
+    }
+}
+
+void PMatrix2D::mult(const PVectorArray &source, PVectorArray &target) const
+{
+    // z is dropped as in mult(PVector), target may be the source
+    int n = source.size();
+    target.resize(n, PVector::V2D);
+    const float *sx = source.xData();
+    const float *sy = source.yData();
+    float *tx = target.xData();
+    float *ty = target.yData();
+    int i = 0;
+#ifdef __SSE__
+    const __m128 a = _mm_set1_ps(m00), b = _mm_set1_ps(m01), c = _mm_set1_ps(m02);
+    const __m128 d = _mm_set1_ps(m10), e = _mm_set1_ps(m11), f = _mm_set1_ps(m12);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(sx + i);
+        __m128 y = _mm_loadu_ps(sy + i);
+        _mm_storeu_ps(tx + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(b, y)), c));
+        _mm_storeu_ps(ty + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(d, x), _mm_mul_ps(e, y)), f));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        float x = sx[i];
+        float y = sy[i];
+        tx[i] = multX(x, y);
+        ty[i] = multY(x, y);
+    }
+}
+
+bool PMatrix2D::invert()
+{
+    float det = determinant();
+    if (fabsf(det) <= 1e-20f)
+        return false;
+
+    float t00 = m00, t01 = m01, t02 = m02;
+    float t10 = m10, t11 = m11, t12 = m12;
+    m00 = t11 / det;
+    m10 = -t10 / det;
+    m01 = -t01 / det;
+    m11 = t00 / det;
+    m02 = (t01 * t12 - t11 * t02) / det;
+    m12 = (t10 * t02 - t00 * t12) / det;
+    return true;
+}
+
+bool PMatrix2D::isIdentity() const
+{
+    return (m00 == 1 && m01 == 0 && m02 == 0 &&
+            m10 == 0 && m11 == 1 && m12 == 0);
+}
+
+bool PMatrix2D::operator==(const PMatrix2D &m) const
+{
+    return (m00 == m.m00 && m01 == m.m01 && m02 == m.m02 &&
+            m10 == m.m10 && m11 == m.m11 && m12 == m.m12);
+}
+
+std::ostream & operator<<(std::ostream &os, const PMatrix2D &m)
+{
+    os << "[ " << m.m00 << ", " << m.m01 << ", " << m.m02 << " ]\n"
+       << "[ " << m.m10 << ", " << m.m11 << ", " << m.m12 << " ]\n";
+    return os;
+}
+
+/**
+ * PMatrix3D class
+ */
+PMatrix3D::PMatrix3D()
+{
+    reset();
+}
+
+PMatrix3D::PMatrix3D(float n00, float n01, float n02, float n03,
+                     float n10, float n11, float n12, float n13,
+                     float n20, float n21, float n22, float n23,
+                     float n30, float n31, float n32, float n33)
+{
+    const float source[16] = {
+        n00, n01, n02, n03, n10, n11, n12, n13,
+        n20, n21, n22, n23, n30, n31, n32, n33
+    };
+    set(source);
+}
+
+PMatrix3D::PMatrix3D(const PMatrix2D &m)
+{
+    const float source[16] = {
+        m.m00, m.m01, 0, m.m02,
+        m.m10, m.m11, 0, m.m12,
+        0, 0, 1, 0,
+        0, 0, 0, 1
+    };
+    set(source);
+}
+
+void PMatrix3D::reset()
+{
+    static const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    set(identity);
+}
+
+void PMatrix3D::set(const float *s)
+{
+    m00 = s[0];  m01 = s[1];  m02 = s[2];  m03 = s[3];
+    m10 = s[4];  m11 = s[5];  m12 = s[6];  m13 = s[7];
+    m20 = s[8];  m21 = s[9];  m22 = s[10]; m23 = s[11];
+    m30 = s[12]; m31 = s[13]; m32 = s[14]; m33 = s[15];
+}
+
+void PMatrix3D::set(const PMatrix3D &m)
+{
+    *this = m;
+}
+
+void PMatrix3D::get(float *t) const
+{
+    t[0] = m00;  t[1] = m01;  t[2] = m02;  t[3] = m03;
+    t[4] = m10;  t[5] = m11;  t[6] = m12;  t[7] = m13;
+    t[8] = m20;  t[9] = m21;  t[10] = m22; t[11] = m23;
+    t[12] = m30; t[13] = m31; t[14] = m32; t[15] = m33;
+}
+
+void PMatrix3D::translate(float tx, float ty)
+{
+    translate(tx, ty, 0);
+}
+
+void PMatrix3D::translate(float tx, float ty, float tz)
+{
+    m03 += tx * m00 + ty * m01 + tz * m02;
+    m13 += tx * m10 + ty * m11 + tz * m12;
+    m23 += tx * m20 + ty * m21 + tz * m22;
+    m33 += tx * m30 + ty * m31 + tz * m32;
+}
+
+void PMatrix3D::rotate(float angle, float v0, float v1, float v2)
+{
+    float norm2 = v0 * v0 + v1 * v1 + v2 * v2;
+    if (norm2 < 1e-12f)
+        return;
+    if (fabsf(norm2 - 1) > 1e-6f)
+    {
+        float norm = sqrtf(norm2);
+        v0 /= norm;
+        v1 /= norm;
+        v2 /= norm;
+    }
+
+    float c = cosf(angle);
+    float s = sinf(angle);
+    float t = 1 - c;
+    apply((t * v0 * v0) + c, (t * v0 * v1) - (s * v2), (t * v0 * v2) + (s * v1), 0,
+          (t * v0 * v1) + (s * v2), (t * v1 * v1) + c, (t * v1 * v2) - (s * v0), 0,
+          (t * v0 * v2) - (s * v1), (t * v1 * v2) + (s * v0), (t * v2 * v2) + c, 0,
+          0, 0, 0, 1);
+}
+
+void PMatrix3D::rotateX(float angle)
+{
+    float c = cosf(angle);
+    float s = sinf(angle);
+    apply(1, 0, 0, 0, 0, c, -s, 0, 0, s, c, 0, 0, 0, 0, 1);
+}
+
+void PMatrix3D::rotateY(float angle)
+{
+    float c = cosf(angle);
+    float s = sinf(angle);
+    apply(c, 0, s, 0, 0, 1, 0, 0, -s, 0, c, 0, 0, 0, 0, 1);
+}
+
+void PMatrix3D::rotateZ(float angle)
+{
+    float c = cosf(angle);
+    float s = sinf(angle);
+    apply(c, -s, 0, 0, s, c, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+}
+
+void PMatrix3D::scale(float s)
+{
+    scale(s, s, s);
+}
+
+void PMatrix3D::scale(float sx, float sy)
+{
+    scale(sx, sy, 1);
+}
+
+void PMatrix3D::scale(float x, float y, float z)
+{
+    m00 *= x; m01 *= y; m02 *= z;
+    m10 *= x; m11 *= y; m12 *= z;
+    m20 *= x; m21 *= y; m22 *= z;
+    m30 *= x; m31 *= y; m32 *= z;
+}
+
+void PMatrix3D::shearX(float angle)
+{
+    float t = tanf(angle);
+    apply(1, t, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+}
+
+void PMatrix3D::shearY(float angle)
+{
+    float t = tanf(angle);
+    apply(1, 0, 0, 0, t, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+}
+
+void PMatrix3D::apply(const PMatrix2D &m)
+{
+    apply(m.m00, m.m01, 0, m.m02,
+          m.m10, m.m11, 0, m.m12,
+          0, 0, 1, 0,
+          0, 0, 0, 1);
+}
+
+void PMatrix3D::apply(const PMatrix3D &m)
+{
+    apply(m.m00, m.m01, m.m02, m.m03,
+          m.m10, m.m11, m.m12, m.m13,
+          m.m20, m.m21, m.m22, m.m23,
+          m.m30, m.m31, m.m32, m.m33);
+}
+
+// r = a * b, all row major; r may not alias a or b
+static inline void multiply(const float *a, const float *b, float *r)
+{
+#ifdef __SSE__
+    // Every row of r is a sum of the rows of b scaled by a row of a
+    __m128 b0 = _mm_loadu_ps(b);
+    __m128 b1 = _mm_loadu_ps(b + 4);
+    __m128 b2 = _mm_loadu_ps(b + 8);
+    __m128 b3 = _mm_loadu_ps(b + 12);
+    for (int i = 0; i < 4; i++)
+    {
+        const float *row = a + 4 * i;
+        __m128 sum = _mm_mul_ps(_mm_set1_ps(row[0]), b0);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(row[1]), b1));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(row[2]), b2));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(row[3]), b3));
+        _mm_storeu_ps(r + 4 * i, sum);
+    }
+#else
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            r[4 * i + j] = a[4 * i] * b[j] + a[4 * i + 1] * b[4 + j]
+                    + a[4 * i + 2] * b[8 + j] + a[4 * i + 3] * b[12 + j];
+#endif
+}
+
+void PMatrix3D::apply(float n00, float n01, float n02, float n03,
+                      float n10, float n11, float n12, float n13,
+                      float n20, float n21, float n22, float n23,
+                      float n30, float n31, float n32, float n33)
+{
+    const float n[16] = {
+        n00, n01, n02, n03, n10, n11, n12, n13,
+        n20, n21, n22, n23, n30, n31, n32, n33
+    };
+    float m[16], r[16];
+    get(m);
+    multiply(m, n, r);
+    set(r);
+}
+
+void PMatrix3D::preApply(const PMatrix3D &left)
+{
+    float n[16], m[16], r[16];
+    left.get(n);
+    get(m);
+    multiply(n, m, r);
+    set(r);
+}
+
+PVector PMatrix3D::mult(const PVector &source) const
+{
+    float x = source.x();
+    float y = source.y();
+    float z = (source.is3D() ? source.z() : 0);
+    return PVector(multX(x, y, z), multY(x, y, z), multZ(x, y, z));
+}
+
+void PMatrix3D::mult(const float *source, float *target, int count) const
+{
+    // Interleaved x, y, z triples, target may be the source. The
+    // transform is affine, the bottom row is not used.
+#ifdef __SSE__
+    __m128 c0 = _mm_setr_ps(m00, m10, m20, 0);
+    __m128 c1 = _mm_setr_ps(m01, m11, m21, 0);
+    __m128 c2 = _mm_setr_ps(m02, m12, m22, 0);
+    __m128 c3 = _mm_setr_ps(m03, m13, m23, 0);
+    float out[4];
+    for (int i = 0; i < count; i++)
+    {
+        const float *p = source + 3 * i;
+        __m128 xy = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p[0])), _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+        __m128 zw = _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(p[2])), c3);
+        _mm_storeu_ps(out, _mm_add_ps(xy, zw));
+        memcpy(target + 3 * i, out, 3 * sizeof(float));
+    }
+#else
+    for (int i = 0; i < count; i++)
+    {
+        float x = source[3 * i];
+        float y = source[3 * i + 1];
+        float z = source[3 * i + 2];
+        target[3 * i] = multX(x, y, z);
+        target[3 * i + 1] = multY(x, y, z);
+        target[3 * i + 2] = multZ(x, y, z);
+    }
+#endif
+}
+
+void PMatrix3D::mult(const PVectorArray &source, PVectorArray &target) const
+{
+    // 2D vectors have z 0 and come out 3D, target may be the source
+    int n = source.size();
+    bool flat = !source.is3D();
+    target.resize(n, PVector::V3D);
+    const float *sx = source.xData();
+    const float *sy = source.yData();
+    const float *sz = (flat ? 0 : source.zData());
+    float *tx = target.xData();
+    float *ty = target.yData();
+    float *tz = target.zData();
+    int i = 0;
+#ifdef __SSE__
+    const float *rows[3] = { &m00, &m10, &m20 };
+    float *out[3] = { tx, ty, tz };
+    __m128 m[3][4];
+    for (int r = 0; r < 3; r++)
+        for (int k = 0; k < 4; k++)
+            m[r][k] = _mm_set1_ps(rows[r][k]);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(sx + i);
+        __m128 y = _mm_loadu_ps(sy + i);
+        __m128 z = (flat ? _mm_setzero_ps() : _mm_loadu_ps(sz + i));
+        for (int r = 0; r < 3; r++)
+        {
+            __m128 sum = _mm_add_ps(_mm_mul_ps(m[r][0], x), _mm_mul_ps(m[r][1], y));
+            sum = _mm_add_ps(_mm_add_ps(sum, _mm_mul_ps(m[r][2], z)), m[r][3]);
+            _mm_storeu_ps(out[r] + i, sum);
+        }
+    }
+#endif
+    for (; i < n; i++)
+    {
+        float x = sx[i];
+        float y = sy[i];
+        float z = (flat ? 0 : sz[i]);
+        tx[i] = multX(x, y, z);
+        ty[i] = multY(x, y, z);
+        tz[i] = multZ(x, y, z);
+    }
+}
+
+void PMatrix3D::transpose()
+{
+    float t;
+    t = m01; m01 = m10; m10 = t;
+    t = m02; m02 = m20; m20 = t;
+    t = m03; m03 = m30; m30 = t;
+    t = m12; m12 = m21; m21 = t;
+    t = m13; m13 = m31; m31 = t;
+    t = m23; m23 = m32; m32 = t;
+}
+
+// Cofactors of the 4x4 matrix, laid out as the transposed adjugate
+static void adjugate(const float *m, float *inv)
+{
+    inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15]
+           + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+    inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15]
+           - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+    inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15]
+           + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+    inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14]
+            - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+    inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15]
+           - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+    inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15]
+           + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+    inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15]
+           - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+    inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14]
+            + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+    inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15]
+           + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+    inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15]
+           - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+    inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15]
+            + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+    inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14]
+            - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+    inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11]
+           - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+    inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11]
+           + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+    inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11]
+            - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+    inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10]
+            + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+}
+
+bool PMatrix3D::invert()
+{
+    if (m30 == 0 && m31 == 0 && m32 == 0 && m33 == 1)
+        return invertAffine();
+
+    float m[16], inv[16];
+    get(m);
+    adjugate(m, inv);
+    float det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+    if (fabsf(det) <= 1e-20f)
+        return false;
+    for (int i = 0; i < 16; i++)
+        inv[i] /= det;
+    set(inv);
+    return true;
+}
+
+// The inverse of [ R t ] is [ R^-1 -R^-1 t ], a 3x3 inverse instead of
+// the 4x4 cofactors
+bool PMatrix3D::invertAffine()
+{
+    float c00 = m11 * m22 - m12 * m21;
+    float c01 = m02 * m21 - m01 * m22;
+    float c02 = m01 * m12 - m02 * m11;
+    float c10 = m12 * m20 - m10 * m22;
+    float c11 = m00 * m22 - m02 * m20;
+    float c12 = m02 * m10 - m00 * m12;
+    float c20 = m10 * m21 - m11 * m20;
+    float c21 = m01 * m20 - m00 * m21;
+    float c22 = m00 * m11 - m01 * m10;
+    float det = m00 * c00 + m01 * c10 + m02 * c20;
+    if (fabsf(det) <= 1e-20f)
+        return false;
+
+    float t0 = m03, t1 = m13, t2 = m23;
+    m00 = c00 / det; m01 = c01 / det; m02 = c02 / det;
+    m10 = c10 / det; m11 = c11 / det; m12 = c12 / det;
+    m20 = c20 / det; m21 = c21 / det; m22 = c22 / det;
+    m03 = -(m00 * t0 + m01 * t1 + m02 * t2);
+    m13 = -(m10 * t0 + m11 * t1 + m12 * t2);
+    m23 = -(m20 * t0 + m21 * t1 + m22 * t2);
+    return true;
+}
+
+float PMatrix3D::determinant() const
+{
+    float m[16], inv[16];
+    get(m);
+    adjugate(m, inv);
+    return m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+}
+
+bool PMatrix3D::isIdentity() const
+{
+    return *this == PMatrix3D();
+}
+
+bool PMatrix3D::operator==(const PMatrix3D &m) const
+{
+    float a[16], b[16];
+    get(a);
+    m.get(b);
+    for (int i = 0; i < 16; i++)
+        if (a[i] != b[i])
+            return false;
+    return true;
+}
+
+std::ostream & operator<<(std::ostream &os, const PMatrix3D &m)
+{
+    os << "[ " << m.m00 << ", " << m.m01 << ", " << m.m02 << ", " << m.m03 << " ]\n"
+       << "[ " << m.m10 << ", " << m.m11 << ", " << m.m12 << ", " << m.m13 << " ]\n"
+       << "[ " << m.m20 << ", " << m.m21 << ", " << m.m22 << ", " << m.m23 << " ]\n"
+       << "[ " << m.m30 << ", " << m.m31 << ", " << m.m32 << ", " << m.m33 << " ]\n";
+    return os;
+}
+
+/**
+ * PQuaternion class
+ */
+PQuaternion PQuaternion::fromAxisAngle(float angle, float v0, float v1, float v2)
+{
+    float norm = sqrtf(v0 * v0 + v1 * v1 + v2 * v2);
+    if (norm < 1e-6f)
+        return PQuaternion();
+    float s = sinf(angle / 2) / norm;
+    return PQuaternion(v0 * s, v1 * s, v2 * s, cosf(angle / 2));
+}
+
+PQuaternion PQuaternion::fromAxisAngle(float angle, const PVector &axis)
+{
+    return fromAxisAngle(angle, axis.x(), axis.y(), (axis.is3D() ? axis.z() : 0));
+}
+
+PQuaternion PQuaternion::fromMatrix(const PMatrix3D &m)
+{
+    // Divide by the largest of the four terms so nothing is lost to a
+    // small denominator
+    float trace = m.m00 + m.m11 + m.m22;
+    if (trace > 0)
+    {
+        float s = 0.5f / sqrtf(trace + 1);
+        return PQuaternion((m.m21 - m.m12) * s, (m.m02 - m.m20) * s, (m.m10 - m.m01) * s, 0.25f / s);
+    }
+    if (m.m00 > m.m11 && m.m00 > m.m22)
+    {
+        float s = 2 * sqrtf(1 + m.m00 - m.m11 - m.m22);
+        return PQuaternion(0.25f * s, (m.m01 + m.m10) / s, (m.m02 + m.m20) / s, (m.m21 - m.m12) / s);
+    }
+    if (m.m11 > m.m22)
+    {
+        float s = 2 * sqrtf(1 + m.m11 - m.m00 - m.m22);
+        return PQuaternion((m.m01 + m.m10) / s, 0.25f * s, (m.m12 + m.m21) / s, (m.m02 - m.m20) / s);
+    }
+    float s = 2 * sqrtf(1 + m.m22 - m.m00 - m.m11);
+    return PQuaternion((m.m02 + m.m20) / s, (m.m12 + m.m21) / s, 0.25f * s, (m.m10 - m.m01) / s);
+}
+
+PQuaternion PQuaternion::slerp(const PQuaternion &q1, const PQuaternion &q2, float amt)
+{
+    // q and -q are the same rotation, take the one on the shorter arc
+    float d = q1.dot(q2);
+    float sign = (d < 0 ? -1.0f : 1.0f);
+    d *= sign;
+    float a = 1 - amt;
+    float b = amt;
+    if (d < 0.9995f) // else so close that lerp is as good
+    {
+        float theta = acosf(d);
+        float s = sinf(theta);
+        a = sinf(a * theta) / s;
+        b = sinf(b * theta) / s;
+    }
+    b *= sign;
+    PQuaternion r(a * q1.x + b * q2.x, a * q1.y + b * q2.y, a * q1.z + b * q2.z, a * q1.w + b * q2.w);
+    r.normalize();
+    return r;
+}
+
+void PQuaternion::set(float nx, float ny, float nz, float nw)
+{
+    x = nx; y = ny; z = nz; w = nw;
+}
+
+// r = a * b, r may alias a or b
+static inline void multiply(const PQuaternion &a, const PQuaternion &b, PQuaternion &r)
+{
+#ifdef __SSE__
+    // b scaled by each component of a, shuffled and signed into place
+    __m128 q = _mm_loadu_ps(&b.x);
+    __m128 sum = _mm_mul_ps(_mm_set1_ps(a.w), q);
+    __m128 t = _mm_xor_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(0, 1, 2, 3)), _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a.x), t));
+    t = _mm_xor_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(1, 0, 3, 2)), _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a.y), t));
+    t = _mm_xor_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(2, 3, 0, 1)), _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a.z), t));
+    _mm_storeu_ps(&r.x, sum);
+#else
+    r.set(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+          a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+          a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+          a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+#endif
+}
+
+void PQuaternion::mult(const PQuaternion &q)
+{
+    multiply(*this, q, *this);
+}
+
+void PQuaternion::preMult(const PQuaternion &q)
+{
+    multiply(q, *this, *this);
+}
+
+bool PQuaternion::invert()
+{
+    float n = dot(*this);
+    if (n <= 1e-20f)
+        return false;
+    set(-x / n, -y / n, -z / n, w / n);
+    return true;
+}
+
+void PQuaternion::normalize()
+{
+    float m = mag();
+    if (m) // avoid devided by 0
+        set(x / m, y / m, z / m, w / m);
+}
+
+void PQuaternion::slerp(const PQuaternion &q, float amt)
+{
+    *this = slerp(*this, q, amt);
+}
+
+float PQuaternion::mag() const
+{
+    return sqrtf(dot(*this));
+}
+
+PMatrix3D PQuaternion::toMatrix() const
+{
+    float xx = x * x, yy = y * y, zz = z * z;
+    float xy = x * y, xz = x * z, yz = y * z;
+    float wx = w * x, wy = w * y, wz = w * z;
+    return PMatrix3D(1 - 2 * (yy + zz), 2 * (xy - wz), 2 * (xz + wy), 0,
+                     2 * (xy + wz), 1 - 2 * (xx + zz), 2 * (yz - wx), 0,
+                     2 * (xz - wy), 2 * (yz + wx), 1 - 2 * (xx + yy), 0,
+                     0, 0, 0, 1);
+}
+
+PVector PQuaternion::rotate(const PVector &source) const
+{
+    // With u = (x, y, z) and t = 2 u x v, v turns into v + w t + u x t
+    float vx = source.x();
+    float vy = source.y();
+    float vz = (source.is3D() ? source.z() : 0);
+    float tx = 2 * (y * vz - z * vy);
+    float ty = 2 * (z * vx - x * vz);
+    float tz = 2 * (x * vy - y * vx);
+    return PVector(vx + w * tx + (y * tz - z * ty),
+                   vy + w * ty + (z * tx - x * tz),
+                   vz + w * tz + (x * ty - y * tx));
+}
+
+void PQuaternion::rotate(const PVectorArray &source, PVectorArray &target) const
+{
+    // Nine multiplies a vector as a matrix against fifteen as a quaternion
+    toMatrix().mult(source, target);
+}
+
+PQuaternion PQuaternion::operator*(const PQuaternion &q) const
+{
+    PQuaternion r;
+    multiply(*this, q, r);
+    return r;
+}
+
+bool PQuaternion::operator==(const PQuaternion &q) const
+{
+    return (x == q.x && y == q.y && z == q.z && w == q.w);
+}
+
+std::ostream & operator<<(std::ostream &os, const PQuaternion &q)
+{
+    os << "[ " << q.x << ", " << q.y << ", " << q.z << ", " << q.w << " ]\n";
+    return os;
+}
+
+PROCESSING_END_NAMESPACE
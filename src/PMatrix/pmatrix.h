@@ -0,0 +1,170 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef PMATRIX_H
+#define PMATRIX_H
+
+#include "pglobal.h"
+#include "pvector.h"
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * 3x2 affine matrix, row major as in Processing:
+ *
+ *   m00 m01 m02
+ *   m10 m11 m12
+ */
+class PMatrix2D
+{
+public:
+    PMatrix2D();
+    PMatrix2D(float m00, float m01, float m02, float m10, float m11, float m12);
+
+    void reset();
+    void set(float m00, float m01, float m02, float m10, float m11, float m12);
+    void set(const PMatrix2D &m);
+    void get(float *target) const;
+
+    void translate(float tx, float ty);
+    void rotate(float angle);
+    void scale(float s);
+    void scale(float sx, float sy);
+    void shearX(float angle);
+    void shearY(float angle);
+
+    void apply(const PMatrix2D &m);
+    void apply(float n00, float n01, float n02, float n10, float n11, float n12);
+    void preApply(const PMatrix2D &m);
+    void preApply(float n00, float n01, float n02, float n10, float n11, float n12);
+
+    float multX(float x, float y) const { return m00 * x + m01 * y + m02; }
+    float multY(float x, float y) const { return m10 * x + m11 * y + m12; }
+    PVector mult(const PVector &source) const;
+    void mult(const float *source, float *target, int count) const;
+    void mult(const PVectorArray &source, PVectorArray &target) const;
+
+    bool invert();
+    float determinant() const { return m00 * m11 - m01 * m10; }
+    bool isIdentity() const;
+    bool isAxisAligned() const { return m01 == 0 && m10 == 0; }
+
+    bool operator==(const PMatrix2D &m) const;
+    bool operator!=(const PMatrix2D &m) const { return !(*this == m); }
+
+    friend std::ostream & operator<<(std::ostream &os, const PMatrix2D &);
+
+    float m00, m01, m02;
+    float m10, m11, m12;
+};
+
+/**
+ * 4x4 matrix, row major as in Processing. The rows are 16 byte aligned so
+ * they load straight into SSE registers.
+ */
+class alignas(16) PMatrix3D
+{
+public:
+    PMatrix3D();
+    PMatrix3D(float m00, float m01, float m02, float m03,
+              float m10, float m11, float m12, float m13,
+              float m20, float m21, float m22, float m23,
+              float m30, float m31, float m32, float m33);
+    explicit PMatrix3D(const PMatrix2D &m);
+
+    void reset();
+    void set(const float *source);
+    void set(const PMatrix3D &m);
+    void get(float *target) const;
+
+    void translate(float tx, float ty);
+    void translate(float tx, float ty, float tz);
+    void rotate(float angle) { rotateZ(angle); }
+    void rotate(float angle, float v0, float v1, float v2);
+    void rotateX(float angle);
+    void rotateY(float angle);
+    void rotateZ(float angle);
+    void scale(float s);
+    void scale(float sx, float sy);
+    void scale(float x, float y, float z);
+    void shearX(float angle);
+    void shearY(float angle);
+
+    void apply(const PMatrix2D &m);
+    void apply(const PMatrix3D &m);
+    void apply(float n00, float n01, float n02, float n03,
+               float n10, float n11, float n12, float n13,
+               float n20, float n21, float n22, float n23,
+               float n30, float n31, float n32, float n33);
+    void preApply(const PMatrix3D &m);
+
+    float multX(float x, float y, float z) const { return m00 * x + m01 * y + m02 * z + m03; }
+    float multY(float x, float y, float z) const { return m10 * x + m11 * y + m12 * z + m13; }
+    float multZ(float x, float y, float z) const { return m20 * x + m21 * y + m22 * z + m23; }
+    float multW(float x, float y, float z) const { return m30 * x + m31 * y + m32 * z + m33; }
+    PVector mult(const PVector &source) const;
+    void mult(const float *source, float *target, int count) const;
+    void mult(const PVectorArray &source, PVectorArray &target) const;
+
+    void transpose();
+    bool invert();
+    float determinant() const;
+    bool isIdentity() const;
+
+    bool operator==(const PMatrix3D &m) const;
+    bool operator!=(const PMatrix3D &m) const { return !(*this == m); }
+
+    friend std::ostream & operator<<(std::ostream &os, const PMatrix3D &);
+
+    float m00, m01, m02, m03;
+    float m10, m11, m12, m13;
+    float m20, m21, m22, m23;
+    float m30, m31, m32, m33;
+
+private:
+    bool invertAffine();
+};
+
+/**
+ * Rotation quaternion, x y z the axis scaled by sin(angle / 2) and w
+ * cos(angle / 2). Rotations compose with mult() and blend with slerp()
+ * without the drift of chained matrices. rotate() and toMatrix() take
+ * the quaternion as a unit one, normalize() after many mult().
+ */
+class alignas(16) PQuaternion
+{
+public:
+    PQuaternion() : x(0), y(0), z(0), w(1) {}
+    PQuaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+    static PQuaternion fromAxisAngle(float angle, float v0, float v1, float v2);
+    static PQuaternion fromAxisAngle(float angle, const PVector &axis);
+    static PQuaternion fromMatrix(const PMatrix3D &m);
+    static PQuaternion slerp(const PQuaternion &q1, const PQuaternion &q2, float amt);
+
+    void set(float x, float y, float z, float w);
+    void mult(const PQuaternion &q);
+    void preMult(const PQuaternion &q);
+    void conjugate() { x = -x; y = -y; z = -z; }
+    bool invert();
+    void normalize();
+    void slerp(const PQuaternion &q, float amt);
+
+    float dot(const PQuaternion &q) const { return x * q.x + y * q.y + z * q.z + w * q.w; }
+    float mag() const;
+    PMatrix3D toMatrix() const;
+    PVector rotate(const PVector &source) const;
+    void rotate(const PVectorArray &source, PVectorArray &target) const;
+
+    PQuaternion operator*(const PQuaternion &q) const;
+    bool operator==(const PQuaternion &q) const;
+    bool operator!=(const PQuaternion &q) const { return !(*this == q); }
+
+    friend std::ostream & operator<<(std::ostream &os, const PQuaternion &);
+
+    float x, y, z, w;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // PMATRIX_H
@@ -0,0 +1,3 @@
+# Author: Gary Huang <gh.nctu+code@gmail.com>
+HEADERS += $$PWD/pmatrix.h
+SOURCES += $$PWD/pmatrix.cpp
@@ -0,0 +1,195 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "pshape.h"
+#include <atomic>
+#include <cstring>
+#include <cmath>
+
+PROCESSING_BEGIN_NAMESPACE
+
+// Keys of paths count up, keys of primitives hash their parameters and
+// have the top bit set
+#define P_SHAPE_PRIMITIVE_KEY (1ULL << 63)
+
+static std::atomic<unsigned long long> nextKey(1);
+
+static int expectedParams(ShapeFamily family, int count)
+{
+    switch (family)
+    {
+    case POINT:
+        return 2;
+    case LINE:
+    case ELLIPSE:
+        return 4;
+    case TRIANGLE:
+    case ARC:
+        return 6;
+    case QUAD:
+        return 8;
+    case RECT:
+        return (count == 5 || count == 8 ? count : 4);
+    case PATH:
+        break;
+    }
+    return -1;
+}
+
+static unsigned long long fnv(unsigned long long hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char *) data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+PShape::PShape()
+    : family(PATH), kind(POLYGON), endMode(END_OPEN), arcMode(OPEN),
+      key(nextKey++), editing(false)
+{
+}
+
+PShape::PShape(ShapeFamily family, const float *params_, int count, ArcMode mode)
+    : family(family), kind(POLYGON), endMode(CLOSE), arcMode(mode),
+      params(params_, params_ + count), editing(false)
+{
+    if (family == PATH)
+        throw "createShape(): a path is built with beginShape() and vertex()";
+    if (count != expectedParams(family, count))
+        throw "createShape(): wrong number of parameters for the shape";
+    key = cacheKey(family, params_, count, mode);
+}
+
+unsigned long long PShape::cacheKey(ShapeFamily family, const float *params, int count, ArcMode mode)
+{
+    // FNV-1a over the family, the arc mode and the parameter bits
+    unsigned long long hash = 14695981039346656037ULL;
+    int header[2] = { family, mode };
+    hash = fnv(hash, header, sizeof(header));
+    hash = fnv(hash, params, count * sizeof(float));
+    return hash | P_SHAPE_PRIMITIVE_KEY;
+}
+
+void PShape::beginShape(ShapeKind kind_)
+{
+    if (family != PATH)
+        throw "beginShape(): only a shape from createShape() takes vertices";
+    kind = kind_;
+    vertices.clear();
+    editing = true;
+}
+
+void PShape::vertex(float x, float y)
+{
+    if (!editing)
+        throw "vertex(): call beginShape() on the shape first";
+    vertices.push_back(x);
+    vertices.push_back(y);
+}
+
+void PShape::endShape(EndMode mode)
+{
+    if (!editing)
+        throw "endShape(): call beginShape() on the shape first";
+    endMode = mode;
+    editing = false;
+    touch();
+}
+
+PVector PShape::getVertex(int index) const
+{
+    if (index < 0 || index >= getVertexCount())
+        throw "getVertex(): index out of range";
+    return PVector(vertices[2 * index], vertices[2 * index + 1]);
+}
+
+void PShape::setVertex(int index, float x, float y)
+{
+    if (index < 0 || index >= getVertexCount())
+        throw "setVertex(): index out of range";
+    vertices[2 * index] = x;
+    vertices[2 * index + 1] = y;
+    touch();
+}
+
+void PShape::touch()
+{
+    key = nextKey++;
+}
+
+void PShape::bounds(float &minX, float &minY, float &maxX, float &maxY) const
+{
+    minX = minY = maxX = maxY = 0;
+    const std::vector<float> &points = (family == PATH ? vertices : params);
+    int count = points.size() / 2;
+    switch (family)
+    {
+    case RECT:
+    case ELLIPSE:
+    case ARC:
+        // Only the size matters here
+        maxX = std::fabs(params[2]);
+        maxY = std::fabs(params[3]);
+        return;
+    default:
+        break;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        float x = points[2 * i];
+        float y = points[2 * i + 1];
+        if (i == 0 || x < minX)
+            minX = x;
+        if (i == 0 || x > maxX)
+            maxX = x;
+        if (i == 0 || y < minY)
+            minY = y;
+        if (i == 0 || y > maxY)
+            maxY = y;
+    }
+}
+
+float PShape::getWidth() const
+{
+    float minX, minY, maxX, maxY;
+    bounds(minX, minY, maxX, maxY);
+    return maxX - minX;
+}
+
+float PShape::getHeight() const
+{
+    float minX, minY, maxX, maxY;
+    bounds(minX, minY, maxX, maxY);
+    return maxY - minY;
+}
+
+void PShape::translate(float x, float y)
+{
+    matrix.translate(x, y);
+}
+
+void PShape::rotate(float angle)
+{
+    matrix.rotate(angle);
+}
+
+void PShape::scale(float s)
+{
+    matrix.scale(s);
+}
+
+void PShape::scale(float x, float y)
+{
+    matrix.scale(x, y);
+}
+
+void PShape::resetMatrix()
+{
+    matrix.reset();
+}
+
+PROCESSING_END_NAMESPACE
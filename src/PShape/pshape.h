@@ -0,0 +1,76 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef PSHAPE_H
+#define PSHAPE_H
+
+#include "pglobal.h"
+#include "pvector.h"
+#include "pmatrix.h"
+#include <vector>
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * Retained geometry, drawn with shape(). Renderers flatten a shape once
+ * and keep the result under cacheKey(), so drawing the same shape again,
+ * under any transform, skips building it.
+ *
+ * Primitives take their parameters as rect() with CORNER, ellipse() with
+ * CENTER and arc() do. A shape is drawn with the current fill and stroke.
+ */
+class PShape
+{
+public:
+    PShape();
+    PShape(ShapeFamily family, const float *params, int count, ArcMode mode=OPEN);
+
+    void beginShape(ShapeKind kind=POLYGON);
+    void vertex(float x, float y);
+    void endShape(EndMode mode=END_OPEN);
+
+    ShapeFamily getFamily() const { return family; }
+    ShapeKind getKind() const { return kind; }
+    EndMode getEndMode() const { return endMode; }
+    ArcMode getArcMode() const { return arcMode; }
+    const std::vector<float> & getParams() const { return params; }
+
+    // Vertices of a PATH as x, y pairs
+    const std::vector<float> & getVertices() const { return vertices; }
+    int getVertexCount() const { return vertices.size() / 2; }
+    PVector getVertex(int index) const;
+    void setVertex(int index, float x, float y);
+
+    float getWidth() const;
+    float getHeight() const;
+
+    void translate(float x, float y);
+    void rotate(float angle);
+    void scale(float s);
+    void scale(float x, float y);
+    void resetMatrix();
+    const PMatrix2D & getMatrix() const { return matrix; }
+
+    // Changes whenever the geometry does. Primitives with equal
+    // parameters share theirs.
+    unsigned long long cacheKey() const { return key; }
+    static unsigned long long cacheKey(ShapeFamily family, const float *params, int count, ArcMode mode);
+
+private:
+    void bounds(float &minX, float &minY, float &maxX, float &maxY) const;
+    void touch();
+
+    ShapeFamily family;
+    ShapeKind kind;
+    EndMode endMode;
+    ArcMode arcMode;
+    std::vector<float> params;
+    std::vector<float> vertices;
+    PMatrix2D matrix;
+    unsigned long long key;
+    bool editing;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // PSHAPE_H
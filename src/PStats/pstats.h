@@ -0,0 +1,48 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef PSTATS_H
+#define PSTATS_H
+
+#include "pglobal.h"
+#include <cstddef>
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * Per-frame rendering statistics, times are in milliseconds
+ */
+struct PStats
+{
+    PStats()
+        : frameCount(0), frameBudget(0), drawTime(0), presentTime(0),
+          averageFrameTime(0), quality(QUALITY_FULL), skippedFrames(0),
+          bufferBytes(0), setupTime(0), drawCalls(0), primitives(0),
+          drawnShapes(0), culledShapes(0) {}
+
+    int frameCount;
+    float frameBudget;
+    float drawTime;
+    float presentTime;
+    float averageFrameTime;
+    Quality quality;
+    int skippedFrames;
+
+    // Memory held by the frame buffer and the time its setup took, both
+    // stay 0 for a GL renderer until something is drawn
+    size_t bufferBytes;
+    float setupTime;
+
+    // Filled in by the batching GL renderer only
+    int drawCalls;
+    int primitives;
+
+    // 2D shapes handed to the renderer and those rejected because their
+    // bounds lie outside the canvas
+    int drawnShapes;
+    int culledShapes;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // PSTATS_H
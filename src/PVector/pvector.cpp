@@ -2,6 +2,7 @@
  * Author: Gary Huang <gh.nctu+code@gmail.com>
  */
 #include "pvector.h"
+#include "fastmath.h"
 #include <qatomic.h>
 #include <iostream>
 #include <cmath>
@@ -12,6 +13,19 @@ float random(float high);
 float random(float low, float high);
 void randomSeed(int seed);
 
+static bool fastTrig = false;
+
+static void sinCos(float theta, float &s, float &c)
+{
+    if (fastTrig)
+    {
+        fastSinCos(theta, s, c);
+        return;
+    }
+    s = sin(theta);
+    c = cos(theta);
+}
+
 class PVectorPrivate
 {
 public:
@@ -222,8 +236,10 @@ void PVector2D::setMag(float len)
 
 void PVector2D::rotate(float theta)
 {
-    float new_x = m_x * cos(theta) - m_y * sin(theta);
-    float new_y = m_x * sin(theta) + m_y * cos(theta);
+    float s, c;
+    sinCos(theta, s, c);
+    float new_x = m_x * c - m_y * s;
+    float new_y = m_x * s + m_y * c;
     m_x = new_x;
     m_y = new_y;
 }
@@ -365,6 +381,37 @@ PVector & PVector::operator=(const PVector &v)
     return *this;
 }
 
+PVector & PVector::assign(const PVectorValue &v)
+{
+    // Reuse the storage unless another PVector shares it
+#if QT_VERSION >= 0x050E00
+    int refs = (impl ? impl->ref.loadRelaxed() : 0);
+#else
+    int refs = (impl ? impl->ref.load() : 0);
+#endif
+    if (refs == 1 && impl->type() == v.type())
+    {
+        if (v.type() == PVector::V3D)
+            impl->set(v.x(0), v.y(0), v.z(0));
+        else
+            impl->set(v.x(0), v.y(0));
+        return (*this);
+    }
+    switch (v.type())
+    {
+        case PVector::None:
+            (*this) = PVector();
+            break;
+        case PVector::V2D:
+            (*this) = PVector(v.x(0), v.y(0));
+            break;
+        case PVector::V3D:
+            (*this) = PVector(v.x(0), v.y(0), v.z(0));
+            break;
+    }
+    return (*this);
+}
+
 bool PVector::operator==(const PVector &v) const
 {
     return (impl == v.impl);
@@ -844,8 +891,8 @@ PVector PVector::random3D(PVector *target)
 
 PVector PVector::fromAngle(float angle)
 {
-    float x = cos(angle);
-    float y = sin(angle);
+    float y, x;
+    sinCos(angle, y, x);
     PVector temp(new PVector2D(x, y));
     return temp;
 }
@@ -864,6 +911,16 @@ float PVector::angleBetween(const PVector &v1, const PVector &v2)
     return (ab ? acos(v1.dot(v2) / ab) : M_PI_2);
 }
 
+void PVector::setFastTrig(bool enable)
+{
+    fastTrig = enable;
+}
+
+bool PVector::isFastTrig()
+{
+    return fastTrig;
+}
+
 std::ostream & operator<<(std::ostream &os, const PVector &v)
 {
     os << "[ " << v.x()
@@ -874,4 +931,99 @@ std::ostream & operator<<(std::ostream &os, const PVector &v)
     return os;
 }
 
+PVectorArray::PVectorArray(int size, PVector::Type type)
+    : m_type(PVector::V2D)
+{
+    setType(type);
+    resize(size);
+}
+
+PVectorArray & PVectorArray::operator*=(float n)
+{
+    for (size_t i = 0; i < xs.size(); i++)
+    {
+        xs[i] *= n;
+        ys[i] *= n;
+    }
+    for (size_t i = 0; i < zs.size(); i++)
+        zs[i] *= n;
+    return (*this);
+}
+
+PVectorArray & PVectorArray::operator/=(float n)
+{
+    if (n == 0.0)
+        throw "divided by zero";
+    for (size_t i = 0; i < xs.size(); i++)
+    {
+        xs[i] /= n;
+        ys[i] /= n;
+    }
+    for (size_t i = 0; i < zs.size(); i++)
+        zs[i] /= n;
+    return (*this);
+}
+
+void PVectorArray::resize(int size)
+{
+    if (size < 0)
+        throw "PVectorArray::resize(): size must not be negative";
+    xs.resize(size);
+    ys.resize(size);
+    zs.resize(m_type == PVector::V3D ? size : 0);
+}
+
+void PVectorArray::resize(int size, PVector::Type type)
+{
+    setType(type);
+    resize(size);
+}
+
+void PVectorArray::setType(PVector::Type type)
+{
+    if (type == PVector::None)
+        throw "PVectorArray: vectors must be 2D or 3D";
+    m_type = type;
+    zs.resize(m_type == PVector::V3D ? xs.size() : 0);
+}
+
+PVector PVectorArray::get(int i) const
+{
+    if (i < 0 || i >= size())
+        throw "PVectorArray::get(): index out of range";
+    if (m_type == PVector::V3D)
+        return PVector(xs[i], ys[i], zs[i]);
+    return PVector(xs[i], ys[i]);
+}
+
+void PVectorArray::set(int i, float x, float y)
+{
+    if (i < 0 || i >= size())
+        throw "PVectorArray::set(): index out of range";
+    xs[i] = x;
+    ys[i] = y;
+    if (m_type == PVector::V3D)
+        zs[i] = 0.0f;
+}
+
+void PVectorArray::set(int i, float x, float y, float z)
+{
+    if (i < 0 || i >= size())
+        throw "PVectorArray::set(): index out of range";
+    xs[i] = x;
+    ys[i] = y;
+    if (m_type == PVector::V3D)
+        zs[i] = z;
+}
+
+void PVectorArray::set(int i, const PVector &v)
+{
+    if (v.type() != m_type)
+        throw "PVectorArray::set(): can't set vector between 2D and 3D";
+    if (m_type == PVector::V3D)
+        set(i, v.x(), v.y(), v.z());
+    else
+        set(i, v.x(), v.y());
+}
+
 PROCESSING_END_NAMESPACE
\ No newline at end of file
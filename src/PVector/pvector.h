@@ -10,8 +10,30 @@
 PROCESSING_BEGIN_NAMESPACE
 
 class PVectorPrivate;
+class PVectorValue;
 
-class PVector
+/**
+ * Base of everything that takes part in a vector expression, a PVector, a
+ * PVectorArray or the result of an operator on them. The operators below
+ * return small structs that only record their operands, and nothing is
+ * computed until the expression is stored, so
+ *
+ *     position = position + velocity * dt;
+ *
+ * runs as one pass over x, y and z with no temporary vectors. A PVector
+ * in an expression with a PVectorArray is applied to every element.
+ *
+ * An expression keeps references to the arrays in it, store it before the
+ * end of the statement and not in an auto variable.
+ */
+template <class E>
+class PVectorExpression
+{
+public:
+    const E & self() const { return static_cast<const E &>(*this); }
+};
+
+class PVector : public PVectorExpression<PVector>
 {
 public:
     enum Type { None, V2D, V3D };
@@ -22,7 +44,13 @@ public:
     PVector(float x, float y, float z);
     PVector(const PVector &);
     PVector(PVectorPrivate *);
+    template <class E> PVector(const PVectorExpression<E> &e);
     PVector & operator=(const PVector &);
+    template <class E> PVector & operator=(const PVectorExpression<E> &e);
+    template <class E> PVector & operator+=(const PVectorExpression<E> &e);
+    template <class E> PVector & operator-=(const PVectorExpression<E> &e);
+    PVector & operator*=(float n) { return mult(n); }
+    PVector & operator/=(float n) { return div(n); }
     bool operator==(const PVector &) const;
     bool operator!=(const PVector &) const;
     ~PVector();
@@ -89,13 +117,280 @@ public:
     static PVector fromAngle(float angle, PVector *target);
     static float angleBetween(const PVector &v1, const PVector &v2);
 
+    // rotate() and fromAngle() use fastSinCos() while this is on
+    static void setFastTrig(bool enable);
+    static bool isFastTrig();
+
     friend std::ostream & operator<<(std::ostream &os, const PVector &);
 
 private:
+    PVector & assign(const PVectorValue &v);
+
     PVectorPrivate *impl;
     bool verbose;
 };
 
+/**
+ * An array of 2D or 3D vectors kept as one array per component, so
+ * expressions on it run as plain loops the compiler can vectorize.
+ * get() makes a PVector of one element.
+ */
+class PVectorArray : public PVectorExpression<PVectorArray>
+{
+public:
+    explicit PVectorArray(int size=0, PVector::Type type=PVector::V2D);
+    template <class E> PVectorArray(const PVectorExpression<E> &e);
+    template <class E> PVectorArray & operator=(const PVectorExpression<E> &e);
+    template <class E> PVectorArray & operator+=(const PVectorExpression<E> &e);
+    template <class E> PVectorArray & operator-=(const PVectorExpression<E> &e);
+    PVectorArray & operator*=(float n);
+    PVectorArray & operator/=(float n);
+
+    PVector::Type type() const { return m_type; }
+    bool is2D() const { return m_type == PVector::V2D; }
+    bool is3D() const { return m_type == PVector::V3D; }
+    int size() const { return (int) xs.size(); }
+    void resize(int size);
+    void resize(int size, PVector::Type type);
+
+    float x(int i) const { return xs[i]; }
+    float y(int i) const { return ys[i]; }
+    float z(int i) const { return zs[i]; }
+    float * xData() { return xs.data(); }
+    float * yData() { return ys.data(); }
+    float * zData() { return zs.data(); }
+    const float * xData() const { return xs.data(); }
+    const float * yData() const { return ys.data(); }
+    const float * zData() const { return zs.data(); }
+
+    PVector get(int i) const;
+    void set(int i, float x, float y);
+    void set(int i, float x, float y, float z);
+    void set(int i, const PVector &v);
+
+private:
+    template <class Op, class E> void combine(const E &e);
+    void setType(PVector::Type type);
+
+    PVector::Type m_type;
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<float> zs;
+};
+
+// A PVector read once into an expression, size() -1 means it applies to
+// every element of the arrays beside it, an empty array being size() 0
+class PVectorValue : public PVectorExpression<PVectorValue>
+{
+public:
+    PVectorValue(const PVector &v)
+        : t(v.type()), vx(v.x()), vy(v.y()), vz(v.is3D() ? v.z() : 0.0f) {}
+    template <class E> PVectorValue(const PVectorExpression<E> &e);
+
+    PVector::Type type() const { return t; }
+    int size() const { return -1; }
+    float x(int) const { return vx; }
+    float y(int) const { return vy; }
+    float z(int) const { return vz; }
+
+private:
+    PVector::Type t;
+    float vx;
+    float vy;
+    float vz;
+};
+
+// Operands of an expression, vectors by value and arrays by reference
+template <class E> struct PVectorOperand { typedef E Type; };
+template <> struct PVectorOperand<PVector> { typedef PVectorValue Type; };
+template <> struct PVectorOperand<PVectorArray> { typedef const PVectorArray & Type; };
+
+struct PVectorAssign { static float apply(float, float b) { return b; } };
+struct PVectorAdd { static float apply(float a, float b) { return a + b; } };
+struct PVectorSub { static float apply(float a, float b) { return a - b; } };
+struct PVectorMult { static float apply(float a, float b) { return a * b; } };
+struct PVectorDiv { static float apply(float a, float b) { return a / b; } };
+
+template <class Op, class A, class B>
+class PVectorBinary : public PVectorExpression<PVectorBinary<Op, A, B> >
+{
+public:
+    PVectorBinary(const A &a, const B &b)
+        : a(a), b(b)
+    {
+        if (this->a.type() != this->b.type())
+            throw "PVector: can't combine vectors between 2D and 3D";
+        if (this->a.size() >= 0 && this->b.size() >= 0 && this->a.size() != this->b.size())
+            throw "PVectorArray: can't combine arrays of different sizes";
+    }
+
+    PVector::Type type() const { return a.type(); }
+    int size() const { return (a.size() >= 0 ? a.size() : b.size()); }
+    float x(int i) const { return Op::apply(a.x(i), b.x(i)); }
+    float y(int i) const { return Op::apply(a.y(i), b.y(i)); }
+    float z(int i) const { return Op::apply(a.z(i), b.z(i)); }
+
+private:
+    typename PVectorOperand<A>::Type a;
+    typename PVectorOperand<B>::Type b;
+};
+
+template <class Op, class A>
+class PVectorScalar : public PVectorExpression<PVectorScalar<Op, A> >
+{
+public:
+    PVectorScalar(const A &a, float n) : a(a), n(n) {}
+
+    PVector::Type type() const { return a.type(); }
+    int size() const { return a.size(); }
+    float x(int i) const { return Op::apply(a.x(i), n); }
+    float y(int i) const { return Op::apply(a.y(i), n); }
+    float z(int i) const { return Op::apply(a.z(i), n); }
+
+private:
+    typename PVectorOperand<A>::Type a;
+    float n;
+};
+
+template <class A, class B>
+inline PVectorBinary<PVectorAdd, A, B> operator+(const PVectorExpression<A> &a, const PVectorExpression<B> &b)
+{
+    return PVectorBinary<PVectorAdd, A, B>(a.self(), b.self());
+}
+
+template <class A, class B>
+inline PVectorBinary<PVectorSub, A, B> operator-(const PVectorExpression<A> &a, const PVectorExpression<B> &b)
+{
+    return PVectorBinary<PVectorSub, A, B>(a.self(), b.self());
+}
+
+template <class A>
+inline PVectorScalar<PVectorMult, A> operator-(const PVectorExpression<A> &a)
+{
+    return PVectorScalar<PVectorMult, A>(a.self(), -1.0f);
+}
+
+template <class A>
+inline PVectorScalar<PVectorMult, A> operator*(const PVectorExpression<A> &a, float n)
+{
+    return PVectorScalar<PVectorMult, A>(a.self(), n);
+}
+
+template <class A>
+inline PVectorScalar<PVectorMult, A> operator*(float n, const PVectorExpression<A> &a)
+{
+    return PVectorScalar<PVectorMult, A>(a.self(), n);
+}
+
+template <class A>
+inline PVectorScalar<PVectorDiv, A> operator/(const PVectorExpression<A> &a, float n)
+{
+    if (n == 0.0f)
+        throw "divided by zero";
+    return PVectorScalar<PVectorDiv, A>(a.self(), n);
+}
+
+template <class E>
+PVectorValue::PVectorValue(const PVectorExpression<E> &e)
+{
+    const E &v = e.self();
+    if (v.size() >= 0)
+        throw "PVector: can't store an array expression in a vector";
+    t = v.type();
+    vx = v.x(0);
+    vy = v.y(0);
+    vz = (t == PVector::V3D ? v.z(0) : 0.0f);
+}
+
+template <class E>
+PVector::PVector(const PVectorExpression<E> &e)
+    : impl(0), verbose(1)
+{
+    assign(PVectorValue(e.self()));
+}
+
+template <class E>
+PVector & PVector::operator=(const PVectorExpression<E> &e)
+{
+    return assign(PVectorValue(e.self()));
+}
+
+template <class E>
+PVector & PVector::operator+=(const PVectorExpression<E> &e)
+{
+    PVectorValue v(e.self());
+    if (v.type() != type())
+        throw "PVector::add(): can't add vector between 2D and 3D";
+    return (is3D() ? add(v.x(0), v.y(0), v.z(0)) : add(v.x(0), v.y(0)));
+}
+
+template <class E>
+PVector & PVector::operator-=(const PVectorExpression<E> &e)
+{
+    PVectorValue v(e.self());
+    if (v.type() != type())
+        throw "PVector::sub(): can't sub vector between 2D and 3D";
+    return (is3D() ? sub(v.x(0), v.y(0), v.z(0)) : sub(v.x(0), v.y(0)));
+}
+
+template <class E>
+PVectorArray::PVectorArray(const PVectorExpression<E> &e)
+    : m_type(PVector::V2D)
+{
+    (*this) = e;
+}
+
+template <class E>
+PVectorArray & PVectorArray::operator=(const PVectorExpression<E> &e)
+{
+    // Sizes can only differ when the array is not in the expression
+    typename PVectorOperand<E>::Type v(e.self());
+    setType(v.type());
+    if (v.size() >= 0)
+        resize(v.size());
+    combine<PVectorAssign>(v);
+    return (*this);
+}
+
+template <class E>
+PVectorArray & PVectorArray::operator+=(const PVectorExpression<E> &e)
+{
+    typename PVectorOperand<E>::Type v(e.self());
+    combine<PVectorAdd>(v);
+    return (*this);
+}
+
+template <class E>
+PVectorArray & PVectorArray::operator-=(const PVectorExpression<E> &e)
+{
+    typename PVectorOperand<E>::Type v(e.self());
+    combine<PVectorSub>(v);
+    return (*this);
+}
+
+template <class Op, class E>
+void PVectorArray::combine(const E &e)
+{
+    if (e.type() != m_type)
+        throw "PVectorArray: can't combine vectors between 2D and 3D";
+    if (e.size() >= 0 && e.size() != size())
+        throw "PVectorArray: can't combine arrays of different sizes";
+    int n = size();
+    float *px = xs.data();
+    float *py = ys.data();
+    for (int i = 0; i < n; i++)
+    {
+        px[i] = Op::apply(px[i], e.x(i));
+        py[i] = Op::apply(py[i], e.y(i));
+    }
+    if (m_type == PVector::V3D)
+    {
+        float *pz = zs.data();
+        for (int i = 0; i < n; i++)
+            pz[i] = Op::apply(pz[i], e.z(i));
+    }
+}
+
 PROCESSING_END_NAMESPACE
 
 #endif // PVECTOR_H
@@ -6,14 +6,27 @@
 #define P_USE_USER_MAIN
 #include "processing.h"
 #include "guiengine.h"
+#include "pmatrix.h"
+#include "pshape.h"
+#include "pfont.h"
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 PROCESSING_BEGIN_NAMESPACE
 
 int width;
 int height;
+int pixelWidth;
+int pixelHeight;
 int frameRate;
+unsigned int *pixels;
 Args args;
 
 static const char *const title = "Processing";
@@ -34,6 +47,8 @@ int Processing::exec(int argc, char *argv[], PFunctions &callbacks)
     frameRate = P_FRAMERATE_DEFAULT;
     width = P_WIDTH_DEFAULT;
     height = P_HEIGHT_DEFAULT;
+    pixelWidth = width;
+    pixelHeight = height;
     renderer = PDEFAULT;
 
     engine = GuiEngine::create(GuiEngine::Qt, argc, argv);
@@ -74,11 +89,21 @@ void exit()
     engine->quit();
 }
 
+bool isLooping()
+{
+    return window->isLooping();
+}
+
 void loop()
 {
     window->loop();
 }
 
+void loopOnInput()
+{
+    window->loopOnInput();
+}
+
 void noLoop()
 {
     window->noLoop();
@@ -94,6 +119,11 @@ void popStyle()
     canvas->popStyle();
 }
 
+void redraw()
+{
+    window->redraw();
+}
+
 void size(int w, int h, enum Renderer r)
 {
     if (!canvas)
@@ -104,6 +134,8 @@ void size(int w, int h, enum Renderer r)
             h = P_HEIGHT_MINIMUM;
         width = w;
         height = h;
+        pixelWidth = w;
+        pixelHeight = h;
         renderer = r;
         // for drawings in setup()
         window->setFixedSize(width, height);
@@ -119,6 +151,115 @@ void setFrameRate(int fps)
     frameRate = fps;
 }
 
+void windowResizable(bool resizable)
+{
+    window->setResizable(resizable);
+}
+
+void adaptiveQuality(bool enable)
+{
+    canvas->adaptiveQuality(enable);
+}
+
+int displayDensity()
+{
+    return canvas->displayDensity();
+}
+
+void pixelDensity(int density)
+{
+    if (density < 1)
+        density = 1;
+    canvas->pixelDensity(density);
+    pixelWidth = width * density;
+    pixelHeight = height * density;
+}
+
+void renderScale(float scale)
+{
+    canvas->renderScale(scale);
+}
+
+void smooth(int level)
+{
+    canvas->smooth(level);
+}
+
+void noSmooth()
+{
+    canvas->noSmooth();
+}
+
+void saveFrame()
+{
+    canvas->saveFrame("screen-####.png");
+}
+
+void saveFrame(const char *filename)
+{
+    canvas->saveFrame(filename);
+}
+
+void loadPixels()
+{
+    pixels = canvas->loadPixels();
+}
+
+void updatePixels()
+{
+    canvas->updatePixels();
+}
+
+void clip(float a, float b, float c, float d)
+{
+    canvas->clip(a, b, c, d);
+}
+
+void noClip()
+{
+    canvas->noClip();
+}
+
+PFont createFont(const std::string &name, float size, bool smooth)
+{
+    return PFont(name, size, smooth);
+}
+
+void text(const std::string &str, float x, float y)
+{
+    canvas->text(str, x, y);
+}
+
+void textFont(const PFont &font)
+{
+    canvas->textFont(font, font.getSize());
+}
+
+void textFont(const PFont &font, float size)
+{
+    canvas->textFont(font, size);
+}
+
+void textSize(float size)
+{
+    canvas->textSize(size);
+}
+
+float textWidth(const std::string &str)
+{
+    return canvas->textWidth(str);
+}
+
+Quality quality()
+{
+    return canvas->quality();
+}
+
+const PStats & frameStats()
+{
+    return canvas->getStats();
+}
+
 void arc(float a, float b, float c, float d, float start, float stop, ArcMode mode)
 {
     canvas->arc(a, b, c, d, start, stop, mode);
@@ -164,9 +305,119 @@ void triangle(float x1, float y1, float x2, float y2, float x3, float y3)
     canvas->triangle(x1, y1, x2, y2, x3, y3);
 }
 
+void box(float size)
+{
+    canvas->box(size, size, size);
+}
+
+void box(float w, float h, float d)
+{
+    canvas->box(w, h, d);
+}
+
+void sphere(float r)
+{
+    canvas->sphere(r);
+}
+
+void sphereDetail(int res)
+{
+    canvas->sphereDetail(res);
+}
+
+PShape createShape()
+{
+    return PShape();
+}
+
+PShape createShape(ShapeFamily family, float a, float b)
+{
+    float params[2] = { a, b };
+    return PShape(family, params, 2);
+}
+
+PShape createShape(ShapeFamily family, float a, float b, float c, float d)
+{
+    float params[4] = { a, b, c, d };
+    return PShape(family, params, 4);
+}
+
+PShape createShape(ShapeFamily family, float a, float b, float c, float d, float e)
+{
+    float params[5] = { a, b, c, d, e };
+    return PShape(family, params, 5);
+}
+
+PShape createShape(ShapeFamily family, float a, float b, float c, float d, float e, float f, ArcMode mode)
+{
+    float params[6] = { a, b, c, d, e, f };
+    return PShape(family, params, 6, mode);
+}
+
+PShape createShape(ShapeFamily family, float a, float b, float c, float d, float e, float f, float g, float h)
+{
+    float params[8] = { a, b, c, d, e, f, g, h };
+    return PShape(family, params, 8);
+}
+
+void shape(const PShape &s, float x, float y)
+{
+    canvas->shape(s, x, y);
+}
+
+void shape(const PShape &s, float a, float b, float c, float d)
+{
+    canvas->shape(s, a, b, c, d);
+}
+
+void bezier(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4)
+{
+    canvas->bezier(x1, y1, x2, y2, x3, y3, x4, y4);
+}
+
+void curve(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4)
+{
+    canvas->curve(x1, y1, x2, y2, x3, y3, x4, y4);
+}
+
+void curveTightness(float tightness)
+{
+    canvas->curveTightness(tightness);
+}
+
+void beginShape(ShapeKind kind)
+{
+    canvas->beginShape(kind);
+}
+
+void bezierVertex(float x2, float y2, float x3, float y3, float x4, float y4)
+{
+    canvas->bezierVertex(x2, y2, x3, y3, x4, y4);
+}
+
+void curveVertex(float x, float y)
+{
+    canvas->curveVertex(x, y);
+}
+
+void endShape(EndMode mode)
+{
+    canvas->endShape(mode);
+}
+
+void vertex(float x, float y)
+{
+    canvas->vertex(x, y);
+}
+
+void vertex(float x, float y, float z)
+{
+    canvas->vertex(x, y, z);
+}
+
 void background(color c)
 {
-    canvas->background(red(c), green(c), blue(c), alpha(c));
+    canvas->backgroundARGB(c.argb());
 }
 
 void background(int rgb)
@@ -196,7 +447,7 @@ void colorMode(ColorMode mode, float max1, float max2, float max3, float maxA)
 
 void fill(color c)
 {
-    canvas->fill(red(c), green(c), blue(c), alpha(c));
+    canvas->fillARGB(c.argb());
 }
 
 void fill(int gray, int alpha)
@@ -216,7 +467,7 @@ void noFill()
 
 void stroke(color c)
 {
-    canvas->stroke(red(c), green(c), blue(c), alpha(c));
+    canvas->strokeARGB(c.argb());
 }
 
 void stroke(int gray, int alpha)
@@ -234,113 +485,128 @@ void noStroke()
     canvas->noStroke();
 }
 
-float alpha(color rgb)
+// Before setup() there is no canvas yet, and the ranges are the defaults
+static const ColorSpace & colorSpace()
 {
-    return rgb.data.alpha;
+    static const ColorSpace defaults;
+    return canvas ? canvas->colorSpace() : defaults;
 }
 
-float blue(color rgb)
+static float hsb(color rgb, int channel)
 {
-    return rgb.data.v3;
+    float values[3];
+    colorSpace().toHSB(rgb.argb(), values);
+    return values[channel];
 }
 
 float brightness(color rgb)
 {
-    return rgb.data.v3;
+    return hsb(rgb, 2);
 }
 
-color::color(int v1, int v2, int v3, int alpha)
+void colors(const float *values, int channels, int count, unsigned int *out)
 {
-    data.v1 = v1;
-    data.v2 = v2;
-    data.v3 = v3;
-    data.alpha = alpha;
+    if (channels != 3 && channels != 4)
+        throw "colors(): channels must be 3 or 4";
+    colorSpace().toARGB(values, channels, count, out);
 }
 
-static bool is_digit(char c)
+float hue(color rgb)
 {
-    return ('0' <= c || c <= '9' || 'A' <= c || c <= 'F' || 'a' <= c || c <= 'f');
+    return hsb(rgb, 0);
 }
 
-static int hex_to_int(char c)
+// Both colors weighted out of 256, two channels at a time in the 0x00FF00FF
+// lanes so nothing carries from one channel into the next
+static inline unsigned int blend(unsigned int a, unsigned int b, unsigned int w)
 {
-    int i = c - '0';
-    if (i > 9)
-        i = c - 'A' + 10;
-    if (i > 15)
-        i = c - 'a' + 10;
-    return i;
+    unsigned int rb = ((a & 0xFF00FF) * (256 - w) + (b & 0xFF00FF) * w) >> 8;
+    unsigned int ag = ((a >> 8) & 0xFF00FF) * (256 - w) + ((b >> 8) & 0xFF00FF) * w;
+    return (rb & 0xFF00FF) | (ag & 0xFF00FF00);
 }
 
-color::color(const char *hex)
+static inline unsigned int weight(float amt)
 {
-    if (hex[0] != '#')
-        throw "bad hex notation: no '#'";
-    const char *tmp = hex + 1;
-    int d[8];
-    int i;
-    for (i = 0; i < 8; i++)
-    {
-        char c = tmp[i];
-        if (c == '\0')
-            break;
-        if (!is_digit(c))
-            throw "bad hex notation: not digit";
-        d[i] = hex_to_int(c);
-    }
-    if (tmp[i] != '\0')
-        throw "bad hex notation";
+    return (unsigned int) (std::min(std::max(amt, 0.0f), 1.0f) * 256 + 0.5f);
+}
 
-    int v1, v2, v3, alpha = 0xFF;
-    switch (i)
-    {
-    case 3:
-        v1 = (d[0] << 4) | d[0];
-        v2 = (d[1] << 4) | d[1];
-        v3 = (d[2] << 4) | d[2];
-        break;
-    case 6:
-        v1 = (d[0] << 4) | d[1];
-        v2 = (d[2] << 4) | d[3];
-        v3 = (d[4] << 4) | d[5];
-        break;
-    case 8:
-        v1 = (d[0] << 4) | d[1];
-        v2 = (d[2] << 4) | d[3];
-        v3 = (d[4] << 4) | d[5];
-        alpha = (d[6] << 4) | d[7];
-        break;
-    default:
-        throw "bad hex notation: only support format: #RGB, #RRGGBB, #RRGGBBAA";
-    }
-    data.v1 = v1;
-    data.v2 = v2;
-    data.v3 = v3;
-    data.alpha = alpha;
+// Weight of step i out of steps, rounded so both ends are exact
+static inline unsigned int weight(int i, int steps)
+{
+    return (unsigned int) (((long long) i * 512 + steps) / (2 * (long long) steps));
 }
 
-float green(color rgb)
+#ifdef __SSE2__
+// Four colors at once, the same sums as blend() in 16 bit lanes. The
+// weights are per channel, the low half for the first two colors.
+static inline __m128i blend4(__m128i a, __m128i b, __m128i wlo, __m128i whi)
 {
-    return rgb.data.v2;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(256);
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), _mm_sub_epi16(full, wlo)),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), wlo));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), _mm_sub_epi16(full, whi)),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), whi));
+    return _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
 }
+#endif
 
-float hue(color rgb)
+color lerpColor(color c1, color c2, float amt)
 {
-    return rgb.data.v1;
+    return color::fromARGB(blend(c1.argb(), c2.argb(), weight(amt)));
 }
 
-//int lerpColor(int c1, int c2, float amt)
-//{
-//}
+void lerpColor(const unsigned int *c1, const unsigned int *c2, float amt, unsigned int *out, int count)
+{
+    unsigned int w = weight(amt);
+    int i = 0;
+#ifdef __SSE2__
+    __m128i weights = _mm_set1_epi16((short) w);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *) (c1 + i));
+        __m128i b = _mm_loadu_si128((const __m128i *) (c2 + i));
+        _mm_storeu_si128((__m128i *) (out + i), blend4(a, b, weights, weights));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = blend(c1[i], c2[i], w);
+}
 
-float red(color rgb)
+void lerpColor(color c1, color c2, unsigned int *out, int count)
 {
-    return rgb.data.v1;
+    if (count <= 0)
+        return;
+    if (count == 1)
+    {
+        out[0] = c1.argb();
+        return;
+    }
+
+    unsigned int a = c1.argb();
+    unsigned int b = c2.argb();
+    int steps = count - 1;
+    int i = 0;
+#ifdef __SSE2__
+    __m128i from = _mm_set1_epi32((int) a);
+    __m128i to = _mm_set1_epi32((int) b);
+    for (; i + 4 <= count; i += 4)
+    {
+        short w[4];
+        for (int k = 0; k < 4; k++)
+            w[k] = (short) weight(i + k, steps);
+        __m128i wlo = _mm_set_epi16(w[1], w[1], w[1], w[1], w[0], w[0], w[0], w[0]);
+        __m128i whi = _mm_set_epi16(w[3], w[3], w[3], w[3], w[2], w[2], w[2], w[2]);
+        _mm_storeu_si128((__m128i *) (out + i), blend4(from, to, wlo, whi));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = blend(a, b, weight(i, steps));
 }
 
 float saturation(color rgb)
 {
-    return rgb.data.v2;
+    return hsb(rgb, 1);
 }
 
 void ellipseMode(DrawMode mode)
@@ -358,87 +624,291 @@ void strokeWeight(int weight)
     canvas->strokeWeight(weight);
 }
 
+void applyMatrix(const PMatrix2D &source)
+{
+    canvas->applyMatrix(source);
+}
+
+void applyMatrix(const PMatrix3D &source)
+{
+    canvas->applyMatrix(source);
+}
+
+void applyMatrix(float n00, float n01, float n02, float n10, float n11, float n12)
+{
+    canvas->applyMatrix(PMatrix2D(n00, n01, n02, n10, n11, n12));
+}
+
+void applyMatrix(float n00, float n01, float n02, float n03,
+                 float n10, float n11, float n12, float n13,
+                 float n20, float n21, float n22, float n23,
+                 float n30, float n31, float n32, float n33)
+{
+    canvas->applyMatrix(PMatrix3D(n00, n01, n02, n03, n10, n11, n12, n13,
+                n20, n21, n22, n23, n30, n31, n32, n33));
+}
+
+void popMatrix()
+{
+    canvas->popMatrix();
+}
+
+void pushMatrix()
+{
+    canvas->pushMatrix();
+}
+
+void resetMatrix()
+{
+    canvas->resetMatrix();
+}
+
 void rotate(float angle)
 {
     canvas->rotate(angle);
 }
 
+void rotateX(float angle)
+{
+    canvas->rotateX(angle);
+}
+
+void rotateY(float angle)
+{
+    canvas->rotateY(angle);
+}
+
+void rotateZ(float angle)
+{
+    canvas->rotateZ(angle);
+}
+
+void scale(float s)
+{
+    canvas->scale(s, s, s);
+}
+
+void scale(float x, float y)
+{
+    canvas->scale(x, y);
+}
+
+void scale(float x, float y, float z)
+{
+    canvas->scale(x, y, z);
+}
+
 void translate(float x, float y)
 {
     canvas->translate(x, y);
 }
 
-int constrain(int amt, int low, int high)
+void translate(float x, float y, float z)
+{
+    canvas->translate(x, y, z);
+}
+
+float screenX(float x, float y)
+{
+    return canvas->screenX(x, y);
+}
+
+float screenX(float x, float y, float z)
+{
+    return canvas->screenX(x, y, z);
+}
+
+float screenY(float x, float y)
+{
+    return canvas->screenY(x, y);
+}
+
+float screenY(float x, float y, float z)
+{
+    return canvas->screenY(x, y, z);
+}
+
+float screenZ(float x, float y, float z)
+{
+    return canvas->screenZ(x, y, z);
+}
+
+void lights()
+{
+    canvas->lights();
+}
+
+void noLights()
 {
-    return ((amt < low) ? low : ((amt > high) ? high : amt));
+    canvas->noLights();
 }
 
-float constrain(float amt, float low, float high)
+void camera()
 {
-    return ((amt < low) ? low : ((amt > high) ? high : amt));
+    canvas->camera();
 }
 
-float dist(float x1, float y1, float x2, float y2)
+void camera(float eyeX, float eyeY, float eyeZ, float centerX, float centerY, float centerZ,
+        float upX, float upY, float upZ)
 {
-    float dx = x2 - x1;
-    float dy = y2 - y1;
-    return sqrt(dx * dx + dy * dy);
+    canvas->camera(eyeX, eyeY, eyeZ, centerX, centerY, centerZ, upX, upY, upZ);
 }
 
-float dist(float x1, float y1, float z1, float x2, float y2, float z2)
+void ortho()
 {
-    float dx = x2 - x1;
-    float dy = y2 - y1;
-    float dz = z2 - z1;
-    return sqrt(dx * dx + dy * dy + dz * dz);
+    canvas->ortho();
 }
 
-float lerp(float start, float stop, float amt)
+void ortho(float left, float right, float bottom, float top, float zNear, float zFar)
 {
-    if (amt < 0.0 || amt > 1.0) { throw "lerp(): amt is bad"; }
-    return start + amt * (stop - start);
+    canvas->ortho(left, right, bottom, top, zNear, zFar);
 }
 
-float mag(float a, float b)
+void perspective()
 {
-    return sqrt(a * a + b * b);
+    canvas->perspective();
 }
 
-float mag(float a, float b, float c)
+void perspective(float fovy, float aspect, float zNear, float zFar)
 {
-    return sqrt(a * a + b * b + c * c);
+    canvas->perspective(fovy, aspect, zNear, zFar);
 }
 
-float map(float value, float start1, float stop1, float start2, float stop2)
+#ifdef __SSE__
+static inline __m128 sq4(__m128 v)
 {
-    return start2 + (value * (stop2 - start2)) / (stop1 - start1);
+    return _mm_mul_ps(v, v);
 }
+#endif
 
-float norm(float value, float start, float stop)
+void constrain(const float *amt, float low, float high, float *out, int count)
 {
-    return start + (value / (stop - start));
+    int i = 0;
+#ifdef __SSE__
+    // Selected by the same comparisons as the ternaries, min and max
+    // would turn NaN into low and ignore low above high
+    __m128 a = _mm_set1_ps(low);
+    __m128 b = _mm_set1_ps(high);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 v = _mm_loadu_ps(amt + i);
+        __m128 below = _mm_cmplt_ps(v, a);
+        __m128 above = _mm_cmpgt_ps(v, b);
+        v = _mm_or_ps(_mm_and_ps(above, b), _mm_andnot_ps(above, v));
+        _mm_storeu_ps(out + i, _mm_or_ps(_mm_and_ps(below, a), _mm_andnot_ps(below, v)));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = constrain(amt[i], low, high);
+}
+
+void dist(const float *x1, const float *y1, const float *x2, const float *y2, float *out, int count)
+{
+    int i = 0;
+#ifdef __SSE__
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x2 + i), _mm_loadu_ps(x1 + i));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y2 + i), _mm_loadu_ps(y1 + i));
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(sq4(dx), sq4(dy))));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = dist(x1[i], y1[i], x2[i], y2[i]);
+}
+
+void dist(const float *x1, const float *y1, const float *z1,
+          const float *x2, const float *y2, const float *z2, float *out, int count)
+{
+    int i = 0;
+#ifdef __SSE__
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x2 + i), _mm_loadu_ps(x1 + i));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y2 + i), _mm_loadu_ps(y1 + i));
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(z2 + i), _mm_loadu_ps(z1 + i));
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(sq4(dx), sq4(dy)), sq4(dz))));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = dist(x1[i], y1[i], z1[i], x2[i], y2[i], z2[i]);
+}
+
+void lerp(const float *start, const float *stop, float amt, float *out, int count)
+{
+    int i = 0;
+#ifdef __SSE__
+    __m128 t = _mm_set1_ps(amt);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 a = _mm_loadu_ps(start + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(_mm_loadu_ps(stop + i), a))));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = lerp(start[i], stop[i], amt);
+}
+
+void lerp(float start, float stop, const float *amt, float *out, int count)
+{
+    int i = 0;
+#ifdef __SSE__
+    __m128 a = _mm_set1_ps(start);
+    __m128 range = _mm_set1_ps(stop - start);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(out + i, _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(amt + i), range)));
+#endif
+    for (; i < count; i++)
+        out[i] = lerp(start, stop, amt[i]);
+}
+
+void mag(const float *a, const float *b, float *out, int count)
+{
+    int i = 0;
+#ifdef __SSE__
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(sq4(_mm_loadu_ps(a + i)), sq4(_mm_loadu_ps(b + i)))));
+#endif
+    for (; i < count; i++)
+        out[i] = mag(a[i], b[i]);
 }
 
-float degrees(float rad)
+void mag(const float *a, const float *b, const float *c, float *out, int count)
 {
-    if (rad < 0 || rad > (float) TWO_PI) { throw "degree(): rad is bad"; }
-    if (rad == 0)           { return 0; }
-    if (rad == QUARTER_PI)  { return 45; }
-    if (rad == HALF_PI)     { return 90; }
-    if (rad == PI)          { return 180; }
-    if (rad == TWO_PI || rad == TAU) { return 360; }
-    return (rad * (180.0 / PI));
+    int i = 0;
+#ifdef __SSE__
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 sum = _mm_add_ps(sq4(_mm_loadu_ps(a + i)), sq4(_mm_loadu_ps(b + i)));
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(sum, sq4(_mm_loadu_ps(c + i)))));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = mag(a[i], b[i], c[i]);
+}
+
+void map(const float *value, float start1, float stop1, float start2, float stop2, float *out, int count)
+{
+    // Divided before scaling as map() does, a reciprocal would round
+    int i = 0;
+#ifdef __SSE__
+    __m128 from = _mm_set1_ps(start1);
+    __m128 span = _mm_set1_ps(stop1 - start1);
+    __m128 to = _mm_set1_ps(start2);
+    __m128 range = _mm_set1_ps(stop2 - start2);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 t = _mm_div_ps(_mm_sub_ps(_mm_loadu_ps(value + i), from), span);
+        _mm_storeu_ps(out + i, _mm_add_ps(to, _mm_mul_ps(range, t)));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = map(value[i], start1, stop1, start2, stop2);
 }
 
-float radians(float deg)
+void norm(const float *value, float start, float stop, float *out, int count)
 {
-    if (deg < 0 || deg > 360.0) { throw "radians(): deg is bad"; }
-    if (deg == 0)   { return 0; }
-    if (deg == 45)  { return QUARTER_PI; }
-    if (deg == 90)  { return HALF_PI; }
-    if (deg == 180) { return PI; }
-    if (deg == 360) { return TWO_PI; }
-    return ((deg * PI) / 180.0);
+    map(value, start, stop, 0, 1, out, count);
 }
 
 float random(float high)
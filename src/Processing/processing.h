@@ -8,9 +8,12 @@
 
 #include "pglobal.h"
 #include "pargs.h"
+#include "pstats.h"
 
 #include <cmath>
 #include <iostream>
+#include <sstream>
+#include <string>
 
 // Non-cross compilers
 #define PB(x) void __attribute__((weak)) x();
@@ -21,37 +24,78 @@ PROCESSING_BEGIN_NAMESPACE
 
 typedef char byte;
 
-typedef struct color_data_t
-{
-    unsigned alpha : 8,
-        v1 : 8,
-        v2 : 8,
-        v3 : 8;
-}
-color_t;
+class PMatrix2D;
+class PMatrix3D;
+class PShape;
+class PFont;
 
+/**
+ * A color packed as 0xAARRGGBB, the layout of pixels[], so argb() is
+ * written to the canvas as it is. Channels out of 0..255 are clamped.
+ *
+ * Colors can be made at compile time, from channels, from hex notation
+ * ("#RGB", "#RRGGBB" or "#RRGGBBAA") or from a packed value. As in
+ * Processing, a single value out of 0..255 is packed ARGB rather than a
+ * gray, so color(0xFF336699) works. fromARGB() takes any packed value as
+ * it is, such as pixels[i].
+ */
 class color
 {
 public:
-    color() : color(0) {}
-    color(int gray) : color(gray, gray, gray, 0xFF) {}
-    color(int gray, int alpha) : color(gray, gray, gray, alpha) {}
-    color(int v1, int v2, int v3) : color(v1, v2, v3, 0xFF) {}
-    color(int v1, int v2, int v3, int alpha);
-    color(const char *hex);
+    constexpr color() : color(0) {}
+    constexpr color(int gray)
+        : data((unsigned int) gray > 0xFF ? (unsigned int) gray : 0xFF000000u | (unsigned int) gray * 0x10101u) {}
+    constexpr color(int gray, int alpha) : color(gray, gray, gray, alpha) {}
+    constexpr color(int v1, int v2, int v3) : color(v1, v2, v3, 0xFF) {}
+    constexpr color(int v1, int v2, int v3, int alpha)
+        : data(channel(alpha) << 24 | channel(v1) << 16 | channel(v2) << 8 | channel(v3)) {}
+    constexpr color(const char *hex) : data(parse(hex)) {}
+
+    static constexpr color fromARGB(unsigned int argb) { return color(argb, Packed()); }
+    constexpr unsigned int argb() const { return data; }
+
+    constexpr bool operator==(color c) const { return data == c.data; }
+    constexpr bool operator!=(color c) const { return data != c.data; }
 
 private:
-    friend float red(color);
-    friend float green(color);
-    friend float blue(color);
-    friend float hue(color);
-    friend float saturation(color);
-    friend float brightness(color);
-    friend float alpha(color);
-
-    color_t data;
+    struct Packed {};
+    constexpr color(unsigned int argb, Packed) : data(argb) {}
+
+    static constexpr unsigned int channel(int v)
+    {
+        return v < 0 ? 0u : v > 0xFF ? 0xFFu : (unsigned int) v;
+    }
+
+    static constexpr unsigned int digit(char c)
+    {
+        return '0' <= c && c <= '9' ? (unsigned int) (c - '0')
+             : 'A' <= c && c <= 'F' ? (unsigned int) (c - 'A' + 10)
+             : 'a' <= c && c <= 'f' ? (unsigned int) (c - 'a' + 10)
+             : throw "color(): bad hex notation: not digit";
+    }
+
+    static constexpr int length(const char *s) { return *s ? 1 + length(s + 1) : 0; }
+
+    static constexpr unsigned int digits(const char *s, int n)
+    {
+        return n ? digits(s, n - 1) << 4 | digit(s[n - 1]) : 0u;
+    }
+
+    static constexpr unsigned int parse(const char *hex)
+    {
+        return hex[0] != '#' ? throw "color(): bad hex notation: no '#'"
+             : length(hex + 1) == 3 ? 0xFF000000u | digit(hex[1]) * 0x110000u
+                                      | digit(hex[2]) * 0x1100u | digit(hex[3]) * 0x11u
+             : length(hex + 1) == 6 ? 0xFF000000u | digits(hex + 1, 6)
+             : length(hex + 1) == 8 ? digits(hex + 1, 8) >> 8 | digits(hex + 1, 8) << 24
+             : throw "color(): only support format: #RGB, #RRGGBB, #RRGGBBAA";
+    }
+
+    unsigned int data;
 };
 
+static_assert(sizeof(color) == sizeof(unsigned int), "color must be bit-compatible with pixels[]");
+
 class Processing
 {
 public:
@@ -70,14 +114,26 @@ private:
 
 // Structure
 void exit();
+bool isLooping();
 void loop();
+void loopOnInput();
 void noLoop();
 void pushStyle();
 void popStyle();
+void redraw();
 
 // Environment
 void size(int width, int height, enum Renderer renderer=PDEFAULT);
 void setFrameRate(int fps);
+void windowResizable(bool resizable);
+void adaptiveQuality(bool enable=true);
+int displayDensity();
+void pixelDensity(int density);
+void renderScale(float scale);
+void smooth(int level=2);
+void noSmooth();
+Quality quality();
+const PStats & frameStats();
 
 // 2D Primitives
 void arc(float a, float b, float c, float d, float start, float stop, ArcMode mode=OPEN);
@@ -90,6 +146,35 @@ void rect(float a, float b, float c, float d, float r);
 void rect(float a, float b, float c, float d, float tl, float tr, float br, float bl);
 void triangle(float x1, float y1, float x2, float y2, float x3, float y3);
 
+// 3D Primitives
+void box(float size);
+void box(float w, float h, float d);
+void sphere(float r);
+void sphereDetail(int res);
+
+// Shape
+PShape createShape();
+PShape createShape(ShapeFamily family, float a, float b);
+PShape createShape(ShapeFamily family, float a, float b, float c, float d);
+PShape createShape(ShapeFamily family, float a, float b, float c, float d, float e);
+PShape createShape(ShapeFamily family, float a, float b, float c, float d, float e, float f, ArcMode mode=OPEN);
+PShape createShape(ShapeFamily family, float a, float b, float c, float d, float e, float f, float g, float h);
+void shape(const PShape &s, float x=0, float y=0);
+void shape(const PShape &s, float a, float b, float c, float d);
+
+// Curves
+void bezier(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4);
+void curve(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4);
+void curveTightness(float tightness);
+
+// Vertex
+void beginShape(ShapeKind kind=POLYGON);
+void bezierVertex(float x2, float y2, float x3, float y3, float x4, float y4);
+void curveVertex(float x, float y);
+void endShape(EndMode mode=END_OPEN);
+void vertex(float x, float y);
+void vertex(float x, float y, float z);
+
 // Color
 void background(color);
 void background(int);
@@ -105,13 +190,16 @@ void stroke(color c);
 void stroke(int gray, int alpha=255);
 void stroke(int v1, int v2, int v3, int alpha=255);
 void noStroke();
-float alpha(color rgb);
-float blue(color rgb);
+constexpr float alpha(color rgb) { return rgb.argb() >> 24; }
+constexpr float blue(color rgb) { return rgb.argb() & 0xFF; }
 float brightness(color rgb);
-float green(color rgb);
+void colors(const float *values, int channels, int count, unsigned int *out);
+constexpr float green(color rgb) { return (rgb.argb() >> 8) & 0xFF; }
 float hue(color rgb);
-//int lerpColor(int c1, int c2, float amt);
-float red(color rgb);
+color lerpColor(color c1, color c2, float amt);
+void lerpColor(const unsigned int *c1, const unsigned int *c2, float amt, unsigned int *out, int count);
+void lerpColor(color c1, color c2, unsigned int *out, int count);
+constexpr float red(color rgb) { return (rgb.argb() >> 16) & 0xFF; }
 float saturation(color rgb);
 
 // Attribute
@@ -124,21 +212,84 @@ template <class T>
 inline void print(T what) { std::cout << what; }
 template <class T>
 inline void println(T what) { std::cout << what << std::endl; }
+void saveFrame();
+void saveFrame(const char *filename);
+
+// Pixels
+void loadPixels();
+void updatePixels();
+
+// Rendering
+void clip(float a, float b, float c, float d);
+void noClip();
+
+// Typography
+PFont createFont(const std::string &name, float size, bool smooth=true);
+void text(const std::string &str, float x, float y);
+template <class T>
+inline void text(T what, float x, float y) { std::ostringstream ss; ss << what; text(ss.str(), x, y); }
+void textFont(const PFont &font);
+void textFont(const PFont &font, float size);
+void textSize(float size);
+float textWidth(const std::string &str);
 
 // Transform
+void applyMatrix(const PMatrix2D &source);
+void applyMatrix(const PMatrix3D &source);
+void applyMatrix(float n00, float n01, float n02, float n10, float n11, float n12);
+void applyMatrix(float n00, float n01, float n02, float n03,
+                 float n10, float n11, float n12, float n13,
+                 float n20, float n21, float n22, float n23,
+                 float n30, float n31, float n32, float n33);
+void popMatrix();
+void pushMatrix();
+void resetMatrix();
 void rotate(float angle);
+void rotateX(float angle);
+void rotateY(float angle);
+void rotateZ(float angle);
+void scale(float s);
+void scale(float x, float y);
+void scale(float x, float y, float z);
 void translate(float x, float y);
+void translate(float x, float y, float z);
+
+// Coordinates
+float screenX(float x, float y);
+float screenX(float x, float y, float z);
+float screenY(float x, float y);
+float screenY(float x, float y, float z);
+float screenZ(float x, float y, float z);
+
+// Lights, Camera
+void lights();
+void noLights();
+void camera();
+void camera(float eyeX, float eyeY, float eyeZ, float centerX, float centerY, float centerZ,
+        float upX, float upY, float upZ);
+void ortho();
+void ortho(float left, float right, float bottom, float top, float zNear, float zFar);
+void perspective();
+void perspective(float fovy, float aspect, float zNear, float zFar);
 
 // Math
-int constrain(int amt, int low, int high);
-float constrain(float amt, float low, float high);
-float dist(float x1, float y1, float x2, float y2);
-float dist(float x1, float y1, float z1, float x2, float y2, float z2);
-float lerp(float start, float stop, float amt);
-float mag(float a, float b);
-float mag(float a, float b, float c);
-float map(float value, float start1, float stop1, float start2, float stop2);
-float norm(float value, float start, float stop);
+inline float sq(float n) { return n * n; }
+inline int constrain(int amt, int low, int high) { return ((amt < low) ? low : ((amt > high) ? high : amt)); }
+inline float constrain(float amt, float low, float high) { return ((amt < low) ? low : ((amt > high) ? high : amt)); }
+inline float dist(float x1, float y1, float x2, float y2) { return std::sqrt(sq(x2 - x1) + sq(y2 - y1)); }
+inline float dist(float x1, float y1, float z1, float x2, float y2, float z2)
+{
+    return std::sqrt(sq(x2 - x1) + sq(y2 - y1) + sq(z2 - z1));
+}
+inline float lerp(float start, float stop, float amt) { return start + amt * (stop - start); }
+inline float mag(float a, float b) { return std::sqrt(a * a + b * b); }
+inline float mag(float a, float b, float c) { return std::sqrt(a * a + b * b + c * c); }
+inline float map(float value, float start1, float stop1, float start2, float stop2)
+{
+    // Processing's order, so stop1 goes to stop2 exactly
+    return start2 + (stop2 - start2) * ((value - start1) / (stop1 - start1));
+}
+inline float norm(float value, float start, float stop) { return map(value, start, stop, 0, 1); }
 
 inline int max(int a, int b) { return (a >= b ? a : b); }
 inline int min(int a, int b) { return (a <= b ? a : b); }
@@ -148,14 +299,19 @@ inline int max(int a, int b, int c) { return (a >= b ? max(a, c) : max(b, c)); }
 inline int min(int a, int b, int c) { return (a <= b ? min(a, c) : min(b, c)); }
 inline float max(float a, float b, float c) { return (a >= b ? max(a, c) : max(b, c)); }
 inline float min(float a, float b, float c) { return (a <= b ? min(a, c) : min(b, c)); }
-inline float sq(float n) { return n * n; }
-
-float degrees(float rad);
-float radians(float deg);
 
-float random(float high);
-float random(float low, float high);
-void randomSeed(int seed);
+// The same over arrays of count values, four at a time with SSE. Each
+// element comes out as the function above gives it.
+void constrain(const float *amt, float low, float high, float *out, int count);
+void dist(const float *x1, const float *y1, const float *x2, const float *y2, float *out, int count);
+void dist(const float *x1, const float *y1, const float *z1,
+          const float *x2, const float *y2, const float *z2, float *out, int count);
+void lerp(const float *start, const float *stop, float amt, float *out, int count);
+void lerp(float start, float stop, const float *amt, float *out, int count);
+void mag(const float *a, const float *b, float *out, int count);
+void mag(const float *a, const float *b, const float *c, float *out, int count);
+void map(const float *value, float start1, float stop1, float start2, float stop2, float *out, int count);
+void norm(const float *value, float start, float stop, float *out, int count);
 
 #define HALF_PI     1.57079632679489661923
 #define PI          3.14159265358979323846
@@ -163,12 +319,22 @@ void randomSeed(int seed);
 #define TAU         6.28318530717958647692
 #define TWO_PI      6.28318530717958647692
 
+inline float degrees(float rad) { return rad * (float) (180.0 / PI); }
+inline float radians(float deg) { return deg * (float) (PI / 180.0); }
+
+float random(float high);
+float random(float low, float high);
+void randomSeed(int seed);
+
 // Global variables
 extern PROCESSING_NAMESPACE::Args args;
 extern int width;
 extern int height;
+extern int pixelWidth;
+extern int pixelHeight;
 extern int frameRate;
 extern int frameCount;
+extern unsigned int *pixels;
 //extern MouseButton mouseButton;
 extern bool isMousePressed;
 extern int mouseX;
@@ -0,0 +1,750 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "qt3dcanvas.h"
+#include <QtMath>
+
+PROCESSING_BEGIN_NAMESPACE
+
+// Unit cube: four vertices per face so every face has its own normal
+static const float cubeCorners[8][3] = {
+    { -0.5, -0.5, -0.5 }, { 0.5, -0.5, -0.5 }, { -0.5, 0.5, -0.5 }, { 0.5, 0.5, -0.5 },
+    { -0.5, -0.5, 0.5 }, { 0.5, -0.5, 0.5 }, { -0.5, 0.5, 0.5 }, { 0.5, 0.5, 0.5 }
+};
+
+static const int cubeFaces[6][4] = {
+    { 4, 5, 7, 6 }, { 0, 2, 3, 1 }, { 1, 3, 7, 5 },
+    { 0, 4, 6, 2 }, { 2, 6, 7, 3 }, { 0, 1, 5, 4 }
+};
+
+static const float cubeNormals[6][3] = {
+    { 0, 0, 1 }, { 0, 0, -1 }, { 1, 0, 0 },
+    { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }
+};
+
+struct Cube
+{
+    Cube()
+    {
+        int edgeCount = 0;
+        bool seen[8][8] = {};
+        for (int f = 0; f < 6; f++)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                int v = f * 4 + k;
+                std::copy(cubeCorners[cubeFaces[f][k]], cubeCorners[cubeFaces[f][k]] + 3, points + 3 * v);
+                std::copy(cubeNormals[f], cubeNormals[f] + 3, normals + 3 * v);
+
+                // Each of the twelve edges is drawn once
+                int p = cubeFaces[f][k];
+                int q = cubeFaces[f][(k + 1) % 4];
+                if (!seen[p][q])
+                {
+                    seen[p][q] = seen[q][p] = true;
+                    edges[2 * edgeCount] = v;
+                    edges[2 * edgeCount + 1] = f * 4 + (k + 1) % 4;
+                    edgeCount++;
+                }
+            }
+            int t[6] = { 0, 1, 2, 0, 2, 3 };
+            for (int k = 0; k < 6; k++)
+                triangles[6 * f + k] = f * 4 + t[k];
+        }
+    }
+
+    float points[24 * 3];
+    float normals[24 * 3];
+    int triangles[12 * 3];
+    int edges[12 * 2];
+};
+
+static const Cube & unitCube()
+{
+    static const Cube cube;
+    return cube;
+}
+
+static QMatrix4x4 toMatrix4x4(const PMatrix3D &m)
+{
+    float values[16];
+    m.get(values);
+    return QMatrix4x4(values);
+}
+
+// Sums the face normals around each vertex
+static void vertexNormals(const float *points, int count, const int *triangles, int triangleCount,
+        std::vector<float> &normals)
+{
+    normals.assign(3 * count, 0);
+    for (int t = 0; t < triangleCount; t++)
+    {
+        const float *a = points + 3 * triangles[3 * t];
+        const float *b = points + 3 * triangles[3 * t + 1];
+        const float *c = points + 3 * triangles[3 * t + 2];
+        QVector3D n = QVector3D::crossProduct(QVector3D(b[0] - a[0], b[1] - a[1], b[2] - a[2]),
+                QVector3D(c[0] - a[0], c[1] - a[1], c[2] - a[2]));
+        for (int k = 0; k < 3; k++)
+        {
+            float *out = &normals[3 * triangles[3 * t + k]];
+            out[0] += n.x();
+            out[1] += n.y();
+            out[2] += n.z();
+        }
+    }
+}
+
+/**
+ * Qt3DCanvas class
+ */
+Qt3DCanvas::Qt3DCanvas(QWidget *parent)
+    : QtCanvas(parent),
+      customCamera(false),
+      customProjection(false),
+      lighting(false),
+      sphereResolution(30),
+      viewport(P_WIDTH_DEFAULT, P_HEIGHT_DEFAULT)
+{
+    buildSphere();
+    camera();
+    perspective();
+    customCamera = false;
+    customProjection = false;
+}
+
+Qt3DCanvas::~Qt3DCanvas()
+{
+}
+
+void Qt3DCanvas::resizeBuffer(int width, int height)
+{
+    QtCanvas::resizeBuffer(width, height);
+    viewport = QSize(width, height);
+
+    // The defaults follow the size, a camera set by the sketch stays
+    if (!customCamera)
+    {
+        camera();
+        customCamera = false;
+    }
+    if (!customProjection)
+    {
+        perspective();
+        customProjection = false;
+    }
+}
+
+void Qt3DCanvas::animate()
+{
+    beginFrame();
+    modelview = view;
+    modelviewStack.clear();
+    lighting = false;
+    Canvas::animate();
+
+    QImage &image = buffer->getImage();
+    raster.render(image, image.devicePixelRatio());
+    for (size_t i = 0; i < labels.size(); i++)
+    {
+        const Label &label = labels[i];
+        drawRun(texts.run(label.font, label.text), label.x, label.y, label.color, PMatrix2D());
+    }
+    labels.clear();
+    endFrame();
+    stats.primitives = raster.triangleCount();
+    if (isPresenting())
+        update();
+}
+
+void Qt3DCanvas::mesh(const float *points, const float *normals, const float *baseColors, int count,
+        const int *triangles, int triangleCount, const int *edges, int edgeCount, bool twoSided)
+{
+    bool filled = (style.brush.style() != Qt::NoBrush && triangleCount > 0);
+    bool stroked = (style.pen.style() != Qt::NoPen && edgeCount > 0);
+    if (!filled && !stroked)
+        return;
+
+    // Gouraud shading: light the vertices, the rasterizer blends between
+    // them. lights() is an ambient and a frontal directional light, each
+    // at half strength.
+    QColor fill = style.brush.color();
+    float base[4] = { (float) fill.redF(), (float) fill.greenF(), (float) fill.blueF(), (float) fill.alphaF() };
+    QMatrix4x4 matrix = toMatrix4x4(modelview);
+    QMatrix3x3 normalMatrix = matrix.normalMatrix();
+    colors.resize(4 * count);
+    for (int i = 0; i < count; i++)
+    {
+        const float *c = (baseColors ? baseColors + 4 * i : base);
+        float factor = 1;
+        if (lighting && normals)
+        {
+            const float *n = normals + 3 * i;
+            QVector3D eye(normalMatrix(0, 0) * n[0] + normalMatrix(0, 1) * n[1] + normalMatrix(0, 2) * n[2],
+                    normalMatrix(1, 0) * n[0] + normalMatrix(1, 1) * n[1] + normalMatrix(1, 2) * n[2],
+                    normalMatrix(2, 0) * n[0] + normalMatrix(2, 1) * n[1] + normalMatrix(2, 2) * n[2]);
+            float facing = eye.normalized().z();
+            if (twoSided)
+                facing = qAbs(facing);
+            factor = (128.0f / 255) * (1 + qMax(facing, 0.0f));
+        }
+        float *out = &colors[4 * i];
+        out[0] = qMin(c[0] * factor, 1.0f);
+        out[1] = qMin(c[1] * factor, 1.0f);
+        out[2] = qMin(c[2] * factor, 1.0f);
+        out[3] = c[3];
+    }
+
+    int first = raster.addVertices(projection * matrix, points, colors.data(), count);
+    if (filled)
+        for (int t = 0; t < triangleCount; t++)
+            raster.addTriangle(first + triangles[3 * t], first + triangles[3 * t + 1], first + triangles[3 * t + 2]);
+    if (stroked)
+        for (int e = 0; e < edgeCount; e++)
+            raster.addLine(first + edges[2 * e], first + edges[2 * e + 1], style.pen.color(), style.pen.widthF());
+}
+
+void Qt3DCanvas::polygon(const float *points, const float *baseColors, int count, bool closed)
+{
+    if (count < 1)
+        return;
+
+    // Lit with one normal for the whole polygon
+    QVector3D n;
+    for (int k = 0; k < count; k++)
+    {
+        const float *a = points + 3 * k;
+        const float *b = points + 3 * ((k + 1) % count);
+        n += QVector3D((a[1] - b[1]) * (a[2] + b[2]), (a[2] - b[2]) * (a[0] + b[0]), (a[0] - b[0]) * (a[1] + b[1]));
+    }
+    polygonNormals.resize(3 * count);
+    for (int k = 0; k < count; k++)
+    {
+        polygonNormals[3 * k] = n.x();
+        polygonNormals[3 * k + 1] = n.y();
+        polygonNormals[3 * k + 2] = n.z();
+    }
+
+    // Triangulated in the axis plane it faces most, a polygon that
+    // crosses itself is filled as a fan
+    int u = 0, v = 1;
+    if (qAbs(n.x()) > qAbs(n.y()) && qAbs(n.x()) > qAbs(n.z()))
+        u = 2;
+    else if (qAbs(n.y()) > qAbs(n.z()))
+        v = 2;
+    polygonPlane.resize(2 * count);
+    for (int k = 0; k < count; k++)
+    {
+        polygonPlane[2 * k] = points[3 * k + u];
+        polygonPlane[2 * k + 1] = points[3 * k + v];
+    }
+    polygonTriangles.clear();
+    if (!tessellator.triangulate(polygonPlane.data(), count, polygonTriangles))
+    {
+        for (int k = 1; k + 1 < count; k++)
+        {
+            polygonTriangles.push_back(0);
+            polygonTriangles.push_back(k);
+            polygonTriangles.push_back(k + 1);
+        }
+    }
+
+    polygonEdges.clear();
+    for (int k = 0; k + 1 < count; k++)
+    {
+        polygonEdges.push_back(k);
+        polygonEdges.push_back(k + 1);
+    }
+    if (closed && count > 2)
+    {
+        polygonEdges.push_back(count - 1);
+        polygonEdges.push_back(0);
+    }
+    if (count == 1)
+    {
+        polygonEdges.push_back(0);
+        polygonEdges.push_back(0);
+    }
+
+    mesh(points, polygonNormals.data(), baseColors, count, polygonTriangles.data(), polygonTriangles.size() / 3,
+            polygonEdges.data(), polygonEdges.size() / 2, true);
+}
+
+void Qt3DCanvas::outline(const QPainterPath &path, const QPointF &offset)
+{
+    QList<QPolygonF> subpaths = path.toSubpathPolygons();
+    std::vector<float> points;
+    for (int i = 0; i < subpaths.size(); i++)
+    {
+        const QPolygonF &subpath = subpaths.at(i);
+        int count = subpath.size();
+        bool closed = (count > 2 && subpath.first() == subpath.last());
+        if (closed)
+            count--;
+        points.resize(3 * count);
+        for (int k = 0; k < count; k++)
+        {
+            points[3 * k] = subpath[k].x() + offset.x();
+            points[3 * k + 1] = subpath[k].y() + offset.y();
+            points[3 * k + 2] = 0;
+        }
+        polygon(points.data(), 0, count, closed);
+    }
+}
+
+void Qt3DCanvas::renderShape(QtShapeCache::Entry &entry, const QPointF &offset)
+{
+    // Flattened into the plane z = 0. Where only part of the outline is
+    // stroked, the fill and the stroke are separate passes.
+    const QtShapeGeometry &g = entry.geometry;
+    if (g.shared)
+        outline(g.fill, offset);
+    else
+    {
+        QPen pen = style.pen;
+        style.pen = QPen(Qt::NoPen);
+        outline(g.fill, offset);
+        style.pen = pen;
+        QBrush brush = style.brush;
+        style.brush = QBrush(Qt::NoBrush);
+        outline(g.stroke, offset);
+        style.brush = brush;
+    }
+    for (int i = 0; i < g.points.size(); i++)
+        point(g.points[i].x() + offset.x(), g.points[i].y() + offset.y());
+}
+
+void Qt3DCanvas::drawCurve(const std::vector<QPointF> &points)
+{
+    // In the plane z = 0, open so only the fill closes along the chord
+    std::vector<float> xyz(3 * points.size());
+    for (size_t k = 0; k < points.size(); k++)
+    {
+        xyz[3 * k] = points[k].x();
+        xyz[3 * k + 1] = points[k].y();
+        xyz[3 * k + 2] = 0;
+    }
+    polygon(xyz.data(), 0, points.size(), false);
+}
+
+void Qt3DCanvas::text(const std::string &str, float x, float y)
+{
+    if (style.brush.style() == Qt::NoBrush || str.empty())
+        return;
+    Label label;
+    label.text = QString::fromStdString(str);
+    label.font = currentFont();
+    label.x = screenX(x, y, 0);
+    label.y = screenY(x, y, 0);
+    label.color = style.brush.color();
+    labels.push_back(label);
+}
+
+void Qt3DCanvas::ellipse(float a, float b, float c, float d)
+{
+    QRectF bbox = getRect(style.ellipse_mode, a, b, c, d);
+    float rx = 0.5 * bbox.width();
+    float ry = 0.5 * bbox.height();
+    int n = qBound(16, (int) (qMax(qAbs(rx), qAbs(ry)) / 2), 128);
+    std::vector<float> points(3 * n);
+    for (int k = 0; k < n; k++)
+    {
+        float angle = 2 * M_PI * k / n;
+        points[3 * k] = bbox.center().x() + rx * qCos(angle);
+        points[3 * k + 1] = bbox.center().y() + ry * qSin(angle);
+        points[3 * k + 2] = 0;
+    }
+    polygon(points.data(), 0, n, true);
+}
+
+void Qt3DCanvas::line(float x1, float y1, float x2, float y2)
+{
+    float points[6] = { x1, y1, 0, x2, y2, 0 };
+    polygon(points, 0, 2, false);
+}
+
+void Qt3DCanvas::point(float x, float y)
+{
+    float points[3] = { x, y, 0 };
+    polygon(points, 0, 1, false);
+}
+
+void Qt3DCanvas::quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4)
+{
+    float points[12] = { x1, y1, 0, x2, y2, 0, x3, y3, 0, x4, y4, 0 };
+    polygon(points, 0, 4, true);
+}
+
+void Qt3DCanvas::rect(float a, float b, float c, float d)
+{
+    QRectF r = getRect(style.rect_mode, a, b, c, d);
+    float points[12] = {
+        (float) r.left(), (float) r.top(), 0, (float) r.right(), (float) r.top(), 0,
+        (float) r.right(), (float) r.bottom(), 0, (float) r.left(), (float) r.bottom(), 0
+    };
+    polygon(points, 0, 4, true);
+}
+
+void Qt3DCanvas::triangle(float x1, float y1, float x2, float y2, float x3, float y3)
+{
+    float points[9] = { x1, y1, 0, x2, y2, 0, x3, y3, 0 };
+    polygon(points, 0, 3, true);
+}
+
+void Qt3DCanvas::box(float w, float h, float d)
+{
+    const Cube &cube = unitCube();
+    PMatrix3D saved = modelview;
+    modelview.scale(w, h, d);
+    mesh(cube.points, cube.normals, 0, 24, cube.triangles, 12, cube.edges, 12);
+    modelview = saved;
+}
+
+void Qt3DCanvas::sphere(float r)
+{
+    // The unit sphere's points are its normals
+    PMatrix3D saved = modelview;
+    modelview.scale(r);
+    mesh(spherePoints.data(), spherePoints.data(), 0, spherePoints.size() / 3,
+            sphereTriangles.data(), sphereTriangles.size() / 3,
+            sphereEdges.data(), sphereEdges.size() / 2);
+    modelview = saved;
+}
+
+void Qt3DCanvas::sphereDetail(int res)
+{
+    if (res < 3)
+        res = 3;
+    if (res == sphereResolution)
+        return;
+    sphereResolution = res;
+    buildSphere();
+}
+
+void Qt3DCanvas::buildSphere()
+{
+    // Rings from pole to pole along y, as in Processing
+    int n = sphereResolution;
+    spherePoints.clear();
+    sphereTriangles.clear();
+    sphereEdges.clear();
+    for (int v = 0; v <= n; v++)
+    {
+        float theta = M_PI * v / n;
+        for (int u = 0; u < n; u++)
+        {
+            float phi = 2 * M_PI * u / n;
+            spherePoints.push_back(qSin(theta) * qCos(phi));
+            spherePoints.push_back(-qCos(theta));
+            spherePoints.push_back(qSin(theta) * qSin(phi));
+        }
+    }
+    for (int v = 0; v < n; v++)
+    {
+        for (int u = 0; u < n; u++)
+        {
+            int a = v * n + u;
+            int b = v * n + (u + 1) % n;
+            int c = (v + 1) * n + u;
+            int d = (v + 1) * n + (u + 1) % n;
+            if (v > 0)
+            {
+                int t[3] = { a, c, b };
+                sphereTriangles.insert(sphereTriangles.end(), t, t + 3);
+                int e[2] = { a, b };
+                sphereEdges.insert(sphereEdges.end(), e, e + 2);
+            }
+            if (v < n - 1)
+            {
+                int t[3] = { b, c, d };
+                sphereTriangles.insert(sphereTriangles.end(), t, t + 3);
+            }
+            int e[2] = { a, c };
+            sphereEdges.insert(sphereEdges.end(), e, e + 2);
+        }
+    }
+}
+
+void Qt3DCanvas::beginShape(ShapeKind kind)
+{
+    shapeKind = kind;
+    shapePoints.clear();
+    shapeColors.clear();
+    curveVertices.clear();
+}
+
+bool Qt3DCanvas::lastVertex(QPointF &point) const
+{
+    if (shapePoints.empty())
+        return false;
+    size_t last = shapePoints.size() - 3;
+    point = QPointF(shapePoints[last], shapePoints[last + 1]);
+    return true;
+}
+
+void Qt3DCanvas::vertex(float x, float y, float z)
+{
+    // Every vertex keeps the fill that was current when it was added
+    QColor c = style.brush.color();
+    float point[3] = { x, y, z };
+    float color[4] = { (float) c.redF(), (float) c.greenF(), (float) c.blueF(), (float) c.alphaF() };
+    shapePoints.insert(shapePoints.end(), point, point + 3);
+    shapeColors.insert(shapeColors.end(), color, color + 4);
+}
+
+void Qt3DCanvas::endShape(EndMode mode)
+{
+    int count = shapePoints.size() / 3;
+    std::vector<int> triangles;
+    std::vector<int> edges;
+    switch (shapeKind)
+    {
+        case POLYGON:
+            polygon(shapePoints.data(), shapeColors.data(), count, mode == CLOSE);
+            return;
+
+        case POINTS:
+            for (int i = 0; i < count; i++)
+            {
+                edges.push_back(i);
+                edges.push_back(i);
+            }
+            break;
+
+        case LINES:
+            for (int i = 0; i + 1 < count; i += 2)
+            {
+                edges.push_back(i);
+                edges.push_back(i + 1);
+            }
+            break;
+
+        case TRIANGLES:
+            for (int i = 0; i + 2 < count; i += 3)
+            {
+                int t[3] = { i, i + 1, i + 2 };
+                int e[6] = { i, i + 1, i + 1, i + 2, i + 2, i };
+                triangles.insert(triangles.end(), t, t + 3);
+                edges.insert(edges.end(), e, e + 6);
+            }
+            break;
+
+        case TRIANGLE_FAN:
+            for (int i = 1; i + 1 < count; i++)
+            {
+                int t[3] = { 0, i, i + 1 };
+                int e[4] = { 0, i, i, i + 1 };
+                triangles.insert(triangles.end(), t, t + 3);
+                edges.insert(edges.end(), e, e + 4);
+            }
+            if (count > 2)
+            {
+                edges.push_back(0);
+                edges.push_back(count - 1);
+            }
+            break;
+
+        case TRIANGLE_STRIP:
+            for (int i = 0; i + 2 < count; i++)
+            {
+                int t[3] = { i, i + 1, i + 2 };
+                int e[4] = { i, i + 1, i, i + 2 };
+                triangles.insert(triangles.end(), t, t + 3);
+                edges.insert(edges.end(), e, e + 4);
+            }
+            if (count > 2)
+            {
+                edges.push_back(count - 2);
+                edges.push_back(count - 1);
+            }
+            break;
+
+        case QUADS:
+            for (int i = 0; i + 3 < count; i += 4)
+            {
+                int t[6] = { i, i + 1, i + 2, i, i + 2, i + 3 };
+                int e[8] = { i, i + 1, i + 1, i + 2, i + 2, i + 3, i + 3, i };
+                triangles.insert(triangles.end(), t, t + 6);
+                edges.insert(edges.end(), e, e + 8);
+            }
+            break;
+
+        case QUAD_STRIP:
+            for (int i = 0; i + 3 < count; i += 2)
+            {
+                int t[6] = { i, i + 1, i + 3, i, i + 3, i + 2 };
+                int e[6] = { i, i + 2, i + 1, i + 3, i + 2, i + 3 };
+                triangles.insert(triangles.end(), t, t + 6);
+                edges.insert(edges.end(), e, e + 6);
+            }
+            if (count > 3)
+            {
+                edges.push_back(0);
+                edges.push_back(1);
+            }
+            break;
+    }
+
+    std::vector<float> normals;
+    vertexNormals(shapePoints.data(), count, triangles.data(), triangles.size() / 3, normals);
+    mesh(shapePoints.data(), normals.data(), shapeColors.data(), count,
+            triangles.data(), triangles.size() / 3, edges.data(), edges.size() / 2, true);
+}
+
+void Qt3DCanvas::backgroundARGB(unsigned int argb)
+{
+    raster.clear(QColor::fromRgba(argb));
+}
+
+void Qt3DCanvas::lights()
+{
+    lighting = true;
+}
+
+void Qt3DCanvas::noLights()
+{
+    lighting = false;
+}
+
+void Qt3DCanvas::pushMatrix()
+{
+    modelviewStack.push_back(modelview);
+}
+
+void Qt3DCanvas::popMatrix()
+{
+    if (modelviewStack.empty())
+        throw "popMatrix() is called more times than pushMatrix()";
+    modelview = modelviewStack.back();
+    modelviewStack.pop_back();
+}
+
+void Qt3DCanvas::resetMatrix()
+{
+    // As in Processing, the camera goes as well
+    modelview.reset();
+}
+
+void Qt3DCanvas::applyMatrix(const PMatrix2D &m)
+{
+    modelview.apply(m);
+}
+
+void Qt3DCanvas::applyMatrix(const PMatrix3D &m)
+{
+    modelview.apply(m);
+}
+
+void Qt3DCanvas::rotate(float angle)
+{
+    rotateZ(angle);
+}
+
+void Qt3DCanvas::rotateX(float angle)
+{
+    modelview.rotateX(angle);
+}
+
+void Qt3DCanvas::rotateY(float angle)
+{
+    modelview.rotateY(angle);
+}
+
+void Qt3DCanvas::rotateZ(float angle)
+{
+    modelview.rotateZ(angle);
+}
+
+void Qt3DCanvas::translate(float x, float y)
+{
+    modelview.translate(x, y);
+}
+
+void Qt3DCanvas::scale(float x, float y)
+{
+    modelview.scale(x, y);
+}
+
+void Qt3DCanvas::scale(float x, float y, float z)
+{
+    modelview.scale(x, y, z);
+}
+
+void Qt3DCanvas::translate(float x, float y, float z)
+{
+    modelview.translate(x, y, z);
+}
+
+QVector4D Qt3DCanvas::project(float x, float y, float z) const
+{
+    // Normalized device coordinates in x, y and z
+    QVector4D p = projection * QVector4D(modelview.multX(x, y, z), modelview.multY(x, y, z),
+            modelview.multZ(x, y, z), modelview.multW(x, y, z));
+    if (p.w() != 0)
+        p /= p.w();
+    return p;
+}
+
+float Qt3DCanvas::screenX(float x, float y, float z) const
+{
+    return (project(x, y, z).x() + 1) * 0.5 * viewport.width();
+}
+
+float Qt3DCanvas::screenY(float x, float y, float z) const
+{
+    return (project(x, y, z).y() + 1) * 0.5 * viewport.height();
+}
+
+float Qt3DCanvas::screenZ(float x, float y, float z) const
+{
+    return (project(x, y, z).z() + 1) * 0.5;
+}
+
+void Qt3DCanvas::camera()
+{
+    // Processing's default: looking at the center of the sketch from
+    // where it appears at its real size
+    float eyeZ = (0.5 * viewport.height()) / qTan(M_PI / 6);
+    camera(0.5 * viewport.width(), 0.5 * viewport.height(), eyeZ,
+            0.5 * viewport.width(), 0.5 * viewport.height(), 0, 0, 1, 0);
+}
+
+void Qt3DCanvas::camera(float eyeX, float eyeY, float eyeZ, float centerX, float centerY, float centerZ,
+        float upX, float upY, float upZ)
+{
+    QMatrix4x4 lookAt;
+    lookAt.lookAt(QVector3D(eyeX, eyeY, eyeZ), QVector3D(centerX, centerY, centerZ), QVector3D(upX, upY, upZ));
+    float values[16];
+    lookAt.copyDataTo(values);
+    view.set(values);
+    modelview = view;
+    customCamera = true;
+}
+
+void Qt3DCanvas::perspective()
+{
+    float eyeZ = (0.5 * viewport.height()) / qTan(M_PI / 6);
+    perspective(M_PI / 3, (float) viewport.width() / viewport.height(), eyeZ / 10, eyeZ * 10);
+}
+
+void Qt3DCanvas::perspective(float fovy, float aspect, float zNear, float zFar)
+{
+    projection.setToIdentity();
+    projection.perspective(qRadiansToDegrees(fovy), aspect, zNear, zFar);
+    customProjection = true;
+}
+
+void Qt3DCanvas::ortho()
+{
+    float eyeZ = (0.5 * viewport.height()) / qTan(M_PI / 6);
+    ortho(-0.5 * viewport.width(), 0.5 * viewport.width(),
+            -0.5 * viewport.height(), 0.5 * viewport.height(), 0, eyeZ * 10);
+}
+
+void Qt3DCanvas::ortho(float left, float right, float bottom, float top, float zNear, float zFar)
+{
+    projection.setToIdentity();
+    projection.ortho(left, right, bottom, top, zNear, zFar);
+    customProjection = true;
+}
+
+PROCESSING_END_NAMESPACE
@@ -0,0 +1,132 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef P_QT3DCANVAS_H
+#define P_QT3DCANVAS_H
+
+#include "qtcanvas.h"
+#include "qtrasterizer.h"
+#include "tessellator.h"
+#include <QMatrix4x4>
+#include <vector>
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * P3D on the CPU. Geometry is queued in the rasterizer while draw() runs
+ * and rendered into the canvas image at the end of the frame.
+ */
+class Qt3DCanvas : public QtCanvas
+{
+public:
+    explicit Qt3DCanvas(QWidget *parent=0);
+    ~Qt3DCanvas();
+
+    void ellipse(float a, float b, float c, float d) OVERRIDE;
+    void line(float x1, float y1, float x2, float y2) OVERRIDE;
+    void point(float x, float y) OVERRIDE;
+    void quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4) OVERRIDE;
+    void rect(float a, float b, float c, float d) OVERRIDE;
+    using QtCanvas::rect;
+    void triangle(float x1, float y1, float x2, float y2, float x3, float y3) OVERRIDE;
+
+    void box(float w, float h, float d) OVERRIDE;
+    void sphere(float r) OVERRIDE;
+    void sphereDetail(int res) OVERRIDE;
+    void beginShape(ShapeKind kind) OVERRIDE;
+    void vertex(float x, float y, float z) OVERRIDE;
+    using QtCanvas::vertex;
+    void endShape(EndMode mode) OVERRIDE;
+
+    void backgroundARGB(unsigned int argb) OVERRIDE;
+    void text(const std::string &str, float x, float y) OVERRIDE;
+    void lights() OVERRIDE;
+    void noLights() OVERRIDE;
+
+    void pushMatrix() OVERRIDE;
+    void popMatrix() OVERRIDE;
+    void resetMatrix() OVERRIDE;
+    void applyMatrix(const PMatrix2D &m) OVERRIDE;
+    void applyMatrix(const PMatrix3D &m) OVERRIDE;
+    void rotate(float angle) OVERRIDE;
+    void rotateX(float angle) OVERRIDE;
+    void rotateY(float angle) OVERRIDE;
+    void rotateZ(float angle) OVERRIDE;
+    void translate(float x, float y) OVERRIDE;
+    void scale(float x, float y) OVERRIDE;
+    void scale(float x, float y, float z) OVERRIDE;
+    void translate(float x, float y, float z) OVERRIDE;
+    float screenX(float x, float y, float z=0) const OVERRIDE;
+    float screenY(float x, float y, float z=0) const OVERRIDE;
+    float screenZ(float x, float y, float z) const OVERRIDE;
+
+    void camera() OVERRIDE;
+    void camera(float eyeX, float eyeY, float eyeZ, float centerX, float centerY, float centerZ,
+            float upX, float upY, float upZ) OVERRIDE;
+    void perspective() OVERRIDE;
+    void perspective(float fovy, float aspect, float zNear, float zFar) OVERRIDE;
+    void ortho() OVERRIDE;
+    void ortho(float left, float right, float bottom, float top, float zNear, float zFar) OVERRIDE;
+
+    void animate() OVERRIDE;
+
+protected:
+    void resizeBuffer(int width, int height) OVERRIDE;
+    void renderShape(QtShapeCache::Entry &entry, const QPointF &offset) OVERRIDE;
+    void drawCurve(const std::vector<QPointF> &points) OVERRIDE;
+    bool lastVertex(QPointF &point) const OVERRIDE;
+
+private:
+    void mesh(const float *points, const float *normals, const float *baseColors, int count,
+            const int *triangles, int triangleCount, const int *edges, int edgeCount,
+            bool twoSided=false);
+    void polygon(const float *points, const float *baseColors, int count, bool closed);
+    void outline(const QPainterPath &path, const QPointF &offset);
+    void buildSphere();
+    QVector4D project(float x, float y, float z) const;
+
+    QtRasterizer raster;
+    QMatrix4x4 projection;
+    PMatrix3D view;
+    PMatrix3D modelview;
+    std::vector<PMatrix3D> modelviewStack;
+    bool customCamera;
+    bool customProjection;
+    bool lighting;
+
+    // Vertex colors handed to the rasterizer, reused across shapes
+    std::vector<float> colors;
+
+    // Polygons are triangulated in these, reused across shapes as well
+    Tessellator tessellator;
+    std::vector<float> polygonPlane;
+    std::vector<float> polygonNormals;
+    std::vector<int> polygonTriangles;
+    std::vector<int> polygonEdges;
+
+    std::vector<float> shapePoints;
+    std::vector<float> shapeColors;
+
+    // Text goes over the rendered frame, at the screen position of its
+    // anchor
+    struct Label
+    {
+        QString text;
+        int font;
+        float x;
+        float y;
+        QColor color;
+    };
+    std::vector<Label> labels;
+
+    int sphereResolution;
+    std::vector<float> spherePoints;
+    std::vector<int> sphereTriangles;
+    std::vector<int> sphereEdges;
+
+    QSize viewport;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // P_QT3DCANVAS_H
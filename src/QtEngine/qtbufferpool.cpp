@@ -0,0 +1,83 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "qtbufferpool.h"
+
+PROCESSING_BEGIN_NAMESPACE
+
+// Blocks are cache line aligned for the SIMD pixel loops
+static const size_t ALIGNMENT = 64;
+
+// Bound on cached memory, the smallest blocks are dropped first
+static const size_t MAX_FREE_BLOCKS = 2;
+
+QtBufferPool::QtBufferPool()
+    : inUse(0), cached(0)
+{
+}
+
+QtBufferPool::~QtBufferPool()
+{
+    for (size_t i = 0; i < freeBlocks.size(); i++)
+        qFreeAligned(freeBlocks[i].data);
+}
+
+QtBufferPool & QtBufferPool::instance()
+{
+    static QtBufferPool pool;
+    return pool;
+}
+
+QtBufferPool::Block QtBufferPool::acquire(size_t bytes)
+{
+    // Best fit among the cached blocks, but never hand out more than twice
+    // the request so a small buffer does not pin a huge block.
+    size_t best = freeBlocks.size();
+    for (size_t i = 0; i < freeBlocks.size(); i++)
+    {
+        size_t size = freeBlocks[i].bytes;
+        if (size >= bytes && size <= 2 * bytes &&
+                (best == freeBlocks.size() || size < freeBlocks[best].bytes))
+            best = i;
+    }
+
+    Block block;
+    if (best < freeBlocks.size())
+    {
+        block = freeBlocks[best];
+        freeBlocks.erase(freeBlocks.begin() + best);
+        cached -= block.bytes;
+    }
+    else
+    {
+        block.data = (uchar *) qMallocAligned(bytes, ALIGNMENT);
+        if (!block.data)
+            throw "QtBufferPool: out of memory";
+        block.bytes = bytes;
+    }
+    inUse += block.bytes;
+    return block;
+}
+
+void QtBufferPool::release(Block &block)
+{
+    if (!block.data)
+        return;
+    inUse -= block.bytes;
+    freeBlocks.push_back(block);
+    cached += block.bytes;
+    block = Block();
+
+    while (freeBlocks.size() > MAX_FREE_BLOCKS)
+    {
+        size_t smallest = 0;
+        for (size_t i = 1; i < freeBlocks.size(); i++)
+            if (freeBlocks[i].bytes < freeBlocks[smallest].bytes)
+                smallest = i;
+        cached -= freeBlocks[smallest].bytes;
+        qFreeAligned(freeBlocks[smallest].data);
+        freeBlocks.erase(freeBlocks.begin() + smallest);
+    }
+}
+
+PROCESSING_END_NAMESPACE
@@ -0,0 +1,47 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef P_QTBUFFERPOOL_H
+#define P_QTBUFFERPOOL_H
+
+#include <QtGlobal>
+#include <vector>
+#include "pglobal.h"
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * Pixel storage shared by all raster buffers. Released blocks are kept for
+ * reuse so resizing does not hit the allocator on every step.
+ */
+class QtBufferPool
+{
+public:
+    struct Block
+    {
+        Block() : data(0), bytes(0) {}
+        uchar *data;
+        size_t bytes;
+    };
+
+public:
+    static QtBufferPool & instance();
+
+    Block acquire(size_t bytes);
+    void release(Block &block);
+
+    size_t bytesInUse() const { return inUse; }
+    size_t bytesCached() const { return cached; }
+
+private:
+    QtBufferPool();
+    ~QtBufferPool();
+
+    std::vector<Block> freeBlocks;
+    size_t inUse;
+    size_t cached;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // P_QTBUFFERPOOL_H
@@ -3,14 +3,24 @@
  */
 #include "qtcanvas.h"
 #include "qtwindow.h"
+#include "qtbufferpool.h"
 #include "pelement.h"
 #include <QPainter>
 #include <QMouseEvent>
+#include <QResizeEvent>
+#include <QBackingStore>
+#include <QElapsedTimer>
+#include <QtMath>
 #include <iostream>
 #include <cmath>
+#include <cstring>
 
 PROCESSING_BEGIN_NAMESPACE
 
+extern int width;
+extern int height;
+extern int pixelWidth;
+extern int pixelHeight;
 extern int frameCount;
 
 extern bool isMousePressed;
@@ -31,32 +41,69 @@ public:
     virtual QPainter & getPainter();
     virtual QImage & getImage();
     virtual QRect rect() const;
+    virtual void resize(int width, int height);
+    virtual void setAntialiasing(bool on);
+    virtual void setScale(qreal scale);
+    virtual void setFormat(QImage::Format format);
+    virtual size_t byteCount() const { return block.bytes; }
 
 protected:
+    void reallocate(const QSize &size, qreal scale, QImage::Format format);
+
     QPainter painter;
-    QImage *image;
+    QImage image;
+    QtBufferPool::Block block;
+    QSize capacity;
+    QSize size;
+    qreal scale;
+    QImage::Format format;
+    bool antialiasing;
     bool painting;
 };
 
+static QSize pixelSize(const QSize &size, qreal scale)
+{
+    return QSize(qCeil(size.width() * scale), qCeil(size.height() * scale));
+}
+
+// Clears whatever lies outside the kept top-left corner of the image,
+// to transparent or to opaque black for formats without alpha
+static void clearOutside(QImage &image, int keepWidth, int keepHeight)
+{
+    int w = image.width();
+    int h = image.height();
+    quint32 pixel = (image.hasAlphaChannel() ? 0 : 0xFF000000);
+    for (int y = 0; y < h; y++)
+    {
+        quint32 *line = (quint32 *) image.scanLine(y);
+        for (int x = (y < keepHeight ? keepWidth : 0); x < w; x++)
+            line[x] = pixel;
+    }
+}
+
 QtBuffer::QtBuffer(int width, int height)
-    : image(new QImage(width, height, QImage::Format_ARGB32_Premultiplied)),
+    : scale(1.0),
+      format(QImage::Format_ARGB32_Premultiplied),
+      antialiasing(true),
       painting(false)
 {
+    reallocate(QSize(width, height), scale, format);
 }
 
 QtBuffer::~QtBuffer()
 {
     if (painting)
         painter.end();
-    delete image;
+    image = QImage();
+    QtBufferPool::instance().release(block);
 }
 
 QPainter & QtBuffer::getPainter()
 {
     if (!painting)
     {
-        painter.begin(image);
-        painter.setRenderHint(QPainter::Antialiasing);
+        painter.begin(&image);
+        painter.setRenderHint(QPainter::Antialiasing, antialiasing);
         painting = true;
     }
     return painter;
@@ -64,20 +111,120 @@ QPainter & QtBuffer::getPainter()
 
 QImage & QtBuffer::getImage()
 {
+    // The raster engine writes straight into the pixels, so the image is
+    // current while the painter stays active across frames.
+    return image;
+}
+
+QRect QtBuffer::rect() const
+{
+    return QRect(QPoint(0, 0), size);
+}
+
+void QtBuffer::resize(int width, int height)
+{
+    if (QSize(width, height) != size)
+        reallocate(QSize(width, height), scale, format);
+}
+
+void QtBuffer::setAntialiasing(bool on)
+{
+    antialiasing = on;
+    if (painting)
+        painter.setRenderHint(QPainter::Antialiasing, antialiasing);
+}
+
+void QtBuffer::setScale(qreal scale_)
+{
+    if (scale_ != scale)
+        reallocate(size, scale_, format);
+}
+
+void QtBuffer::setFormat(QImage::Format format_)
+{
+    if (format_ != format)
+        reallocate(size, scale, format_);
+}
+
+void QtBuffer::reallocate(const QSize &size_, qreal scale_, QImage::Format format_)
+{
+    // The painter moves over to the new image with its state
+    bool wasPainting = painting;
+    QPen pen;
+    QBrush brush;
+    QTransform transform;
     if (painting)
     {
+        pen = painter.pen();
+        brush = painter.brush();
+        transform = painter.worldTransform();
         painter.end();
         painting = false;
     }
-    return *image;
-}
 
-QRect QtBuffer::rect() const
-{
-    return image->rect();
+    QtBufferPool &pool = QtBufferPool::instance();
+    QtBufferPool::Block oldBlock = block;
+    QImage oldImage = image;
+    QSize pixels = pixelSize(size_, scale_);
+    bool rescaling = (!oldImage.isNull() && (scale_ != scale || format_ != format));
+
+    // The image keeps the logical size through its device pixel ratio, so
+    // painting code and rect() stay in sketch coordinates. Rows are laid
+    // out with the capacity stride, so resizing within the capacity keeps
+    // every pixel where it is.
+    if (rescaling || pixels.width() > capacity.width() || pixels.height() > capacity.height())
+    {
+        QSize grown = pixels;
+        if (!oldImage.isNull() && !rescaling)
+            grown = grown.expandedTo(capacity * 3 / 2);
+        block = pool.acquire((size_t) grown.width() * grown.height() * 4);
+        capacity = grown;
+    }
+    image = QImage(block.data, pixels.width(), pixels.height(),
+            capacity.width() * 4, format_);
+    image.setDevicePixelRatio(scale_);
+
+    if (oldImage.isNull())
+        clearOutside(image, 0, 0);
+    else if (rescaling)
+    {
+        clearOutside(image, 0, 0);
+        QPainter p(&image);
+        p.setRenderHint(QPainter::SmoothPixmapTransform);
+        p.drawImage(QRectF(QPointF(0, 0), QSizeF(size)), oldImage);
+        p.end();
+    }
+    else
+    {
+        int keepWidth = qMin(oldImage.width(), image.width());
+        int keepHeight = qMin(oldImage.height(), image.height());
+        if (block.data != oldBlock.data)
+        {
+            for (int y = 0; y < keepHeight; y++)
+                memcpy(image.scanLine(y), oldImage.constScanLine(y), keepWidth * 4);
+        }
+        clearOutside(image, keepWidth, keepHeight);
+    }
+
+    oldImage = QImage();
+    if (block.data != oldBlock.data)
+        pool.release(oldBlock);
+    size = size_;
+    scale = scale_;
+    format = format_;
+
+    if (wasPainting)
+    {
+        painter.begin(&image);
+        painter.setRenderHint(QPainter::Antialiasing, antialiasing);
+        painter.setPen(pen);
+        painter.setBrush(brush);
+        painter.setWorldTransform(transform);
+        painting = true;
+    }
 }
 
-static QRectF getRect(DrawMode mode, float a, float b, float c, float d)
+QRectF QtCanvas::getRect(DrawMode mode, float a, float b, float c, float d)
 {
     QRectF bbox;
     switch (mode)
@@ -117,15 +264,15 @@ static QRectF getRect(DrawMode mode, float a, float b, float c, float d)
  * QtCanvas class
  */
 QtCanvas::QtCanvas(QWidget *parent)
-    : Canvas(), QWidget(parent), buffer(0)
+    : Canvas(), QWidget(parent), buffer(0),
+      density(1), scale(1.0), qualityScale(1.0), smoothing(2),
+      transformPending(true), clipPending(false), drawnShapes(0), culledShapes(0),
+      shapeKind(POLYGON), tightness(0), fontId(-1), fontScale(0)
 {
     style.ellipse_mode = CENTER;
     style.rect_mode = CORNER;
-    style.color_mode = RGB;
-    max1 = 255;
-    max2 = 255;
-    max3 = 255;
-    maxA = 255;
+    style.clipping = false;
+    style.text_size = style.text_font.getSize();
 }
 
 QtCanvas::~QtCanvas()
@@ -142,61 +289,44 @@ void QtCanvas::pushStyle()
 
 void QtCanvas::popStyle()
 {
+    // restore() brings back the transform as well, the matrix is not styled
     buffer->getPainter().restore();
+    bool clipped = style.clipping;
     style = style_stack.pop();
+    transformPending = true;
+    fontId = -1;
+    if (clipped || style.clipping)
+        clipChanged();
 }
 
 void QtCanvas::arc(float a, float b, float c, float d, float start, float stop, ArcMode mode)
 {
-    float x = a - 0.5 * c;
-    float y = b - 0.5 * d;
-    start *= -2880.0 / M_PI;
-    stop *= -2880.0 / M_PI - start;
-    switch (mode)
-    {
-    case OPEN_PIE:
-        buffer->getPainter().setPen(Qt::NoPen);
-        buffer->getPainter().drawPie(x, y, c, d, start, stop);
-        buffer->getPainter().setPen(style.pen);
-        buffer->getPainter().drawArc(x, y, c, d, start, stop);
-        break;
-
-    case PIE:
-        buffer->getPainter().drawPie(x, y, c, d, start, stop);
-        break;
-
-    case OPEN:
-        buffer->getPainter().setPen(Qt::NoPen);
-        buffer->getPainter().drawChord(x, y, c, d, start, stop);
-        buffer->getPainter().setPen(style.pen);
-        buffer->getPainter().drawArc(x, y, c, d, start, stop);
-        break;
-
-    case CHORD:
-        buffer->getPainter().drawChord(x, y, c, d, start, stop);
-        break;
-    }
+    // Keyed on the size and angles, wherever the arc is
+    float params[6] = { 0, 0, c, d, start, stop };
+    renderShape(shapes.find(ARC, params, 6, mode), QPointF(a, b));
 }
 
 void QtCanvas::ellipse(float a, float b, float c, float d)
 {
+    if (cull(getRect(style.ellipse_mode, a, b, c, d)))
+        return;
     switch (style.ellipse_mode)
     {
         case RADIUS:
         {
             QPointF center(a, b);
-            buffer->getPainter().drawEllipse(center, c, d);
+            getPainter().drawEllipse(center, c, d);
             break;
         }
         case CENTER:
         {
             QPointF center(a, b);
-            buffer->getPainter().drawEllipse(center, 0.5 * c, 0.5 * d);
+            getPainter().drawEllipse(center, 0.5 * c, 0.5 * d);
             break;
         }
         case CORNER:
         {
-            buffer->getPainter().drawEllipse(a, b, c, d);
+            getPainter().drawEllipse(a, b, c, d);
             break;
         }
         case CORNERS:
@@ -204,7 +334,7 @@ void QtCanvas::ellipse(float a, float b, float c, float d)
             QPointF tl(a, b);
             QPointF br(c, d);
             QRectF bbox(tl, br);
-            buffer->getPainter().drawEllipse(bbox);
+            getPainter().drawEllipse(bbox);
             break;
         }
     }
@@ -212,87 +342,283 @@ void QtCanvas::ellipse(float a, float b, float c, float d)
 
 void QtCanvas::line(float x1, float y1, float x2, float y2)
 {
-    buffer->getPainter().drawLine(x1, y1, x2, y2);
+    QPointF points[2] = { QPointF(x1, y1), QPointF(x2, y2) };
+    if (cull(points, 2))
+        return;
+    getPainter().drawLine(x1, y1, x2, y2);
 }
 
 void QtCanvas::point(float x, float y)
 {
-    buffer->getPainter().drawPoint(x, y);
+    if (cull(QRectF(x, y, 0, 0)))
+        return;
+    getPainter().drawPoint(x, y);
 }
 
 void QtCanvas::quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4)
 {
-    QPolygon polygon;
-    polygon << QPoint(x1, y1)
-            << QPoint(x2, y2)
-            << QPoint(x3, y3)
-            << QPoint(x4, y4);
-    buffer->getPainter().drawPolygon(polygon);
+    QPointF points[4] = { QPointF(x1, y1), QPointF(x2, y2), QPointF(x3, y3), QPointF(x4, y4) };
+    if (cull(points, 4))
+        return;
+    getPainter().drawPolygon(points, 4);
 }
 
 void QtCanvas::rect(float a, float b, float c, float d)
 {
     QRectF bbox = getRect(style.rect_mode, a, b, c, d);
-    buffer->getPainter().drawRect(bbox);
+    if (cull(bbox))
+        return;
+    getPainter().drawRect(bbox);
 }
 
 void QtCanvas::rect(float a, float b, float c, float d, float r)
 {
     QRectF bbox = getRect(style.rect_mode, a, b, c, d);
-    buffer->getPainter().drawRoundedRect(bbox, r, r);
+    float params[5] = { 0, 0, (float) bbox.width(), (float) bbox.height(), r };
+    renderShape(shapes.find(RECT, params, 5), bbox.topLeft());
 }
 
 void QtCanvas::rect(float a, float b, float c, float d, float tl, float tr, float br, float bl)
 {
     QRectF bbox = getRect(style.rect_mode, a, b, c, d);
-    QPainterPath path;
-    float x = bbox.x();
-    float y = bbox.y();
-    float w = bbox.width();
-    float h = bbox.height();
-    float hw = 0.5 * w;
-    float hh = 0.5 * h;
-    path.setFillRule(Qt::WindingFill);
-    path.addRoundedRect(x, y, hw, hh, tl, tl);
-    path.addRoundedRect(x + hw, y, hw, hh, tr, tr);
-    path.addRoundedRect(x + hw, y + hw, hw, hh, br, br);
-    path.addRoundedRect(x, y + hw, hw, hh, bl, bl);
-    path.addRect(x + hw - tl, y, tl, tl);
-    path.addRect(x, y + hh - tl, tl, tl);
-    path.addRect(x + hw - tl, y + hh - tl, tl, tl);
-    path.addRect(x + hw, y, tr, tr);
-    path.addRect(x + hw, y + hh - tr, tr, tr);
-    path.addRect(x + w - tr, y + hh - tr, tr, tr);
-    path.addRect(x + hw, y + hh, br, br);
-    path.addRect(x + h - br, y + hh, br, br);
-    path.addRect(x + hw, y + h - br, br, br);
-    path.addRect(x, y + hh, bl, bl);
-    path.addRect(x + hw - bl, y + hh, bl, bl);
-    path.addRect(x + hw - bl, y + h - bl, bl, bl);
-    buffer->getPainter().drawPath(path.simplified());
+    float params[8] = { 0, 0, (float) bbox.width(), (float) bbox.height(), tl, tr, br, bl };
+    renderShape(shapes.find(RECT, params, 8), bbox.topLeft());
 }
 
 void QtCanvas::triangle(float x1, float y1, float x2, float y2, float x3, float y3)
 {
-    QPolygon polygon;
-    polygon << QPoint(x1, y1)
-            << QPoint(x2, y2)
-            << QPoint(x3, y3);
-    buffer->getPainter().drawPolygon(polygon);
+    QPointF points[3] = { QPointF(x1, y1), QPointF(x2, y2), QPointF(x3, y3) };
+    if (cull(points, 3))
+        return;
+    getPainter().drawPolygon(points, 3);
+}
+
+void QtCanvas::beginShape(ShapeKind kind)
+{
+    shapeKind = kind;
+    shapeVertices.clear();
+    curveVertices.clear();
+}
+
+void QtCanvas::vertex(float x, float y, float z)
+{
+    (void) z;
+    shapeVertices.push_back(x);
+    shapeVertices.push_back(y);
+}
+
+void QtCanvas::endShape(EndMode mode)
+{
+    // Built for this one draw, nothing is cached
+    QtShapeCache::build(shapeKind, shapeVertices.data(), shapeVertices.size() / 2, mode, immediate.geometry);
+    immediate.mesh.level = INT_MIN;
+    renderShape(immediate, QPointF());
+}
+
+bool QtCanvas::lastVertex(QPointF &point) const
+{
+    if (shapeVertices.empty())
+        return false;
+    point = QPointF(shapeVertices[shapeVertices.size() - 2], shapeVertices.back());
+    return true;
+}
+
+void QtCanvas::bezier(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4)
+{
+    float controls[8] = { x1, y1, x2, y2, x3, y3, x4, y4 };
+    drawCurve(curves.find(controls, curveScale()));
+}
+
+void QtCanvas::curve(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4)
+{
+    float points[8] = { x1, y1, x2, y2, x3, y3, x4, y4 };
+    float controls[8];
+    QtCurveCache::fromCurve(points, tightness, controls);
+    drawCurve(curves.find(controls, curveScale()));
+}
+
+void QtCanvas::curveTightness(float tightness_)
+{
+    tightness = tightness_;
+}
+
+void QtCanvas::bezierVertex(float x2, float y2, float x3, float y3, float x4, float y4)
+{
+    QPointF start;
+    if (!lastVertex(start))
+        throw "bezierVertex(): call vertex() first";
+    float controls[8] = { (float) start.x(), (float) start.y(), x2, y2, x3, y3, x4, y4 };
+    addCurveVertices(curves.find(controls, curveScale()));
+}
+
+void QtCanvas::curveVertex(float x, float y)
+{
+    // As in Processing, the curve runs from the second point to the last
+    // but one, each new point adds the segment before its predecessor
+    curveVertices.push_back(x);
+    curveVertices.push_back(y);
+    int count = curveVertices.size() / 2;
+    if (count < 4)
+        return;
+    const float *points = &curveVertices[2 * (count - 4)];
+    if (count == 4)
+        vertex(points[2], points[3]);
+    float controls[8];
+    QtCurveCache::fromCurve(points, tightness, controls);
+    addCurveVertices(curves.find(controls, curveScale()));
+}
+
+void QtCanvas::addCurveVertices(const std::vector<QPointF> &points)
+{
+    // The first point is the vertex the curve starts from
+    for (size_t i = 1; i < points.size(); i++)
+        vertex(points[i].x(), points[i].y());
+}
+
+void QtCanvas::drawCurve(const std::vector<QPointF> &points)
+{
+    // The fill closes along the chord, the stroke is a single polyline
+    if (cull(points.data(), points.size()))
+        return;
+    QPainter &painter = getPainter();
+    if (style.brush.style() != Qt::NoBrush)
+    {
+        painter.setPen(Qt::NoPen);
+        painter.drawPolygon(points.data(), points.size());
+        painter.setPen(style.pen);
+    }
+    if (style.pen.style() != Qt::NoPen)
+        painter.drawPolyline(points.data(), points.size());
+}
+
+void QtCanvas::drawShape(const PShape &s)
+{
+    renderShape(shapes.find(s), QPointF());
+}
+
+void QtCanvas::renderShape(QtShapeCache::Entry &entry, const QPointF &offset)
+{
+    const QtShapeGeometry &g = entry.geometry;
+    if (g.fill.isEmpty() && g.stroke.isEmpty() && g.points.isEmpty())
+        return;
+    if (cull(g.bounds.translated(offset)))
+        return;
+    QPainter &painter = getPainter();
+    QTransform transform = painter.transform();
+    painter.translate(offset);
+    if (g.shared)
+        painter.drawPath(g.fill);
+    else
+    {
+        if (!g.fill.isEmpty() && style.brush.style() != Qt::NoBrush)
+            painter.fillPath(g.fill, style.brush);
+        if (!g.stroke.isEmpty() && style.pen.style() != Qt::NoPen)
+            painter.strokePath(g.stroke, style.pen);
+    }
+    if (!g.points.isEmpty())
+        painter.drawPoints(g.points);
+    painter.setTransform(transform);
+}
+
+int QtCanvas::currentFont()
+{
+    qreal ds = deviceScale();
+    if (fontId < 0 || fontScale != ds)
+    {
+        fontId = texts.findFont(style.text_font, style.text_size, ds);
+        fontScale = ds;
+    }
+    return fontId;
+}
+
+void QtCanvas::textFont(const PFont &font, float size)
+{
+    if (size <= 0)
+        throw "textFont(): size must be positive";
+    style.text_font = font;
+    style.text_size = size;
+    fontId = -1;
+}
+
+void QtCanvas::textSize(float size)
+{
+    if (size <= 0)
+        throw "textSize(): size must be positive";
+    style.text_size = size;
+    fontId = -1;
+}
+
+float QtCanvas::textWidth(const std::string &str)
+{
+    return texts.run(currentFont(), QString::fromStdString(str)).width / deviceScale();
+}
+
+void QtCanvas::text(const std::string &str, float x, float y)
+{
+    // Drawn in the fill color with the first baseline at y
+    if (style.brush.style() == Qt::NoBrush || str.empty())
+        return;
+    const QtTextCache::Run &run = texts.run(currentFont(), QString::fromStdString(str));
+    qreal ds = deviceScale();
+    if (cull(QRectF(x, y - run.ascent / ds, run.width / ds, run.height / ds)))
+        return;
+    drawRun(run, x, y, style.brush.color(), matrix);
+}
+
+void QtCanvas::drawRun(const QtTextCache::Run &run, float x, float y, const QColor &color, const PMatrix2D &m)
+{
+    // Runs are laid out in device pixels
+    QPainter &painter = getPainter();
+    qreal ds = deviceScale();
+    QTransform device = QTransform::fromScale(1 / ds, 1 / ds);
+    bool smooth = run.smooth;
+    if (m.m00 == 1 && m.m11 == 1 && m.m01 == 0 && m.m10 == 0)
+    {
+        // Neither rotated nor scaled, every glyph is copied from the atlas
+        // to whole device pixels
+        painter.setWorldTransform(device);
+        QPointF origin((x + m.m02) * ds, (y + m.m12) * ds - run.ascent);
+        QtTextCache::Glyph g;
+        for (int i = 0; i < run.glyphs.size(); i++)
+        {
+            const QGlyphRun &glyphs = run.glyphs[i];
+            QRawFont raw = glyphs.rawFont();
+            int face = texts.faceOf(raw, smooth);
+            QVector<quint32> indexes = glyphs.glyphIndexes();
+            QVector<QPointF> positions = glyphs.positions();
+            for (int k = 0; k < indexes.size(); k++)
+            {
+                if (!texts.glyph(face, raw, indexes[k], color.rgba(), smooth, g))
+                    continue;
+                QPointF p = origin + positions[k];
+                painter.drawImage(QPoint(qRound(p.x()) + g.offset.x(), qRound(p.y()) + g.offset.y()),
+                        texts.atlas(), g.rect);
+            }
+        }
+    }
+    else
+    {
+        painter.setWorldTransform(device * toTransform(m));
+        QPen pen = painter.pen();
+        bool hinted = painter.testRenderHint(QPainter::TextAntialiasing);
+        painter.setPen(color);
+        painter.setRenderHint(QPainter::TextAntialiasing, smooth);
+        for (int i = 0; i < run.glyphs.size(); i++)
+            painter.drawGlyphRun(QPointF(x * ds, y * ds - run.ascent), run.glyphs[i]);
+        painter.setRenderHint(QPainter::TextAntialiasing, hinted);
+        painter.setPen(pen);
+    }
+    transformPending = true;
 }
 
 void QtCanvas::colorMode(ColorMode mode)
 {
-    style.color_mode = mode;
+    style.colors.setMode(mode);
 }
 
-void QtCanvas::colorMode(ColorMode mode, float max1_, float max2_, float max3_, float maxA_)
+void QtCanvas::colorMode(ColorMode mode, float max1, float max2, float max3, float maxA)
 {
-    style.color_mode = mode;
-    max1 = max1_;
-    max2 = max2_;
-    max3 = max3_;
-    maxA = maxA_;
+    style.colors.setMode(mode, max1, max2, max3, maxA);
 }
 
 void QtCanvas::background(int rgb)
@@ -300,30 +626,19 @@ void QtCanvas::background(int rgb)
     background(rgb, rgb, rgb);
 }
 
-static void color_map(int *v1, int *v2, int *v3, int *alpha, float max1, float max2, float max3, float maxA)
+void QtCanvas::background(int v1, int v2, int v3, int alpha)
 {
-    (*v1) *= 255 / max1;
-    (*v2) *= 255 / max2;
-    (*v3) *= 255 / max3;
-    (*alpha) *= 255 / maxA;
-    if ((*v1) > 255)
-        (*v1) = 255;
-    if ((*v2) > 255)
-        (*v2) = 255;
-    if ((*v3) > 255)
-        (*v3) = 255;
-    if ((*alpha) > 255)
-        (*alpha) = 255;
+    backgroundARGB(style.colors.toARGB(v1, v2, v3, alpha));
 }
 
-void QtCanvas::background(int v1, int v2, int v3, int alpha)
+void QtCanvas::backgroundARGB(unsigned int argb)
 {
-    color_map(&v1, &v2, &v3, &alpha, max1, max2, max3, maxA);
-    QColor c = (style.color_mode == HSB
-            ? QColor::fromHsv(v1, v2, v3, alpha)
-            : QColor::fromRgb(v1, v2, v3, alpha));
-    QBrush background(c);
-    buffer->getPainter().fillRect(buffer->rect(), background);
+    // The background covers the whole buffer whatever the matrix is
+    QBrush background(QColor::fromRgba(argb));
+    QPainter &painter = getPainter();
+    painter.resetTransform();
+    painter.fillRect(buffer->rect(), background);
+    transformPending = true;
 }
 
 void QtCanvas::fill(int gray, int alpha)
@@ -333,17 +648,19 @@ void QtCanvas::fill(int gray, int alpha)
 
 void QtCanvas::fill(int v1, int v2, int v3, int alpha)
 {
-    color_map(&v1, &v2, &v3, &alpha, max1, max2, max3, maxA);
-    QColor c = (style.color_mode == HSB
-            ? QColor::fromHsv(v1, v2, v3, alpha)
-            : QColor::fromRgb(v1, v2, v3, alpha));
-    style.brush = QBrush(c);
+    fillARGB(style.colors.toARGB(v1, v2, v3, alpha));
+}
+
+void QtCanvas::fillARGB(unsigned int argb)
+{
+    style.brush = QBrush(QColor::fromRgba(argb));
     buffer->getPainter().setBrush(style.brush);
 }
 
 void QtCanvas::noFill()
 {
-    buffer->getPainter().setBrush(Qt::NoBrush);
+    style.brush = QBrush(Qt::NoBrush);
+    buffer->getPainter().setBrush(style.brush);
 }
 
 void QtCanvas::stroke(int gray, int alpha)
@@ -353,12 +670,13 @@ void QtCanvas::stroke(int gray, int alpha)
 
 void QtCanvas::stroke(int v1, int v2, int v3, int alpha)
 {
-    color_map(&v1, &v2, &v3, &alpha, max1, max2, max3, maxA);
-    QColor c = (style.color_mode == HSB
-            ? QColor::fromHsv(v1, v2, v3, alpha)
-            : QColor::fromRgb(v1, v2, v3, alpha));
+    strokeARGB(style.colors.toARGB(v1, v2, v3, alpha));
+}
+
+void QtCanvas::strokeARGB(unsigned int argb)
+{
     int width = style.pen.width();
-    style.pen = QPen(c);
+    style.pen = QPen(QColor::fromRgba(argb));
     style.pen.setWidth(width);
     style.pen.setCapStyle(Qt::RoundCap);
     buffer->getPainter().setPen(style.pen);
@@ -366,7 +684,8 @@ void QtCanvas::stroke(int v1, int v2, int v3, int alpha)
 
 void QtCanvas::noStroke()
 {
-    buffer->getPainter().setPen(Qt::NoPen);
+    style.pen.setStyle(Qt::NoPen);
+    buffer->getPainter().setPen(style.pen);
 }
 
 void QtCanvas::ellipseMode(DrawMode mode)
@@ -385,20 +704,298 @@ void QtCanvas::strokeWeight(int weight)
     buffer->getPainter().setPen(style.pen);
 }
 
-void QtCanvas::rotate(float angle)
+void QtCanvas::clip(float a, float b, float c, float d)
+{
+    // Corner and size as given, there is no imageMode() yet
+    QRectF local = QRectF(a, b, c, d).normalized();
+    QPolygonF device;
+    device << QPointF(matrix.multX(local.left(), local.top()), matrix.multY(local.left(), local.top()))
+           << QPointF(matrix.multX(local.right(), local.top()), matrix.multY(local.right(), local.top()))
+           << QPointF(matrix.multX(local.right(), local.bottom()), matrix.multY(local.right(), local.bottom()))
+           << QPointF(matrix.multX(local.left(), local.bottom()), matrix.multY(local.left(), local.bottom()));
+
+    style.clipping = true;
+    style.clip_bounds = device.boundingRect();
+    if (matrix.isAxisAligned())
+    {
+        // Edges snap to whole pixels, the painter and GL scissor either way
+        QRectF r = style.clip_bounds;
+        style.clip_scissor = QRect(QPoint(qRound(r.left()), qRound(r.top())),
+                QPoint(qRound(r.right()) - 1, qRound(r.bottom()) - 1));
+        style.clip_bounds = style.clip_scissor;
+        style.clip_polygon.clear();
+    }
+    else
+    {
+        style.clip_scissor = QRect();
+        style.clip_polygon = device;
+    }
+    clipChanged();
+}
+
+void QtCanvas::noClip()
 {
-    buffer->getPainter().rotate(angle * 180.0 / M_PI);
+    if (!style.clipping)
+        return;
+    style.clipping = false;
+    style.clip_polygon.clear();
+    clipChanged();
 }
 
-void QtCanvas::translate(float x, float y)
+void QtCanvas::clipChanged()
 {
-    buffer->getPainter().translate(x, y);
+    clipPending = true;
+}
+
+QTransform QtCanvas::toTransform(const PMatrix2D &m)
+{
+    return QTransform(m.m00, m.m10, m.m01, m.m11, m.m02, m.m12);
+}
+
+void QtCanvas::matrixChanged()
+{
+    transformPending = true;
+}
+
+bool QtCanvas::cull(const QRectF &bounds)
+{
+    // A clip with no area left after snapping lets nothing through
+    if (style.clipping && style.clip_bounds.isEmpty())
+        return true;
+
+    // The stroke reaches half its width past the outline, a square cap or
+    // a bevel corner up to sqrt(2) times that and a miter its limit
+    qreal margin = 1; // antialiasing
+    if (style.pen.style() != Qt::NoPen)
+    {
+        qreal reach = M_SQRT2;
+        if (style.pen.joinStyle() == Qt::MiterJoin || style.pen.joinStyle() == Qt::SvgMiterJoin)
+            reach = qMax(reach, style.pen.miterLimit());
+        margin += 0.5 * qMax(style.pen.widthF(), 1.0) * reach;
+    }
+    QRectF local = bounds.normalized().adjusted(-margin, -margin, margin, margin);
+
+    // The box of the transformed corners holds the transformed shape
+    float xs[4] = { (float) local.left(), (float) local.right(), (float) local.right(), (float) local.left() };
+    float ys[4] = { (float) local.top(), (float) local.top(), (float) local.bottom(), (float) local.bottom() };
+    float minX = matrix.multX(xs[0], ys[0]), maxX = minX;
+    float minY = matrix.multY(xs[0], ys[0]), maxY = minY;
+    for (int i = 1; i < 4; i++)
+    {
+        float x = matrix.multX(xs[i], ys[i]);
+        float y = matrix.multY(xs[i], ys[i]);
+        minX = qMin(minX, x);
+        maxX = qMax(maxX, x);
+        minY = qMin(minY, y);
+        maxY = qMax(maxY, y);
+    }
+
+    // Whatever the clip leaves out is dropped here as well
+    QRectF target = buffer->rect();
+    if (style.clipping)
+        target &= style.clip_bounds;
+    if (target.isEmpty() || maxX < target.left() || minX > target.right()
+            || maxY < target.top() || minY > target.bottom())
+    {
+        culledShapes++;
+        return true;
+    }
+    drawnShapes++;
+    return false;
+}
+
+bool QtCanvas::cull(const QPointF *points, int count)
+{
+    qreal minX = points[0].x(), maxX = minX;
+    qreal minY = points[0].y(), maxY = minY;
+    for (int i = 1; i < count; i++)
+    {
+        minX = qMin(minX, points[i].x());
+        maxX = qMax(maxX, points[i].x());
+        minY = qMin(minY, points[i].y());
+        maxY = qMax(maxY, points[i].y());
+    }
+    return cull(QRectF(QPointF(minX, minY), QPointF(maxX, maxY)));
+}
+
+QPainter & QtCanvas::getPainter()
+{
+    // The painter only learns about the matrix and the clip when
+    // something is drawn. The clip is in device space.
+    QPainter &painter = buffer->getPainter();
+    if (clipPending)
+    {
+        painter.resetTransform();
+        if (!style.clipping)
+            painter.setClipping(false);
+        else if (style.clip_polygon.isEmpty())
+            painter.setClipRect(style.clip_scissor);
+        else
+        {
+            QPainterPath path;
+            path.addPolygon(style.clip_polygon);
+            painter.setClipPath(path);
+        }
+        clipPending = false;
+        transformPending = true;
+    }
+    if (transformPending)
+    {
+        painter.setWorldTransform(toTransform(matrix));
+        transformPending = false;
+    }
+    return painter;
 }
 
 void QtCanvas::animate()
 {
+    beginFrame();
     Canvas::animate();
-    update();
+    endFrame();
+    if (isPresenting())
+        update();
+}
+
+void QtCanvas::beginFrame()
+{
+    savePendingFrames();
+    if (!buffer->isCreated())
+        return;
+
+    // The painter lives across frames, Canvas::animate() resets the matrix
+    QPainter &painter = buffer->getPainter();
+    painter.setPen(style.pen);
+    painter.setBrush(style.brush);
+}
+
+void QtCanvas::endFrame()
+{
+    stats.bufferBytes = buffer->byteCount();
+    stats.drawnShapes = drawnShapes;
+    stats.culledShapes = culledShapes;
+    drawnShapes = 0;
+    culledShapes = 0;
+}
+
+void QtCanvas::applyQuality(Quality level)
+{
+    updateSmoothing();
+    qualityScale = (level < QUALITY_LOW_RES ? 1.0 : 0.5);
+    updateScale();
+}
+
+void QtCanvas::smooth(int level)
+{
+    if (level < 0)
+        throw "smooth(): level must not be negative";
+    smoothing = level;
+    updateSmoothing();
+}
+
+void QtCanvas::noSmooth()
+{
+    smooth(0);
+}
+
+void QtCanvas::updateSmoothing()
+{
+    // The governor may turn smoothing off for a while, not on
+    if (buffer)
+        buffer->setSamples(quality() < QUALITY_NO_SMOOTH ? smoothing : 0);
+}
+
+void QtCanvas::pixelDensity(int density_)
+{
+    density = (density_ < 1 ? 1 : density_);
+    updateScale();
+}
+
+int QtCanvas::displayDensity() const
+{
+    return (devicePixelRatioF() > 1.0 ? 2 : 1);
+}
+
+void QtCanvas::renderScale(float scale_)
+{
+    if (scale_ <= 0)
+        throw "renderScale(): scale must be positive";
+    scale = scale_;
+    updateScale();
+}
+
+void QtCanvas::updateScale()
+{
+    // The sketch keeps drawing in width x height, only the backing pixels
+    // change. Below 1.0 the frame is upscaled when presented.
+    if (buffer)
+        buffer->setScale(density * scale * qualityScale);
+}
+
+unsigned int * QtCanvas::loadPixels()
+{
+    // pixels[] is pixelWidth x pixelHeight whatever the render scale is
+    QImage image = buffer->readPixels();
+    QSize target = buffer->rect().size() * density;
+    if (image.size() != target)
+        image = image.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    image = image.convertToFormat(QImage::Format_ARGB32);
+
+    pixels.resize(target.width() * target.height());
+    for (int y = 0; y < target.height(); y++)
+        memcpy(&pixels[y * target.width()], image.constScanLine(y), target.width() * 4);
+    return pixels.data();
+}
+
+void QtCanvas::updatePixels()
+{
+    QRect r = buffer->rect();
+    if (pixels.size() != (size_t) (r.width() * density * r.height() * density))
+        throw "updatePixels(): call loadPixels() first";
+
+    QImage image((const uchar *) pixels.data(), r.width() * density,
+            r.height() * density, QImage::Format_ARGB32);
+    image.setDevicePixelRatio(density);
+
+    QPainter &painter = buffer->getPainter();
+    painter.save();
+    painter.resetTransform();
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(0, 0, image);
+    painter.restore();
+}
+
+void QtCanvas::saveFrame(const char *filename)
+{
+    // A run of '#' becomes the zero padded frame number
+    QString name = QString::fromLocal8Bit(filename);
+    int first = name.indexOf('#');
+    if (first >= 0)
+    {
+        int last = first;
+        while (last + 1 < name.size() && name[last + 1] == '#')
+            last++;
+        int digits = last - first + 1;
+        name.replace(first, digits, QString("%1").arg(frameCount, digits, 10, QChar('0')));
+    }
+
+    // Buffers that read back asynchronously are saved at the start of the
+    // next frame, by then the transfer has finished without a stall
+    if (buffer->requestPixels())
+        pendingFrames << name;
+    else if (!buffer->readPixels().save(name))
+        throw "saveFrame(): cannot write the file";
+}
+
+void QtCanvas::savePendingFrames()
+{
+    if (pendingFrames.isEmpty())
+        return;
+
+    QImage &image = buffer->readPixels();
+    for (int i = 0; i < pendingFrames.size(); i++)
+        if (!image.save(pendingFrames[i]))
+            std::cerr << "saveFrame(): cannot write " << pendingFrames[i].toLocal8Bit().constData() << std::endl;
+    pendingFrames.clear();
 }
 
 IQtBuffer * QtCanvas::getBuffer()
@@ -408,18 +1005,83 @@ IQtBuffer * QtCanvas::getBuffer()
 
 void QtCanvas::paintEvent(QPaintEvent *event)
 {
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    // Once the buffer has the backing store's pixel format and an opaque
+    // window, presenting is a plain row copy: no conversion, no blending
+    // and no background erase.
+    QBackingStore *store = backingStore();
+    if (store && store->paintDevice()->devType() == QInternal::Image)
+    {
+        QImage::Format target = static_cast<QImage *>(store->paintDevice())->format();
+        if (target == QImage::Format_RGB32)
+        {
+            buffer->setFormat(target);
+            setAttribute(Qt::WA_OpaquePaintEvent);
+        }
+    }
+
     QPainter painter;
     QRect dirtyRect = event->rect();
+    QImage &image = buffer->getImage();
+    qreal ratio = image.devicePixelRatio();
+    QRectF source(dirtyRect.x() * ratio, dirtyRect.y() * ratio,
+            dirtyRect.width() * ratio, dirtyRect.height() * ratio);
     painter.begin(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.drawImage(dirtyRect, buffer->getImage(), dirtyRect);
+    if (!image.hasAlphaChannel())
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(QRectF(dirtyRect), image, source);
     painter.end();
+
+    stats.presentTime = elapsed.nsecsElapsed() / 1e6f;
 }
 
 void QtCanvas::setFixedSize(int w, int h)
 {
     QWidget::setFixedSize(w, h);
-    buffer = new QtBuffer(w, h);
+    resizeBuffer(w, h);
+}
+
+void QtCanvas::setResizable(bool resizable)
+{
+    if (resizable)
+    {
+        setMinimumSize(P_WIDTH_MINIMUM, P_HEIGHT_MINIMUM);
+        setMaximumSize(QWIDGETSIZE_MAX, QWIDGETSIZE_MAX);
+    }
+    else
+        QWidget::setFixedSize(size());
+}
+
+void QtCanvas::resizeBuffer(int w, int h)
+{
+    if (buffer)
+        buffer->resize(w, h);
+    else
+    {
+        buffer = new QtBuffer(w, h);
+        updateSmoothing();
+    }
+    // A new painter starts without the clip
+    if (style.clipping)
+        clipChanged();
+    updateScale();
+}
+
+void QtCanvas::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    if (!buffer || event->size() == buffer->rect().size())
+        return;
+
+    resizeBuffer(event->size().width(), event->size().height());
+    width = event->size().width();
+    height = event->size().height();
+    pixelWidth = width * density;
+    pixelHeight = height * density;
+    if (callbacks["windowResized"])
+        callbacks["windowResized"]();
 }
 
 void QtCanvas::mousePressEvent(QMouseEvent *event)
@@ -11,8 +11,15 @@
 #include <QPainter>
 #include <QBrush>
 #include <QPen>
+#include <QPolygonF>
+#include <QStringList>
+#include <QtMath>
+#include <vector>
 #include "pglobal.h"
 #include "canvas.h"
+#include "qtshapecache.h"
+#include "qtcurvecache.h"
+#include "qttextcache.h"
 
 PROCESSING_BEGIN_NAMESPACE
 
@@ -23,6 +30,15 @@ public:
     virtual QPainter & getPainter() = 0;
     virtual QImage & getImage() = 0;
     virtual QRect rect() const = 0;
+    virtual void resize(int width, int height) = 0;
+    virtual void setAntialiasing(bool on) { (void) on; }
+    virtual void setSamples(int samples) { setAntialiasing(samples > 0); }
+    virtual bool isCreated() const { return true; }
+    virtual size_t byteCount() const { return 0; }
+    virtual void setScale(qreal scale) { (void) scale; }
+    virtual void setFormat(QImage::Format format) { (void) format; }
+    virtual QImage & readPixels() { return getImage(); }
+    virtual bool requestPixels() { return false; }
 };
 
 struct StyleData
@@ -31,7 +47,17 @@ struct StyleData
     QPen pen;
     DrawMode ellipse_mode;
     DrawMode rect_mode;
-    ColorMode color_mode;
+    ColorSpace colors;
+
+    // The clip in device space: an integer scissor while the matrix keeps
+    // it axis aligned, otherwise a polygon with its bounds in clip_bounds
+    bool clipping;
+    QRect clip_scissor;
+    QPolygonF clip_polygon;
+    QRectF clip_bounds;
+
+    PFont text_font;
+    float text_size;
 };
 
 class QtCanvas : public Canvas, public QWidget
@@ -55,8 +81,19 @@ public:
     virtual void rect(float a, float b, float c, float d, float tl, float tr, float br, float bl) OVERRIDE;
     virtual void triangle(float x1, float y1, float x2, float y2, float x3, float y3) OVERRIDE;
 
+    virtual void beginShape(ShapeKind kind) OVERRIDE;
+    virtual void vertex(float x, float y, float z) OVERRIDE;
+    using Canvas::vertex;
+    virtual void endShape(EndMode mode) OVERRIDE;
+    virtual void bezier(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4) OVERRIDE;
+    virtual void bezierVertex(float x2, float y2, float x3, float y3, float x4, float y4) OVERRIDE;
+    virtual void curve(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4) OVERRIDE;
+    virtual void curveVertex(float x, float y) OVERRIDE;
+    virtual void curveTightness(float tightness) OVERRIDE;
+
     virtual void colorMode(ColorMode mode) OVERRIDE;
     virtual void colorMode(ColorMode mode, float max1, float max2, float max3, float maxA) OVERRIDE;
+    virtual const ColorSpace & colorSpace() const OVERRIDE { return style.colors; }
     virtual void background(int rgb) OVERRIDE;
     virtual void background(int v1, int v2, int v3, int alpha = 255) OVERRIDE;
     virtual void fill(int gray, int alpha = 255) OVERRIDE;
@@ -65,21 +102,65 @@ public:
     virtual void stroke(int gray, int alpha = 255) OVERRIDE;
     virtual void stroke(int v1, int v2, int v3, int alpha = 255) OVERRIDE;
     virtual void noStroke() OVERRIDE;
+    virtual void backgroundARGB(unsigned int argb) OVERRIDE;
+    virtual void fillARGB(unsigned int argb) OVERRIDE;
+    virtual void strokeARGB(unsigned int argb) OVERRIDE;
 
     virtual void ellipseMode(DrawMode mode) OVERRIDE;
     virtual void rectMode(DrawMode mode) OVERRIDE;
     virtual void strokeWeight(int weight) OVERRIDE;
+    virtual void clip(float a, float b, float c, float d) OVERRIDE;
+    virtual void noClip() OVERRIDE;
+
+    virtual void text(const std::string &str, float x, float y) OVERRIDE;
+    virtual void textFont(const PFont &font, float size) OVERRIDE;
+    virtual void textSize(float size) OVERRIDE;
+    virtual float textWidth(const std::string &str) OVERRIDE;
+
+    virtual void pixelDensity(int density) OVERRIDE;
+    virtual int displayDensity() const OVERRIDE;
+    virtual void renderScale(float scale) OVERRIDE;
+    virtual void smooth(int level) OVERRIDE;
+    virtual void noSmooth() OVERRIDE;
 
-    virtual void rotate(float angle) OVERRIDE;
-    virtual void translate(float x, float y) OVERRIDE;
+    virtual unsigned int * loadPixels() OVERRIDE;
+    virtual void updatePixels() OVERRIDE;
+    virtual void saveFrame(const char *filename) OVERRIDE;
 
     virtual void setFixedSize(int width, int height);
+    virtual void setResizable(bool resizable) OVERRIDE;
     virtual bool hasParent() const OVERRIDE { return true; }
     virtual void animate();
 
     virtual IQtBuffer * getBuffer();
 
 protected:
+    static QRectF getRect(DrawMode mode, float a, float b, float c, float d);
+    static QTransform toTransform(const PMatrix2D &m);
+    QPainter & getPainter();
+    bool cull(const QRectF &bounds);
+    bool cull(const QPointF *points, int count);
+    virtual void matrixChanged() OVERRIDE;
+    virtual void clipChanged();
+    virtual void drawShape(const PShape &s) OVERRIDE;
+    // The geometry is drawn moved by offset, primitives are cached at the origin
+    virtual void renderShape(QtShapeCache::Entry &entry, const QPointF &offset);
+    virtual void drawCurve(const std::vector<QPointF> &points);
+    virtual bool lastVertex(QPointF &point) const;
+    void addCurveVertices(const std::vector<QPointF> &points);
+    float curveScale() const { return qSqrt(qAbs(matrix.determinant())); }
+    qreal deviceScale() const { return density * scale * qualityScale; }
+    int currentFont();
+    void drawRun(const QtTextCache::Run &run, float x, float y, const QColor &color, const PMatrix2D &m);
+    bool isPathClipped() const { return style.clipping && !style.clip_polygon.isEmpty(); }
+    virtual void applyQuality(Quality level) OVERRIDE;
+    void beginFrame();
+    void endFrame();
+    void savePendingFrames();
+    void updateScale();
+    void updateSmoothing();
+    virtual void resizeBuffer(int width, int height);
+    void resizeEvent(QResizeEvent *event) Q_DECL_OVERRIDE;
     void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
     void mousePressEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
     void mouseMoveEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
@@ -93,10 +174,32 @@ protected:
     QStack<StyleData> style_stack;
     StyleData style;
     IQtBuffer *buffer;
-    float max1;
-    float max2;
-    float max3;
-    float maxA;
+    int density;
+    float scale;
+    float qualityScale;
+    int smoothing;
+    bool transformPending;
+    bool clipPending;
+    int drawnShapes;
+    int culledShapes;
+    std::vector<unsigned int> pixels;
+    QStringList pendingFrames;
+
+    // Built shapes, and the one between beginShape() and endShape()
+    QtShapeCache shapes;
+    QtShapeCache::Entry immediate;
+    ShapeKind shapeKind;
+    std::vector<float> shapeVertices;
+
+    // Flattened curves, and the curveVertex() points of the current shape
+    QtCurveCache curves;
+    std::vector<float> curveVertices;
+    float tightness;
+
+    // Shaped text and glyphs, the font of the style as resolved at fontScale
+    QtTextCache texts;
+    int fontId;
+    qreal fontScale;
 };
 
 PROCESSING_END_NAMESPACE
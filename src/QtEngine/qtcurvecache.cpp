@@ -0,0 +1,110 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "qtcurvecache.h"
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+PROCESSING_BEGIN_NAMESPACE
+
+// Number of curves kept
+#define P_CURVE_CACHE_SIZE 256
+
+// Largest distance in pixels between a curve and its polyline
+#define P_CURVE_TOLERANCE 0.25f
+
+// Segments of a single curve at most
+#define P_CURVE_MAX_SEGMENTS 1024
+
+static unsigned long long curveKey(const float *controls, int level)
+{
+    // FNV-1a over the control point bits and the level
+    unsigned long long hash = 14695981039346656037ULL;
+    const unsigned char *bytes = (const unsigned char *) controls;
+    for (size_t i = 0; i < 8 * sizeof(float); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    hash ^= (unsigned int) level;
+    hash *= 1099511628211ULL;
+    return hash;
+}
+
+QtCurveCache::QtCurveCache()
+    : cache(P_CURVE_CACHE_SIZE)
+{
+}
+
+const std::vector<QPointF> & QtCurveCache::find(const float *controls, float scale)
+{
+    int level = qBound(-4, qCeil(std::log2(qMax(scale, 1e-3f))), 8);
+    unsigned long long key = curveKey(controls, level);
+    Entry *entry = cache.object(key);
+    if (entry && entry->level == level && std::equal(controls, controls + 8, entry->controls))
+        return entry->points;
+
+    entry = new Entry;
+    std::copy(controls, controls + 8, entry->controls);
+    entry->level = level;
+    flatten(controls, std::ldexp(P_CURVE_TOLERANCE, -level), entry->points);
+    cache.insert(key, entry);
+    return entry->points;
+}
+
+void QtCurveCache::flatten(const float *c, float tolerance, std::vector<QPointF> &out)
+{
+    // Wang's formula: n segments keep a cubic within the tolerance when
+    // n^2 >= 3 * 2 / 8 * max |P(i) - 2 P(i+1) + P(i+2)| / tolerance
+    double ax = c[0] - 2 * c[2] + c[4], ay = c[1] - 2 * c[3] + c[5];
+    double bx = c[2] - 2 * c[4] + c[6], by = c[3] - 2 * c[5] + c[7];
+    double bend = std::sqrt(qMax(ax * ax + ay * ay, bx * bx + by * by));
+    int n = qBound(1, (int) std::ceil(std::sqrt(0.75 * bend / tolerance)), P_CURVE_MAX_SEGMENTS);
+
+    // Forward differences of the polynomial form, in double so the error
+    // does not pile up over a thousand steps
+    double t = 1.0 / n, t2 = t * t, t3 = t2 * t;
+    double px[4] = { c[0], c[2], c[4], c[6] };
+    double py[4] = { c[1], c[3], c[5], c[7] };
+    double x = px[0], y = py[0];
+    double cx3 = -px[0] + 3 * px[1] - 3 * px[2] + px[3], cy3 = -py[0] + 3 * py[1] - 3 * py[2] + py[3];
+    double cx2 = 3 * px[0] - 6 * px[1] + 3 * px[2], cy2 = 3 * py[0] - 6 * py[1] + 3 * py[2];
+    double cx1 = 3 * (px[1] - px[0]), cy1 = 3 * (py[1] - py[0]);
+    double dx = cx3 * t3 + cx2 * t2 + cx1 * t, dy = cy3 * t3 + cy2 * t2 + cy1 * t;
+    double ddx = 6 * cx3 * t3 + 2 * cx2 * t2, ddy = 6 * cy3 * t3 + 2 * cy2 * t2;
+    double dddx = 6 * cx3 * t3, dddy = 6 * cy3 * t3;
+
+    out.clear();
+    out.reserve(n + 1);
+    out.push_back(QPointF(x, y));
+    for (int i = 1; i < n; i++)
+    {
+        x += dx;
+        y += dy;
+        dx += ddx;
+        dy += ddy;
+        ddx += dddx;
+        ddy += dddy;
+        out.push_back(QPointF(x, y));
+    }
+    out.push_back(QPointF(c[6], c[7]));
+}
+
+void QtCurveCache::fromCurve(const float *p, float tightness, float *controls)
+{
+    // The segment between the middle two points. Their tangents are
+    // (1 - s) / 2 times the chord of their neighbours, as in Processing's
+    // curve basis, and a Bezier handle is a third of the tangent.
+    float k = (1 - tightness) / 6;
+    controls[0] = p[2];
+    controls[1] = p[3];
+    controls[2] = p[2] + k * (p[4] - p[0]);
+    controls[3] = p[3] + k * (p[5] - p[1]);
+    controls[4] = p[4] - k * (p[6] - p[2]);
+    controls[5] = p[5] - k * (p[7] - p[3]);
+    controls[6] = p[4];
+    controls[7] = p[5];
+}
+
+PROCESSING_END_NAMESPACE
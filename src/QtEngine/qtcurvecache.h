@@ -0,0 +1,44 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef P_QTCURVECACHE_H
+#define P_QTCURVECACHE_H
+
+#include <QCache>
+#include <QPointF>
+#include <vector>
+#include "pglobal.h"
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * Cubic Bezier curves flattened into polylines, the most recently drawn
+ * ones are kept. A curve is split finely enough for the scale it is drawn
+ * at, rounded up to a power of two so that nearby scales share a polyline.
+ */
+class QtCurveCache
+{
+public:
+    QtCurveCache();
+
+    // The control points are x1, y1 to x4, y4
+    const std::vector<QPointF> & find(const float *controls, float scale);
+    void clear() { cache.clear(); }
+
+    static void flatten(const float *controls, float tolerance, std::vector<QPointF> &out);
+    static void fromCurve(const float *points, float tightness, float *controls);
+
+private:
+    struct Entry
+    {
+        float controls[8];
+        int level;
+        std::vector<QPointF> points;
+    };
+
+    QCache<unsigned long long, Entry> cache;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // P_QTCURVECACHE_H
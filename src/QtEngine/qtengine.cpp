@@ -8,8 +8,20 @@
 
 PROCESSING_BEGIN_NAMESPACE
 
+static QApplication *createApplication(int &argc, char *argv[])
+{
+    // Report real device pixel ratios so pixelDensity() can match them
+#if QT_VERSION >= 0x050600
+    QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+#endif
+    // The P2D buffer renders in its own context, the widget presenting it
+    // samples the same texture
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+    return new QApplication(argc, argv);
+}
+
 QtEngine::QtEngine(int argc, char *argv[])
-    : GuiEngine(), app(new QApplication(argc, argv))
+    : GuiEngine(), app(createApplication(argc, argv))
 {
     window = new QtWindow;
 }
@@ -2,12 +2,24 @@
 HEADERS += $$PWD/qtengine.h
 HEADERS += $$PWD/qtwindow.h
 HEADERS += $$PWD/qtcanvas.h
+HEADERS += $$PWD/qtbufferpool.h
 HEADERS += $$PWD/qtglcanvas.h
-HEADERS += $$PWD/qtgl3dcanvas.h
+HEADERS += $$PWD/qtglbatch.h
+HEADERS += $$PWD/qt3dcanvas.h
+HEADERS += $$PWD/qtrasterizer.h
+HEADERS += $$PWD/qtshapecache.h
+HEADERS += $$PWD/qtcurvecache.h
+HEADERS += $$PWD/qttextcache.h
 HEADERS += $$PWD/qtdraw_element.h
 SOURCES += $$PWD/qtengine.cpp
 SOURCES += $$PWD/qtwindow.cpp
 SOURCES += $$PWD/qtcanvas.cpp
+SOURCES += $$PWD/qtbufferpool.cpp
 SOURCES += $$PWD/qtglcanvas.cpp
-SOURCES += $$PWD/qtgl3dcanvas.cpp
+SOURCES += $$PWD/qtglbatch.cpp
+SOURCES += $$PWD/qt3dcanvas.cpp
+SOURCES += $$PWD/qtrasterizer.cpp
+SOURCES += $$PWD/qtshapecache.cpp
+SOURCES += $$PWD/qtcurvecache.cpp
+SOURCES += $$PWD/qttextcache.cpp
 QT += widgets opengl
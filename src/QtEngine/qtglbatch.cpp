@@ -0,0 +1,592 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "qtglbatch.h"
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#if QT_VERSION >= 0x050600
+#include <QOpenGLExtraFunctions>
+#endif
+#include <QVector2D>
+#include <QtMath>
+#include <algorithm>
+#include <cstddef>
+
+PROCESSING_BEGIN_NAMESPACE
+
+// Segments of the instanced unit circle
+#define P_GLBATCH_CIRCLE_SEGMENTS 64
+// Largest distance of a tessellated arc from the real curve, in pixels
+#define P_GLBATCH_TOLERANCE 0.25
+
+static const char *const triangleVertexShader =
+    "attribute vec3 position;\n"
+    "attribute vec4 color;\n"
+    "uniform vec2 scale;\n"
+    "uniform float depthStep;\n"
+    "varying vec4 v_color;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = vec4(position.x * scale.x - 1.0, position.y * scale.y + 1.0,\n"
+    "                       1.0 - position.z * depthStep, 1.0);\n"
+    "    v_color = color;\n"
+    "}\n";
+
+static const char *const instanceVertexShader =
+    "attribute vec2 unit;\n"
+    "attribute vec3 row0;\n"
+    "attribute vec3 row1;\n"
+    "attribute float depth;\n"
+    "attribute vec4 color;\n"
+    "uniform vec2 scale;\n"
+    "uniform float depthStep;\n"
+    "varying vec4 v_color;\n"
+    "void main()\n"
+    "{\n"
+    "    vec3 p = vec3(unit, 1.0);\n"
+    "    gl_Position = vec4(dot(row0, p) * scale.x - 1.0, dot(row1, p) * scale.y + 1.0,\n"
+    "                       1.0 - depth * depthStep, 1.0);\n"
+    "    v_color = color;\n"
+    "}\n";
+
+// Colors arrive straight, the framebuffer holds premultiplied alpha
+static const char *const fragmentShader =
+    "#ifdef GL_ES\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "varying vec4 v_color;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = vec4(v_color.rgb * v_color.a, v_color.a);\n"
+    "}\n";
+
+static inline void addPoint(std::vector<float> &out, const QPointF &p)
+{
+    out.push_back(p.x());
+    out.push_back(p.y());
+}
+
+static int segmentsFor(float radius, const PMatrix2D &transform)
+{
+    float r = radius * qSqrt(qAbs(transform.determinant()));
+    if (r <= P_GLBATCH_TOLERANCE)
+        return 8;
+    int n = qCeil(M_PI / qAcos(1.0 - P_GLBATCH_TOLERANCE / r));
+    return qBound(8, n, 256);
+}
+
+QtGLBatch::QtGLBatch()
+    : unitBuffer(QOpenGLBuffer::VertexBuffer),
+      vertexBuffer(QOpenGLBuffer::VertexBuffer),
+      instanceBuffer(QOpenGLBuffer::VertexBuffer),
+      initialized(false),
+      instancing(false),
+      clearPending(false),
+      scissored(false),
+      depth(0),
+      drawCallCount(0),
+      primitiveCount(0)
+{
+}
+
+QtGLBatch::~QtGLBatch()
+{
+}
+
+void QtGLBatch::initialize()
+{
+    if (initialized)
+        return;
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context)
+        throw "QtGLBatch: no current OpenGL context";
+
+    if (!triangleProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, triangleVertexShader)
+            || !triangleProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader)
+            || !triangleProgram.link()
+            || !instanceProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, instanceVertexShader)
+            || !instanceProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader)
+            || !instanceProgram.link())
+        throw "QtGLBatch: cannot build the shaders";
+
+    // Vertex attribute divisors are core in GL 3.3 and ES 3.0
+#if QT_VERSION >= 0x050600
+    QSurfaceFormat format = context->format();
+    instancing = (context->isOpenGLES()
+            ? format.majorVersion() >= 3
+            : format.version() >= qMakePair(3, 3));
+#endif
+
+    // The unit circle as a fan of triangles, then the unit square
+    std::vector<GLfloat> unit;
+    for (int i = 0; i < P_GLBATCH_CIRCLE_SEGMENTS; i++)
+    {
+        float a0 = 2 * M_PI * i / P_GLBATCH_CIRCLE_SEGMENTS;
+        float a1 = 2 * M_PI * (i + 1) / P_GLBATCH_CIRCLE_SEGMENTS;
+        GLfloat triangle[6] = {
+            0.5f, 0.5f,
+            GLfloat(0.5 + 0.5 * qCos(a0)), GLfloat(0.5 + 0.5 * qSin(a0)),
+            GLfloat(0.5 + 0.5 * qCos(a1)), GLfloat(0.5 + 0.5 * qSin(a1))
+        };
+        unit.insert(unit.end(), triangle, triangle + 6);
+    }
+    GLfloat square[12] = { 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1 };
+    unit.insert(unit.end(), square, square + 12);
+
+    unitBuffer.create();
+    unitBuffer.bind();
+    unitBuffer.allocate(unit.data(), unit.size() * sizeof(GLfloat));
+    unitBuffer.release();
+
+    vertexBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    vertexBuffer.create();
+    instanceBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    instanceBuffer.create();
+    initialized = true;
+}
+
+void QtGLBatch::destroy()
+{
+    if (!initialized)
+        return;
+    triangleProgram.removeAllShaders();
+    instanceProgram.removeAllShaders();
+    unitBuffer.destroy();
+    vertexBuffer.destroy();
+    instanceBuffer.destroy();
+    initialized = false;
+}
+
+void QtGLBatch::clear(const QColor &color)
+{
+    // Everything queued so far would be covered anyway
+    opaque.clear();
+    opaqueInstances[0].clear();
+    opaqueInstances[1].clear();
+    translucent.clear();
+    translucentInstances.clear();
+    runs.clear();
+    depth = 0;
+    clearColor = color;
+    clearPending = true;
+}
+
+void QtGLBatch::setScissor(bool enabled, const QRect &rect)
+{
+    // An empty rect lets nothing through. Queued geometry is flushed by
+    // the caller first, the scissor holds for the whole batch.
+    scissored = enabled;
+    scissor = rect;
+}
+
+void QtGLBatch::nextDepth()
+{
+    depth++;
+}
+
+std::vector<QtGLBatch::Vertex> & QtGLBatch::triangles(const QColor &color)
+{
+    return (color.alpha() == 255 ? opaque : translucent);
+}
+
+void QtGLBatch::addTriangles(const std::vector<float> &xy, const QColor &color, const PMatrix2D &transform)
+{
+    // The whole primitive goes through the matrix in one pass
+    std::vector<Vertex> &out = triangles(color);
+    size_t count = xy.size() / 2;
+    size_t first = out.size();
+    out.resize(first + count);
+    const float a = transform.m00, b = transform.m01, c = transform.m02;
+    const float d = transform.m10, e = transform.m11, f = transform.m12;
+    const GLubyte rgba[4] = {
+        (GLubyte) color.red(), (GLubyte) color.green(), (GLubyte) color.blue(), (GLubyte) color.alpha()
+    };
+    for (size_t i = 0; i < count; i++)
+    {
+        Vertex &v = out[first + i];
+        float x = xy[2 * i];
+        float y = xy[2 * i + 1];
+        v.x = a * x + b * y + c;
+        v.y = d * x + e * y + f;
+        v.z = depth;
+        std::copy(rgba, rgba + 4, v.color);
+    }
+    if (&out == &translucent)
+        extend(TRIANGLES, count);
+}
+
+const float * QtGLBatch::toPath(const QPointF *points, int count)
+{
+    path.resize(2 * count);
+    for (int i = 0; i < count; i++)
+    {
+        path[2 * i] = points[i].x();
+        path[2 * i + 1] = points[i].y();
+    }
+    return path.data();
+}
+
+Tessellator::Stroke QtGLBatch::toStroke(const QPen &pen)
+{
+    Tessellator::Stroke stroke;
+    stroke.weight = (pen.widthF() > 0 ? pen.widthF() : 1.0);
+    stroke.miterLimit = pen.miterLimit();
+    switch (pen.capStyle())
+    {
+    case Qt::FlatCap:
+        stroke.cap = Tessellator::FLAT_CAP;
+        break;
+    case Qt::SquareCap:
+        stroke.cap = Tessellator::SQUARE_CAP;
+        break;
+    default:
+        stroke.cap = Tessellator::ROUND_CAP;
+        break;
+    }
+    switch (pen.joinStyle())
+    {
+    case Qt::MiterJoin:
+    case Qt::SvgMiterJoin:
+        stroke.join = Tessellator::MITER_JOIN;
+        break;
+    case Qt::RoundJoin:
+        stroke.join = Tessellator::ROUND_JOIN;
+        break;
+    default:
+        stroke.join = Tessellator::BEVEL_JOIN;
+        break;
+    }
+    return stroke;
+}
+
+void QtGLBatch::addInstance(Kind kind, const QRectF &rect, const QColor &color, const PMatrix2D &transform)
+{
+    PMatrix2D m = transform;
+    m.translate(rect.x(), rect.y());
+    m.scale(rect.width(), rect.height());
+    Instance instance;
+    instance.row0[0] = m.m00;
+    instance.row0[1] = m.m01;
+    instance.row0[2] = m.m02;
+    instance.row1[0] = m.m10;
+    instance.row1[1] = m.m11;
+    instance.row1[2] = m.m12;
+    instance.z = depth;
+    instance.color[0] = color.red();
+    instance.color[1] = color.green();
+    instance.color[2] = color.blue();
+    instance.color[3] = color.alpha();
+    if (color.alpha() == 255)
+        opaqueInstances[kind == ELLIPSES ? 0 : 1].push_back(instance);
+    else
+    {
+        translucentInstances.push_back(instance);
+        extend(kind, 1);
+    }
+}
+
+void QtGLBatch::extend(Kind kind, int count)
+{
+    if (!runs.empty() && runs.back().kind == kind)
+    {
+        runs.back().count += count;
+        return;
+    }
+    Run run;
+    run.kind = kind;
+    run.first = (kind == TRIANGLES ? translucent.size() : translucentInstances.size()) - count;
+    run.count = count;
+    runs.push_back(run);
+}
+
+void QtGLBatch::fillPolygon(const QPointF *points, int count, const QColor &color, const PMatrix2D &transform)
+{
+    if (count < 3)
+        return;
+    nextDepth();
+    scratch.clear();
+    tessellator.fill(toPath(points, count), count, scratch);
+    addTriangles(scratch, color, transform);
+}
+
+void QtGLBatch::strokePolyline(const QPointF *points, int count, bool closed, const QPen &pen, const PMatrix2D &transform)
+{
+    if (count < 1)
+        return;
+
+    // Overlaps within one stroke share its depth and are blended once
+    nextDepth();
+    scratch.clear();
+    tessellator.stroke(toPath(points, count), count, closed, toStroke(pen),
+            qSqrt(qAbs(transform.determinant())), scratch);
+    addTriangles(scratch, pen.color(), transform);
+}
+
+void QtGLBatch::fillEllipse(const QRectF &bbox, const QColor &color, const PMatrix2D &transform)
+{
+    nextDepth();
+    float rx = 0.5 * bbox.width();
+    float ry = 0.5 * bbox.height();
+    int n = segmentsFor(qMax(qAbs(rx), qAbs(ry)), transform);
+
+    // The shared unit circle is only fine enough up to its own segments,
+    // past that its flat sides would fall inside the stroke ring
+    if (instancing && n <= P_GLBATCH_CIRCLE_SEGMENTS)
+    {
+        addInstance(ELLIPSES, bbox, color, transform);
+        return;
+    }
+    scratch.clear();
+    QPointF c = bbox.center();
+    QPointF previous = c + QPointF(rx, 0);
+    for (int i = 1; i <= n; i++)
+    {
+        float a = 2 * M_PI * i / n;
+        QPointF next = c + QPointF(rx * qCos(a), ry * qSin(a));
+        addPoint(scratch, c);
+        addPoint(scratch, previous);
+        addPoint(scratch, next);
+        previous = next;
+    }
+    addTriangles(scratch, color, transform);
+}
+
+void QtGLBatch::strokeEllipse(const QRectF &bbox, const QPen &pen, const PMatrix2D &transform)
+{
+    QColor color = pen.color();
+    float hw = 0.5 * (pen.widthF() > 0 ? pen.widthF() : 1.0);
+    nextDepth();
+    scratch.clear();
+
+    QPointF c = bbox.center();
+    float rx = 0.5 * qAbs(bbox.width());
+    float ry = 0.5 * qAbs(bbox.height());
+    int n = segmentsFor(qMax(rx, ry) + hw, transform);
+    QPointF outer0 = c + QPointF(rx + hw, 0);
+    QPointF inner0 = c + QPointF(qMax(rx - hw, 0.0f), 0);
+    for (int i = 1; i <= n; i++)
+    {
+        float a = 2 * M_PI * i / n;
+        float cs = qCos(a), sn = qSin(a);
+        QPointF outer1 = c + QPointF((rx + hw) * cs, (ry + hw) * sn);
+        QPointF inner1 = c + QPointF(qMax(rx - hw, 0.0f) * cs, qMax(ry - hw, 0.0f) * sn);
+        addPoint(scratch, outer0);
+        addPoint(scratch, inner0);
+        addPoint(scratch, outer1);
+        addPoint(scratch, outer1);
+        addPoint(scratch, inner0);
+        addPoint(scratch, inner1);
+        outer0 = outer1;
+        inner0 = inner1;
+    }
+    addTriangles(scratch, color, transform);
+}
+
+void QtGLBatch::fillRect(const QRectF &rect, const QColor &color, const PMatrix2D &transform)
+{
+    nextDepth();
+    if (instancing)
+    {
+        addInstance(RECTS, rect, color, transform);
+        return;
+    }
+    scratch.clear();
+    addPoint(scratch, rect.topLeft());
+    addPoint(scratch, rect.topRight());
+    addPoint(scratch, rect.bottomRight());
+    addPoint(scratch, rect.topLeft());
+    addPoint(scratch, rect.bottomRight());
+    addPoint(scratch, rect.bottomLeft());
+    addTriangles(scratch, color, transform);
+}
+
+void QtGLBatch::point(const QPointF &p, const QPen &pen, const PMatrix2D &transform)
+{
+    // A point is the cap of a zero length line
+    float w = (pen.widthF() > 0 ? pen.widthF() : 1.0);
+    QRectF bbox(p.x() - 0.5 * w, p.y() - 0.5 * w, w, w);
+    if (pen.capStyle() == Qt::RoundCap)
+        fillEllipse(bbox, pen.color(), transform);
+    else
+        fillRect(bbox, pen.color(), transform);
+}
+
+void QtGLBatch::addMesh(const std::vector<float> &triangles, const QColor &color, const PMatrix2D &transform)
+{
+    // Overlaps within one mesh share its depth, as within one stroke
+    if (triangles.empty())
+        return;
+    nextDepth();
+    addTriangles(triangles, color, transform);
+}
+
+void QtGLBatch::resetCounters()
+{
+    drawCallCount = 0;
+    primitiveCount = 0;
+}
+
+bool QtGLBatch::isEmpty() const
+{
+    return depth == 0 && !clearPending;
+}
+
+void QtGLBatch::flush(const QSize &target)
+{
+    if (isEmpty())
+        return;
+    primitiveCount += depth;
+    initialize();
+
+    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+    f->glViewport(0, 0, target.width(), target.height());
+    if (!scissored)
+        f->glDisable(GL_SCISSOR_TEST);
+    else
+    {
+        // The clear is scissored as well. GL rows start at the bottom.
+        f->glEnable(GL_SCISSOR_TEST);
+        f->glScissor(scissor.x(), target.height() - scissor.y() - scissor.height(),
+                qMax(scissor.width(), 0), qMax(scissor.height(), 0));
+    }
+    f->glDisable(GL_STENCIL_TEST);
+    f->glDisable(GL_CULL_FACE);
+    f->glEnable(GL_DEPTH_TEST);
+    f->glDepthFunc(GL_LESS);
+    f->glDepthMask(GL_TRUE);
+    f->glClearDepthf(1.0f);
+    GLbitfield mask = GL_DEPTH_BUFFER_BIT;
+    if (clearPending)
+    {
+        qreal a = clearColor.alphaF();
+        f->glClearColor(clearColor.redF() * a, clearColor.greenF() * a, clearColor.blueF() * a, a);
+        mask |= GL_COLOR_BUFFER_BIT;
+    }
+    f->glClear(mask);
+
+    // One upload per stream, orphaning last frame's storage
+    int opaqueBytes = opaque.size() * sizeof(Vertex);
+    int translucentBytes = translucent.size() * sizeof(Vertex);
+    if (opaqueBytes + translucentBytes > 0)
+    {
+        vertexBuffer.bind();
+        vertexBuffer.allocate(opaqueBytes + translucentBytes);
+        vertexBuffer.write(0, opaque.data(), opaqueBytes);
+        vertexBuffer.write(opaqueBytes, translucent.data(), translucentBytes);
+    }
+    int ellipses = opaqueInstances[0].size();
+    int rects = opaqueInstances[1].size();
+    int instanceBytes = (ellipses + rects + translucentInstances.size()) * sizeof(Instance);
+    if (instanceBytes > 0)
+    {
+        instanceBuffer.bind();
+        instanceBuffer.allocate(instanceBytes);
+        instanceBuffer.write(0, opaqueInstances[0].data(), ellipses * sizeof(Instance));
+        instanceBuffer.write(ellipses * sizeof(Instance), opaqueInstances[1].data(), rects * sizeof(Instance));
+        instanceBuffer.write((ellipses + rects) * sizeof(Instance), translucentInstances.data(),
+                translucentInstances.size() * sizeof(Instance));
+    }
+
+    GLfloat depthStep = 2.0f / (depth + 1);
+    QVector2D scale(2.0f / target.width(), -2.0f / target.height());
+    triangleProgram.bind();
+    triangleProgram.setUniformValue("scale", scale);
+    triangleProgram.setUniformValue("depthStep", depthStep);
+    instanceProgram.bind();
+    instanceProgram.setUniformValue("scale", scale);
+    instanceProgram.setUniformValue("depthStep", depthStep);
+
+    f->glDisable(GL_BLEND);
+    drawTriangles(0, opaque.size());
+    drawInstances(ELLIPSES, 0, ellipses);
+    drawInstances(RECTS, ellipses, rects);
+
+    f->glEnable(GL_BLEND);
+    f->glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        const Run &run = runs[i];
+        if (run.kind == TRIANGLES)
+            drawTriangles(opaque.size() + run.first, run.count);
+        else
+            drawInstances(run.kind, ellipses + rects + run.first, run.count);
+    }
+
+    f->glDisable(GL_DEPTH_TEST);
+    instanceProgram.release();
+    vertexBuffer.release();
+
+    opaque.clear();
+    opaqueInstances[0].clear();
+    opaqueInstances[1].clear();
+    translucent.clear();
+    translucentInstances.clear();
+    runs.clear();
+    depth = 0;
+    clearPending = false;
+}
+
+void QtGLBatch::drawTriangles(int first, int count)
+{
+    if (count == 0)
+        return;
+    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+    triangleProgram.bind();
+    vertexBuffer.bind();
+    triangleProgram.enableAttributeArray("position");
+    triangleProgram.enableAttributeArray("color");
+    triangleProgram.setAttributeBuffer("position", GL_FLOAT, offsetof(Vertex, x), 3, sizeof(Vertex));
+    triangleProgram.setAttributeBuffer("color", GL_UNSIGNED_BYTE, offsetof(Vertex, color), 4, sizeof(Vertex));
+    f->glDrawArrays(GL_TRIANGLES, first, count);
+    triangleProgram.disableAttributeArray("position");
+    triangleProgram.disableAttributeArray("color");
+    drawCallCount++;
+}
+
+void QtGLBatch::drawInstances(Kind kind, int first, int count)
+{
+#if QT_VERSION >= 0x050600
+    if (count == 0)
+        return;
+    QOpenGLExtraFunctions *f = QOpenGLContext::currentContext()->extraFunctions();
+    int unitFirst = (kind == ELLIPSES ? 0 : 3 * P_GLBATCH_CIRCLE_SEGMENTS);
+    int unitCount = (kind == ELLIPSES ? 3 * P_GLBATCH_CIRCLE_SEGMENTS : 6);
+
+    instanceProgram.bind();
+    unitBuffer.bind();
+    instanceProgram.enableAttributeArray("unit");
+    instanceProgram.setAttributeBuffer("unit", GL_FLOAT, 0, 2, 0);
+
+    instanceBuffer.bind();
+    const char *names[4] = { "row0", "row1", "depth", "color" };
+    int base = first * sizeof(Instance);
+    instanceProgram.setAttributeBuffer(names[0], GL_FLOAT, base + offsetof(Instance, row0), 3, sizeof(Instance));
+    instanceProgram.setAttributeBuffer(names[1], GL_FLOAT, base + offsetof(Instance, row1), 3, sizeof(Instance));
+    instanceProgram.setAttributeBuffer(names[2], GL_FLOAT, base + offsetof(Instance, z), 1, sizeof(Instance));
+    instanceProgram.setAttributeBuffer(names[3], GL_UNSIGNED_BYTE, base + offsetof(Instance, color), 4, sizeof(Instance));
+    for (int i = 0; i < 4; i++)
+    {
+        int location = instanceProgram.attributeLocation(names[i]);
+        instanceProgram.enableAttributeArray(location);
+        f->glVertexAttribDivisor(location, 1);
+    }
+
+    f->glDrawArraysInstanced(GL_TRIANGLES, unitFirst, unitCount, count);
+
+    for (int i = 0; i < 4; i++)
+    {
+        int location = instanceProgram.attributeLocation(names[i]);
+        f->glVertexAttribDivisor(location, 0);
+        instanceProgram.disableAttributeArray(location);
+    }
+    instanceProgram.disableAttributeArray("unit");
+    drawCallCount++;
+#else
+    (void) kind;
+    (void) first;
+    (void) count;
+#endif
+}
+
+PROCESSING_END_NAMESPACE
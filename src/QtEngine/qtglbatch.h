@@ -0,0 +1,118 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef P_QTGLBATCH_H
+#define P_QTGLBATCH_H
+
+#include "pglobal.h"
+#include "pmatrix.h"
+#include "tessellator.h"
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QColor>
+#include <QPen>
+#include <QRect>
+#include <vector>
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * Collects the primitives of a frame as triangles on the CPU and submits
+ * them in a few draw calls. Opaque geometry is drawn first in one call per
+ * kind, translucent geometry follows in submission order. Every primitive
+ * carries its own depth so later ones stay on top either way.
+ *
+ * Filled ellipses and rects are instances of a unit mesh when the context
+ * supports instancing, otherwise they are expanded into triangles.
+ */
+class QtGLBatch
+{
+public:
+    QtGLBatch();
+    ~QtGLBatch();
+
+    void initialize();
+    void destroy();
+
+    void clear(const QColor &color);
+    void setScissor(bool enabled, const QRect &rect);
+    void fillPolygon(const QPointF *points, int count, const QColor &color, const PMatrix2D &transform);
+    void strokePolyline(const QPointF *points, int count, bool closed, const QPen &pen, const PMatrix2D &transform);
+    void fillEllipse(const QRectF &bbox, const QColor &color, const PMatrix2D &transform);
+    void strokeEllipse(const QRectF &bbox, const QPen &pen, const PMatrix2D &transform);
+    void fillRect(const QRectF &rect, const QColor &color, const PMatrix2D &transform);
+    void point(const QPointF &point, const QPen &pen, const PMatrix2D &transform);
+    void addMesh(const std::vector<float> &triangles, const QColor &color, const PMatrix2D &transform);
+
+    static Tessellator::Stroke toStroke(const QPen &pen);
+
+    bool isEmpty() const;
+    void flush(const QSize &target);
+
+    // Counted over every flush since the last reset
+    int drawCalls() const { return drawCallCount; }
+    int primitives() const { return primitiveCount; }
+    void resetCounters();
+
+private:
+    struct Vertex
+    {
+        GLfloat x, y, z;
+        GLubyte color[4];
+    };
+
+    struct Instance
+    {
+        GLfloat row0[3];
+        GLfloat row1[3];
+        GLfloat z;
+        GLubyte color[4];
+    };
+
+    enum Kind { TRIANGLES, ELLIPSES, RECTS };
+
+    struct Run
+    {
+        Kind kind;
+        int first;
+        int count;
+    };
+
+    void nextDepth();
+    std::vector<Vertex> & triangles(const QColor &color);
+    void addInstance(Kind kind, const QRectF &rect, const QColor &color, const PMatrix2D &transform);
+    void addTriangles(const std::vector<float> &xy, const QColor &color, const PMatrix2D &transform);
+    const float * toPath(const QPointF *points, int count);
+    void extend(Kind kind, int count);
+    void drawTriangles(int first, int count);
+    void drawInstances(Kind kind, int first, int count);
+
+    QOpenGLShaderProgram triangleProgram;
+    QOpenGLShaderProgram instanceProgram;
+    QOpenGLBuffer unitBuffer;
+    QOpenGLBuffer vertexBuffer;
+    QOpenGLBuffer instanceBuffer;
+    bool initialized;
+    bool instancing;
+
+    std::vector<Vertex> opaque;
+    std::vector<Instance> opaqueInstances[2];
+    std::vector<Vertex> translucent;
+    std::vector<Instance> translucentInstances;
+    std::vector<Run> runs;
+    Tessellator tessellator;
+    std::vector<float> path;
+    std::vector<float> scratch;
+
+    QColor clearColor;
+    bool clearPending;
+    bool scissored;
+    QRect scissor;
+    int depth;
+    int drawCallCount;
+    int primitiveCount;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // P_QTGLBATCH_H
@@ -3,15 +3,29 @@
  */
 #include "qtglcanvas.h"
 #include "qthelper.h"
+#include "qtglbatch.h"
 #include <QOpenGLPaintDevice>
 #include <QOpenGLFramebufferObjectFormat>
 #include <QOpenGLFramebufferObject>
+#include <QOpenGLBuffer>
+#include <QElapsedTimer>
 #include <QPaintEvent>
 #include <QWindow>
 #include <iostream>
+#include <cstring>
+#include <cmath>
 
 PROCESSING_BEGIN_NAMESPACE
 
+/**
+ * The sketch draws into a multisampled framebuffer, which is resolved into
+ * a single-sample one once per frame. Without samples the sketch draws
+ * into the resolved framebuffer directly. The widget samples the resolved
+ * texture through a shared context, so nothing leaves the GPU unless the
+ * sketch reads pixels back.
+ *
+ * The context and the framebuffers are created on the first draw.
+ */
 class QtGLBuffer : public IQtBuffer
 {
 public:
@@ -21,59 +35,204 @@ public:
     QPainter & getPainter() OVERRIDE;
     QImage & getImage() OVERRIDE;
     QRect rect() const OVERRIDE;
+    void resize(int width, int height) OVERRIDE;
+    void setSamples(int samples) OVERRIDE;
+    bool isCreated() const OVERRIDE { return created; }
+    size_t byteCount() const OVERRIDE;
+    QImage & readPixels() OVERRIDE;
+    bool requestPixels() OVERRIDE;
+
+    void resolve();
+    void flushBatch();
+    float setupTime() const { return setupMs; }
+    QtGLBatch & getBatch() { return batch; }
+    GLuint texture() const { return resolved->texture(); }
+    QSize textureSize() const { return resolved->size(); }
 
 private:
+    void create();
+    void makeCurrent();
+    void reallocate(const QSize &capacity, int samples);
+    void suspend();
+    void resume();
+
     QSurfaceFormat format;
-    QWindow window;
-    QOpenGLContext context;
-    QOpenGLFramebufferObjectFormat fbo_format;
+    QWindow *window;
+    QOpenGLContext *context;
     QOpenGLFramebufferObject *fbo;
+    QOpenGLFramebufferObject *resolved;
     QOpenGLPaintDevice *device;
+    QOpenGLBuffer pbo;
+    QtGLBatch batch;
     QRect drawRect;
     QPainter painter;
     QImage image;
+    QPen savedPen;
+    QBrush savedBrush;
+    QTransform savedTransform;
+    int samples;
+    int pboBytes;
+    float setupMs;
+    bool created;
     bool painting;
+    bool suspended;
+    bool readbackPending;
 };
 
 QtGLBuffer::QtGLBuffer(int width, int height)
-    : painting(false)
+    : window(0), context(0), fbo(0), resolved(0), device(0),
+      pbo(QOpenGLBuffer::PixelPackBuffer),
+      drawRect(0, 0, width, height),
+      samples(2),
+      pboBytes(0),
+      setupMs(0),
+      created(false),
+      painting(false),
+      suspended(false),
+      readbackPending(false)
+{
+}
+
+QtGLBuffer::~QtGLBuffer()
 {
+    if (!created)
+        return;
+    makeCurrent();
+    if (painting)
+    {
+        painter.end();
+        fbo->release();
+    }
+    batch.destroy();
+    pbo.destroy();
+    delete device;
+    if (resolved != fbo)
+        delete resolved;
+    delete fbo;
+    context->doneCurrent();
+    delete context;
+    delete window;
+}
+
+void QtGLBuffer::create()
+{
+    if (created)
+        return;
+    QElapsedTimer elapsed;
+    elapsed.start();
+
     // format.setMajorVersion(3);
     // format.setMinorVersion(2);
 
-    window.setSurfaceType(QWindow::OpenGLSurface);
-    window.setFormat(format);
-    window.create();
+    window = new QWindow;
+    window->setSurfaceType(QWindow::OpenGLSurface);
+    window->setFormat(format);
+    window->create();
 
-    context.setFormat(format);
-    if (!context.create())
+    // Sharing makes the resolved texture visible to the presenting widget
+    context = new QOpenGLContext;
+    context->setShareContext(QOpenGLContext::globalShareContext());
+    context->setFormat(format);
+    if (!context->create())
         qFatal("Error: cannot create the requested OpenGL context!");
-    context.makeCurrent(&window);
+    context->makeCurrent(window);
 
-    drawRect = QRect(0, 0, width, height);
-    const QSize drawRectSize = drawRect.size();
+    reallocate(drawRect.size(), samples);
+    pbo.setUsagePattern(QOpenGLBuffer::StreamRead);
+    pbo.create();
+    created = true;
+    setupMs = elapsed.nsecsElapsed() / 1e6f;
+}
+
+void QtGLBuffer::makeCurrent()
+{
+    // The presenting widget makes its own context current in between
+    if (QOpenGLContext::currentContext() != context)
+        context->makeCurrent(window);
+}
 
-    fbo_format.setSamples(16);
+void QtGLBuffer::reallocate(const QSize &capacity, int samples_)
+{
+    QOpenGLFramebufferObjectFormat fbo_format;
+    fbo_format.setSamples(samples_);
     fbo_format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
 
-    fbo = new QOpenGLFramebufferObject(drawRectSize, fbo_format);
+    QOpenGLFramebufferObject *oldFbo = fbo;
+    QOpenGLFramebufferObject *oldResolved = resolved;
+    fbo = new QOpenGLFramebufferObject(capacity, fbo_format);
+    resolved = (fbo->format().samples() > 0 ? new QOpenGLFramebufferObject(capacity) : fbo);
 
-    device = new QOpenGLPaintDevice(drawRectSize);
+    if (oldFbo)
+    {
+        // GL rows start at the bottom, so the kept area is the top strip
+        int keepWidth = qMin(drawRect.width(), capacity.width());
+        int keepHeight = qMin(drawRect.height(), capacity.height());
+        QRect source(0, oldFbo->height() - keepHeight, keepWidth, keepHeight);
+        QRect target(0, capacity.height() - keepHeight, keepWidth, keepHeight);
+        if (oldFbo->format().samples() == fbo->format().samples())
+            QOpenGLFramebufferObject::blitFramebuffer(fbo, target, oldFbo, source);
+        else
+        {
+            // Resolving is a blit, filling samples back in takes a draw
+            QOpenGLFramebufferObject::blitFramebuffer(resolved, target, oldFbo, source);
+            if (resolved != fbo)
+            {
+                QOpenGLFunctions *f = context->functions();
+                QOpenGLTextureBlitter blitter;
+                blitter.create();
+                fbo->bind();
+                f->glViewport(0, 0, capacity.width(), capacity.height());
+                f->glDisable(GL_BLEND);
+                f->glDisable(GL_DEPTH_TEST);
+                f->glDisable(GL_SCISSOR_TEST);
+                blitter.bind();
+                blitter.blit(resolved->texture(), QMatrix4x4(), QOpenGLTextureBlitter::OriginBottomLeft);
+                blitter.release();
+                blitter.destroy();
+                fbo->release();
+            }
+        }
+        if (oldResolved != oldFbo)
+            delete oldResolved;
+        delete oldFbo;
+    }
+    delete device;
+    device = new QOpenGLPaintDevice(capacity);
 }
 
-QtGLBuffer::~QtGLBuffer()
+void QtGLBuffer::suspend()
 {
+    // The painter moves over to new framebuffers with its state
+    flushBatch();
+    suspended = painting;
     if (painting)
     {
+        savedPen = painter.pen();
+        savedBrush = painter.brush();
+        savedTransform = painter.worldTransform();
         painter.end();
         fbo->release();
+        painting = false;
+    }
+    readbackPending = false;
+}
+
+void QtGLBuffer::resume()
+{
+    if (suspended)
+    {
+        getPainter();
+        painter.setPen(savedPen);
+        painter.setBrush(savedBrush);
+        painter.setWorldTransform(savedTransform);
+        suspended = false;
     }
-    delete device;
-    delete fbo;
 }
 
 QPainter & QtGLBuffer::getPainter()
 {
+    create();
+    makeCurrent();
     if (!painting)
     {
         fbo->bind();
@@ -85,32 +244,163 @@ QPainter & QtGLBuffer::getPainter()
 
 QImage & QtGLBuffer::getImage()
 {
+    return readPixels();
+}
+
+QRect QtGLBuffer::rect() const
+{
+    return drawRect;
+}
+
+size_t QtGLBuffer::byteCount() const
+{
+    if (!created)
+        return 0;
+
+    // Color plus packed depth and stencil per sample
+    size_t pixels = (size_t) fbo->width() * fbo->height();
+    size_t bytes = pixels * 8 * qMax(fbo->format().samples(), 1);
+    if (resolved != fbo)
+        bytes += pixels * 4;
+    return bytes + pboBytes;
+}
+
+void QtGLBuffer::setSamples(int samples_)
+{
+    if (samples_ == samples)
+        return;
+    samples = samples_;
+    if (!created)
+        return;
+
+    suspend();
+    makeCurrent();
+    reallocate(fbo->size(), samples);
+    resume();
+}
+
+void QtGLBuffer::flushBatch()
+{
+    if (batch.isEmpty())
+        return;
+    QPainter &p = getPainter();
+    p.beginNativePainting();
+    batch.flush(fbo->size());
+    p.endNativePainting();
+}
+
+void QtGLBuffer::resolve()
+{
+    // Batched geometry alone does not touch the painter
+    if (!created && batch.isEmpty())
+        return;
+    flushBatch();
+    makeCurrent();
     if (painting)
+        painter.beginNativePainting();
+    if (resolved != fbo)
+        QOpenGLFramebufferObject::blitFramebuffer(resolved, fbo);
+
+    // Submit now so the widget's context samples a finished frame
+    context->functions()->glFlush();
+    if (painting)
+        painter.endNativePainting();
+}
+
+bool QtGLBuffer::requestPixels()
+{
+    create();
+    flushBatch();
+    makeCurrent();
+    if (painting)
+        painter.beginNativePainting();
+
+    if (resolved != fbo)
+        QOpenGLFramebufferObject::blitFramebuffer(resolved, fbo);
+    int w = drawRect.width();
+    int h = drawRect.height();
+    int bytes = w * h * 4;
+
+    // glReadPixels into a pixel pack buffer returns without waiting for
+    // the GPU. BGRA bytes are ARGB32 words on little endian hosts, so the
+    // copy out of the buffer needs no swizzle.
+    resolved->bind();
+    pbo.bind();
+    if (pboBytes < bytes)
     {
-        painter.end();
-        fbo->release();
-        image = fbo->toImage();
-        painting = false;
+        pbo.allocate(bytes);
+        pboBytes = bytes;
     }
+    QOpenGLFunctions *f = context->functions();
+    f->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    f->glReadPixels(0, resolved->height() - h, w, h, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+    pbo.release();
+    fbo->bind();
+
+    if (painting)
+        painter.endNativePainting();
+    readbackPending = true;
+    return true;
+}
+
+QImage & QtGLBuffer::readPixels()
+{
+    if (!readbackPending)
+        requestPixels();
+    makeCurrent();
+
+    int w = drawRect.width();
+    int h = drawRect.height();
+    if (image.size() != drawRect.size())
+        image = QImage(drawRect.size(), QImage::Format_ARGB32_Premultiplied);
+
+    // GL rows run bottom-up
+    pbo.bind();
+    const uchar *data = (const uchar *) pbo.map(QOpenGLBuffer::ReadOnly);
+    if (data)
+    {
+        for (int y = 0; y < h; y++)
+            memcpy(image.scanLine(h - 1 - y), data + y * w * 4, w * 4);
+        pbo.unmap();
+    }
+    pbo.release();
+    readbackPending = false;
     return image;
 }
 
-QRect QtGLBuffer::rect() const
+void QtGLBuffer::resize(int width, int height)
 {
-    return drawRect;
+    QSize size(width, height);
+    if (size == drawRect.size())
+        return;
+
+    // The framebuffer only grows, geometrically. The sketch is drawn from
+    // its top-left corner, so a smaller size needs no reallocation.
+    if (created && (width > fbo->width() || height > fbo->height()))
+    {
+        suspend();
+        makeCurrent();
+        reallocate(size.expandedTo(fbo->size() * 3 / 2), samples);
+        resume();
+    }
+    drawRect = QRect(QPoint(0, 0), size);
+    readbackPending = false;
 }
 
 /**
  * QtGLWidget class
  */
 QtGLWidget::QtGLWidget(QtCanvas *helper, QWidget *parent)
-    : QWidget(parent), helper(helper)
+    : QOPENGLWIDGET(parent), helper(helper)
 {
     // setAutoFillBackground(false);
 }
 
 QtGLWidget::~QtGLWidget()
 {
+    makeCurrent();
+    blitter.destroy();
+    doneCurrent();
 }
 
 void QtGLWidget::animate()
@@ -118,15 +408,32 @@ void QtGLWidget::animate()
     update();
 }
 
-void QtGLWidget::paintEvent(QPaintEvent *event)
+void QtGLWidget::initializeGL()
 {
-    QPainter painter;
-    QRect dirtyRect = event->rect();
-    painter.begin(this);
-    painter.setRenderHints(QPainter::Antialiasing | QPainter::HighQualityAntialiasing);
-    QImage & image = helper->getBuffer()->getImage();
-    painter.drawImage(dirtyRect, image, dirtyRect);
-    painter.end();
+    initializeOpenGLFunctions();
+    blitter.create();
+}
+
+void QtGLWidget::paintGL()
+{
+    QtGLBuffer *buffer = static_cast<QtGLBuffer *>(helper->getBuffer());
+    if (!buffer || !buffer->isCreated())
+    {
+        // Nothing has been drawn yet
+        glClearColor(0, 0, 0, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
+        return;
+    }
+
+    QRectF frame(QPointF(0, 0), QSizeF(buffer->rect().size()));
+    QMatrix4x4 target = QOpenGLTextureBlitter::targetTransform(frame, rect());
+    QMatrix3x3 source = QOpenGLTextureBlitter::sourceTransform(frame,
+            buffer->textureSize(), QOpenGLTextureBlitter::OriginBottomLeft);
+
+    glDisable(GL_BLEND);
+    blitter.bind();
+    blitter.blit(buffer->texture(), target, source);
+    blitter.release();
 }
 
 /**
@@ -139,21 +446,297 @@ QtGLCanvas::QtGLCanvas(QWidget *parent)
 
 QtGLCanvas::~QtGLCanvas()
 {
+    savePendingFrames();
     delete buffer;
     buffer = 0;
     delete widget;
 }
 
-void QtGLCanvas::setFixedSize(int width, int height)
+void QtGLCanvas::resizeBuffer(int width, int height)
 {
     widget->setFixedSize(width, height);
-    buffer = new QtGLBuffer(width, height);
+    if (buffer)
+        buffer->resize(width, height);
+    else
+    {
+        buffer = new QtGLBuffer(width, height);
+        updateSmoothing();
+    }
+    // A new painter starts without the clip
+    if (style.clipping)
+        clipChanged();
 }
 
 void QtGLCanvas::animate()
 {
+    beginFrame();
     Canvas::animate();
-    widget->animate();
+    static_cast<QtGLBuffer *>(buffer)->resolve();
+    endFrame();
+    stats.setupTime = static_cast<QtGLBuffer *>(buffer)->setupTime();
+    stats.drawCalls = batch().drawCalls();
+    stats.primitives = batch().primitives();
+    batch().resetCounters();
+    if (isPresenting())
+        widget->animate();
+}
+
+QtGLBatch & QtGLCanvas::batch()
+{
+    return static_cast<QtGLBuffer *>(buffer)->getBatch();
+}
+
+void QtGLCanvas::flush()
+{
+    // Anything drawn through the painter has to land on top of the batch
+    static_cast<QtGLBuffer *>(buffer)->flushBatch();
+}
+
+void QtGLCanvas::clipChanged()
+{
+    // The scissor covers axis aligned clips. Anything else is a clip path
+    // on the painter, and primitives are drawn through it meanwhile.
+    flush();
+    QtCanvas::clipChanged();
+    batch().setScissor(style.clipping && !isPathClipped(), style.clip_scissor);
+}
+
+void QtGLCanvas::ellipse(float a, float b, float c, float d)
+{
+    QRectF bbox = getRect(style.ellipse_mode, a, b, c, d);
+    if (isPathClipped())
+    {
+        flush();
+        QtCanvas::ellipse(a, b, c, d);
+        return;
+    }
+    if (cull(bbox))
+        return;
+    if (style.brush.style() != Qt::NoBrush)
+        batch().fillEllipse(bbox, style.brush.color(), matrix);
+    if (style.pen.style() != Qt::NoPen)
+        batch().strokeEllipse(bbox, style.pen, matrix);
+}
+
+void QtGLCanvas::line(float x1, float y1, float x2, float y2)
+{
+    if (isPathClipped())
+    {
+        flush();
+        QtCanvas::line(x1, y1, x2, y2);
+        return;
+    }
+    if (style.pen.style() == Qt::NoPen)
+        return;
+    QPointF points[2] = { QPointF(x1, y1), QPointF(x2, y2) };
+    if (cull(points, 2))
+        return;
+    batch().strokePolyline(points, 2, false, style.pen, matrix);
+}
+
+void QtGLCanvas::point(float x, float y)
+{
+    if (isPathClipped())
+    {
+        flush();
+        QtCanvas::point(x, y);
+        return;
+    }
+    if (style.pen.style() != Qt::NoPen && !cull(QRectF(x, y, 0, 0)))
+        batch().point(QPointF(x, y), style.pen, matrix);
+}
+
+void QtGLCanvas::quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4)
+{
+    QPointF points[4] = { QPointF(x1, y1), QPointF(x2, y2), QPointF(x3, y3), QPointF(x4, y4) };
+    polygon(points, 4);
+}
+
+void QtGLCanvas::rect(float a, float b, float c, float d)
+{
+    if (isPathClipped())
+    {
+        flush();
+        QtCanvas::rect(a, b, c, d);
+        return;
+    }
+    QRectF bbox = getRect(style.rect_mode, a, b, c, d);
+    if (cull(bbox))
+        return;
+    if (style.brush.style() != Qt::NoBrush)
+        batch().fillRect(bbox, style.brush.color(), matrix);
+    if (style.pen.style() != Qt::NoPen)
+    {
+        QPointF points[4] = { bbox.topLeft(), bbox.topRight(), bbox.bottomRight(), bbox.bottomLeft() };
+        batch().strokePolyline(points, 4, true, style.pen, matrix);
+    }
+}
+
+void QtGLCanvas::triangle(float x1, float y1, float x2, float y2, float x3, float y3)
+{
+    QPointF points[3] = { QPointF(x1, y1), QPointF(x2, y2), QPointF(x3, y3) };
+    polygon(points, 3);
+}
+
+void QtGLCanvas::polygon(const QPointF *points, int count)
+{
+    if (cull(points, count))
+        return;
+    if (isPathClipped())
+    {
+        flush();
+        getPainter().drawPolygon(points, count);
+        return;
+    }
+    if (style.brush.style() != Qt::NoBrush)
+        batch().fillPolygon(points, count, style.brush.color(), matrix);
+    if (style.pen.style() != Qt::NoPen)
+        batch().strokePolyline(points, count, true, style.pen, matrix);
+}
+
+static bool sameOutline(const QPen &a, const QPen &b)
+{
+    return a.widthF() == b.widthF() && a.capStyle() == b.capStyle()
+            && a.joinStyle() == b.joinStyle() && a.miterLimit() == b.miterLimit();
+}
+
+// Subpaths flattened finely enough for a scale of 2^level, in the shape's
+// own coordinates. Closed ones drop the repeated first point.
+static QList<QPolygonF> flatten(const QPainterPath &path, int level, QList<bool> &closed)
+{
+    qreal s = std::ldexp(1.0, level);
+    QList<QPolygonF> subpaths = path.toSubpathPolygons(QTransform::fromScale(s, s));
+    closed.clear();
+    for (int i = 0; i < subpaths.size(); i++)
+    {
+        QPolygonF &subpath = subpaths[i];
+        bool loop = (subpath.size() > 2 && subpath.first() == subpath.last());
+        if (loop)
+            subpath.removeLast();
+        for (int k = 0; k < subpath.size(); k++)
+            subpath[k] /= s;
+        closed.append(loop);
+    }
+    return subpaths;
+}
+
+static const float * toPath(const QPolygonF &polygon, std::vector<float> &path)
+{
+    path.resize(2 * polygon.size());
+    for (int k = 0; k < polygon.size(); k++)
+    {
+        path[2 * k] = polygon[k].x();
+        path[2 * k + 1] = polygon[k].y();
+    }
+    return path.data();
+}
+
+void QtGLCanvas::updateMesh(const QtShapeGeometry &g, QtShapeMesh &mesh, bool stroked)
+{
+    // Kept for the largest scale the shape has been drawn at, smaller
+    // draws reuse it. The stroke follows the pen's width, caps and joins.
+    float scale = qSqrt(qAbs(matrix.determinant()));
+    int level = qBound(-4, qCeil(std::log2(qMax(scale, 1e-3f))), 8);
+    QList<bool> closed;
+    if (level > mesh.level)
+    {
+        mesh.level = level;
+        mesh.fill.clear();
+        mesh.pen = QPen(Qt::NoPen);
+        QList<QPolygonF> subpaths = flatten(g.fill, level, closed);
+        for (int i = 0; i < subpaths.size(); i++)
+            tessellator.fill(toPath(subpaths[i], outline), subpaths[i].size(), mesh.fill);
+    }
+    if (stroked && (mesh.pen.style() == Qt::NoPen || !sameOutline(mesh.pen, style.pen)))
+    {
+        mesh.pen = style.pen;
+        mesh.stroke.clear();
+        Tessellator::Stroke stroke = QtGLBatch::toStroke(style.pen);
+        QList<QPolygonF> subpaths = flatten(g.stroke, mesh.level, closed);
+        for (int i = 0; i < subpaths.size(); i++)
+            tessellator.stroke(toPath(subpaths[i], outline), subpaths[i].size(), closed[i], stroke,
+                    std::ldexp(1.0, mesh.level), mesh.stroke);
+    }
+}
+
+void QtGLCanvas::renderShape(QtShapeCache::Entry &entry, const QPointF &offset)
+{
+    if (isPathClipped())
+    {
+        flush();
+        QtCanvas::renderShape(entry, offset);
+        return;
+    }
+    const QtShapeGeometry &g = entry.geometry;
+    if (g.fill.isEmpty() && g.stroke.isEmpty() && g.points.isEmpty())
+        return;
+    if (cull(g.bounds.translated(offset)))
+        return;
+
+    // Only the vertices go through the matrix, whatever the transform
+    bool filled = (style.brush.style() != Qt::NoBrush);
+    bool stroked = (style.pen.style() != Qt::NoPen);
+    updateMesh(g, entry.mesh, stroked);
+    PMatrix2D m = matrix;
+    m.translate(offset.x(), offset.y());
+    if (filled)
+        batch().addMesh(entry.mesh.fill, style.brush.color(), m);
+    if (stroked)
+    {
+        batch().addMesh(entry.mesh.stroke, style.pen.color(), m);
+        for (int i = 0; i < g.points.size(); i++)
+            batch().point(g.points[i], style.pen, m);
+    }
+}
+
+void QtGLCanvas::drawCurve(const std::vector<QPointF> &points)
+{
+    if (isPathClipped())
+    {
+        flush();
+        QtCanvas::drawCurve(points);
+        return;
+    }
+    if (cull(points.data(), points.size()))
+        return;
+    if (style.brush.style() != Qt::NoBrush)
+        batch().fillPolygon(points.data(), points.size(), style.brush.color(), matrix);
+    if (style.pen.style() != Qt::NoPen)
+        batch().strokePolyline(points.data(), points.size(), false, style.pen, matrix);
+}
+
+void QtGLCanvas::backgroundARGB(unsigned int argb)
+{
+    if (isPathClipped())
+    {
+        flush();
+        QtCanvas::backgroundARGB(argb);
+        return;
+    }
+    QColor c = QColor::fromRgba(argb);
+    if (c.alpha() == 255)
+        batch().clear(c);
+    else
+        batch().fillRect(buffer->rect(), c, PMatrix2D());
+}
+
+void QtGLCanvas::text(const std::string &str, float x, float y)
+{
+    // Glyphs come from the atlas through the painter, after what is queued
+    flush();
+    QtCanvas::text(str, x, y);
+}
+
+void QtGLCanvas::updatePixels()
+{
+    flush();
+    QtCanvas::updatePixels();
+}
+
+void QtGLCanvas::paintEvent(QPaintEvent *event)
+{
+    // Covered by the GL widget, reading the framebuffer back is not needed
+    (void) event;
 }
 
 PROCESSING_END_NAMESPACE
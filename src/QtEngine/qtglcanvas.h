@@ -6,10 +6,13 @@
 
 #include "qtcommon.h"
 #include "qtcanvas.h"
+#include "tessellator.h"
+#include <QOpenGLFunctions>
+#include <QOpenGLTextureBlitter>
 
 PROCESSING_BEGIN_NAMESPACE
 
-class QtGLWidget : public QWidget // QOPENGLWIDGET
+class QtGLWidget : public QOPENGLWIDGET, protected QOpenGLFunctions
 {
     Q_OBJECT
 
@@ -21,25 +24,60 @@ public slots:
     void animate();
 
 protected:
-    void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
+    void initializeGL() Q_DECL_OVERRIDE;
+    void paintGL() Q_DECL_OVERRIDE;
 
 private:
     friend class QtGLCanvas;
 
     QtCanvas *helper;
+    QOpenGLTextureBlitter blitter;
 };
 
+class QtGLBatch;
+
+/**
+ * Primitives are batched into vertex buffers, whatever has no batched form
+ * goes through the painter after the queued geometry is flushed.
+ */
 class QtGLCanvas : public QtCanvas
 {
 public:
     explicit QtGLCanvas(QWidget *parent=0);
     ~QtGLCanvas();
 
-    void setFixedSize(int width, int height) OVERRIDE;
+    void ellipse(float a, float b, float c, float d) OVERRIDE;
+    void line(float x1, float y1, float x2, float y2) OVERRIDE;
+    void point(float x, float y) OVERRIDE;
+    void quad(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4) OVERRIDE;
+    void rect(float a, float b, float c, float d) OVERRIDE;
+    using QtCanvas::rect;
+    void triangle(float x1, float y1, float x2, float y2, float x3, float y3) OVERRIDE;
+
+    void backgroundARGB(unsigned int argb) OVERRIDE;
+    void text(const std::string &str, float x, float y) OVERRIDE;
+
+    void updatePixels() OVERRIDE;
     void animate() OVERRIDE;
 
+protected:
+    QtGLBatch & batch();
+    void flush();
+    void polygon(const QPointF *points, int count);
+    void clipChanged() OVERRIDE;
+    void renderShape(QtShapeCache::Entry &entry, const QPointF &offset) OVERRIDE;
+    void drawCurve(const std::vector<QPointF> &points) OVERRIDE;
+    void updateMesh(const QtShapeGeometry &g, QtShapeMesh &mesh, bool stroked);
+
+    void resizeBuffer(int width, int height) OVERRIDE;
+    void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
+
 private:
     QtGLWidget *widget;
+
+    // Shape meshes are built here, the outline is the flattened subpath
+    Tessellator tessellator;
+    std::vector<float> outline;
 };
 
 PROCESSING_END_NAMESPACE
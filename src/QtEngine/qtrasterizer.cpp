@@ -0,0 +1,504 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "qtrasterizer.h"
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QtMath>
+#include <algorithm>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+PROCESSING_BEGIN_NAMESPACE
+
+// Tiles are square, a tile's depth slice fits in the L1 cache
+#define P_RASTER_TILE 64
+// Pulls lines in front of the faces they outline
+#define P_RASTER_LINE_BIAS 5e-5f
+
+class QtRasterizer::Worker : public QRunnable
+{
+public:
+    enum Stage { SETUP, RASTER };
+
+    Worker(QtRasterizer *raster, Stage stage, QAtomicInt *next, int count)
+        : raster(raster), stage(stage), next(next), count(count) {}
+
+    void run() OVERRIDE
+    {
+        int i;
+        while ((i = next->fetchAndAddRelaxed(1)) < count)
+        {
+            if (stage == SETUP)
+            {
+                int n = raster->primitives.size();
+                raster->setup(n * i / count, n * (i + 1) / count, raster->chunks[i]);
+            }
+            else
+                raster->rasterizeTile(i);
+        }
+    }
+
+private:
+    QtRasterizer *raster;
+    Stage stage;
+    QAtomicInt *next;
+    int count;
+};
+
+void QtRasterizer::runParallel(int stage, int count)
+{
+    // The calling thread takes a share of the work as well
+    QAtomicInt next(0);
+    int threads = qMin(pool.maxThreadCount(), count);
+    for (int i = 1; i < threads; i++)
+        pool.start(new Worker(this, (Worker::Stage) stage, &next, count));
+    Worker(this, (Worker::Stage) stage, &next, count).run();
+    pool.waitForDone();
+}
+
+QtRasterizer::QtRasterizer()
+    : targetBits(0), targetStride(0), opaqueTarget(false), tilesX(0), tilesY(0),
+      viewWidth(0), viewHeight(0), lineScale(1), clearPending(false), renderedTriangles(0)
+{
+}
+
+QtRasterizer::~QtRasterizer()
+{
+    pool.waitForDone();
+}
+
+int QtRasterizer::addVertices(const QMatrix4x4 &matrix, const float *points, const float *colors, int count)
+{
+    int first = vertices.size();
+    vertices.resize(first + count);
+    QtVertex3D *out = &vertices[first];
+    const float *m = matrix.constData();
+
+    // Column major, every point is a sum of the scaled columns
+#ifdef __SSE__
+    __m128 c0 = _mm_loadu_ps(m);
+    __m128 c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8);
+    __m128 c3 = _mm_loadu_ps(m + 12);
+    for (int i = 0; i < count; i++)
+    {
+        const float *p = points + 3 * i;
+        __m128 xy = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p[0])), _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+        __m128 zw = _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(p[2])), c3);
+        _mm_storeu_ps(&out[i].x, _mm_add_ps(xy, zw));
+        _mm_storeu_ps(&out[i].r, _mm_loadu_ps(colors + 4 * i));
+    }
+#else
+    for (int i = 0; i < count; i++)
+    {
+        const float *p = points + 3 * i;
+        const float *c = colors + 4 * i;
+        out[i].x = m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12];
+        out[i].y = m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13];
+        out[i].z = m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14];
+        out[i].w = m[3] * p[0] + m[7] * p[1] + m[11] * p[2] + m[15];
+        out[i].r = c[0];
+        out[i].g = c[1];
+        out[i].b = c[2];
+        out[i].a = c[3];
+    }
+#endif
+    return first;
+}
+
+void QtRasterizer::addTriangle(int a, int b, int c)
+{
+    Primitive p;
+    p.a = a;
+    p.b = b;
+    p.c = c;
+    p.weight = 0;
+    primitives.push_back(p);
+}
+
+void QtRasterizer::addLine(int a, int b, const QColor &color, float weight)
+{
+    Primitive p;
+    p.a = a;
+    p.b = b;
+    p.c = -1;
+    p.color[0] = color.redF();
+    p.color[1] = color.greenF();
+    p.color[2] = color.blueF();
+    p.color[3] = color.alphaF();
+    p.weight = (weight > 0 ? weight : 1);
+    primitives.push_back(p);
+}
+
+void QtRasterizer::clear(const QColor &color)
+{
+    // Whatever was queued would be covered anyway
+    vertices.clear();
+    primitives.clear();
+    clearColor = color;
+    clearPending = true;
+}
+
+static float planeDistance(const QtVertex3D &v, int plane)
+{
+    switch (plane)
+    {
+        case 0: return v.w + v.x;
+        case 1: return v.w - v.x;
+        case 2: return v.w + v.y;
+        case 3: return v.w - v.y;
+        case 4: return v.w + v.z;
+        default: return v.w - v.z;
+    }
+}
+
+static QtVertex3D interpolate(const QtVertex3D &a, const QtVertex3D &b, float t)
+{
+    QtVertex3D v;
+    const float *pa = &a.x;
+    const float *pb = &b.x;
+    float *pv = &v.x;
+    for (int i = 0; i < 8; i++)
+        pv[i] = pa[i] + (pb[i] - pa[i]) * t;
+    return v;
+}
+
+void QtRasterizer::setup(int first, int last, std::vector<ScreenTriangle> &out) const
+{
+    out.clear();
+    for (int i = first; i < last; i++)
+    {
+        const Primitive &p = primitives[i];
+        if (p.c < 0)
+        {
+            setupLine(p, out);
+            continue;
+        }
+
+        QtVertex3D polygon[3] = { vertices[p.a], vertices[p.b], vertices[p.c] };
+        bool inside = true;
+        for (int plane = 0; plane < 6 && inside; plane++)
+            for (int k = 0; k < 3; k++)
+                if (planeDistance(polygon[k], plane) < 0)
+                    inside = false;
+        if (inside)
+        {
+            setupTriangle(polygon, 3, out);
+            continue;
+        }
+
+        // Sutherland-Hodgman against the six planes of the view volume
+        QtVertex3D buffers[2][12];
+        int count = 3;
+        std::copy(polygon, polygon + 3, buffers[0]);
+        int current = 0;
+        for (int plane = 0; plane < 6 && count > 0; plane++)
+        {
+            const QtVertex3D *in = buffers[current];
+            QtVertex3D *clipped = buffers[1 - current];
+            int n = 0;
+            for (int k = 0; k < count; k++)
+            {
+                const QtVertex3D &a = in[k];
+                const QtVertex3D &b = in[(k + 1) % count];
+                float da = planeDistance(a, plane);
+                float db = planeDistance(b, plane);
+                if (da >= 0)
+                    clipped[n++] = a;
+                if ((da >= 0) != (db >= 0))
+                    clipped[n++] = interpolate(a, b, da / (da - db));
+            }
+            count = n;
+            current = 1 - current;
+        }
+        if (count >= 3)
+            setupTriangle(buffers[current], count, out);
+    }
+}
+
+void QtRasterizer::setupTriangle(const QtVertex3D *v, int count, std::vector<ScreenTriangle> &out) const
+{
+    float sx[12], sy[12], sz[12], iw[12];
+    for (int k = 0; k < count; k++)
+    {
+        iw[k] = 1.0f / v[k].w;
+        sx[k] = (v[k].x * iw[k] + 1) * 0.5f * viewWidth;
+        sy[k] = (v[k].y * iw[k] + 1) * 0.5f * viewHeight;
+        sz[k] = (v[k].z * iw[k] + 1) * 0.5f;
+    }
+
+    // A clipped polygon is convex, a fan covers it
+    for (int k = 1; k + 1 < count; k++)
+    {
+        int index[3] = { 0, k, k + 1 };
+        float x[3], y[3], z[3], w[3], color[3][4];
+        for (int j = 0; j < 3; j++)
+        {
+            const QtVertex3D &vj = v[index[j]];
+            x[j] = sx[index[j]];
+            y[j] = sy[index[j]];
+            z[j] = sz[index[j]];
+            w[j] = iw[index[j]];
+            color[j][0] = vj.r;
+            color[j][1] = vj.g;
+            color[j][2] = vj.b;
+            color[j][3] = vj.a;
+        }
+        addScreenTriangle(x, y, z, w, color, 0, out);
+    }
+}
+
+void QtRasterizer::setupLine(const Primitive &p, std::vector<ScreenTriangle> &out) const
+{
+    // Only the near and far planes matter, the rest is left to the tiles
+    QtVertex3D a = vertices[p.a];
+    QtVertex3D b = vertices[p.b];
+    for (int plane = 4; plane < 6; plane++)
+    {
+        float da = planeDistance(a, plane);
+        float db = planeDistance(b, plane);
+        if (da < 0 && db < 0)
+            return;
+        if (da < 0)
+            a = interpolate(a, b, da / (da - db));
+        else if (db < 0)
+            b = interpolate(a, b, da / (da - db));
+    }
+
+    float iwa = 1.0f / a.w;
+    float iwb = 1.0f / b.w;
+    float ax = (a.x * iwa + 1) * 0.5f * viewWidth;
+    float ay = (a.y * iwa + 1) * 0.5f * viewHeight;
+    float bx = (b.x * iwb + 1) * 0.5f * viewWidth;
+    float by = (b.y * iwb + 1) * 0.5f * viewHeight;
+    float az = (a.z * iwa + 1) * 0.5f;
+    float bz = (b.z * iwb + 1) * 0.5f;
+
+    // A screen space quad, extended by half the weight past both ends
+    float hw = 0.5f * p.weight * lineScale;
+    float dx = bx - ax;
+    float dy = by - ay;
+    float length = qSqrt(dx * dx + dy * dy);
+    if (length > 1e-6f)
+    {
+        dx *= hw / length;
+        dy *= hw / length;
+    }
+    else
+    {
+        dx = hw;
+        dy = 0;
+    }
+    float nx = -dy;
+    float ny = dx;
+
+    float color[3][4];
+    for (int j = 0; j < 3; j++)
+        std::copy(p.color, p.color + 4, color[j]);
+    float x0[3] = { ax - dx + nx, ax - dx - nx, bx + dx + nx };
+    float y0[3] = { ay - dy + ny, ay - dy - ny, by + dy + ny };
+    float z0[3] = { az, az, bz };
+    float w0[3] = { iwa, iwa, iwb };
+    addScreenTriangle(x0, y0, z0, w0, color, P_RASTER_LINE_BIAS, out);
+    float x1[3] = { bx + dx + nx, ax - dx - nx, bx + dx - nx };
+    float y1[3] = { by + dy + ny, ay - dy - ny, by + dy - ny };
+    float z1[3] = { bz, az, bz };
+    float w1[3] = { iwb, iwa, iwb };
+    addScreenTriangle(x1, y1, z1, w1, color, P_RASTER_LINE_BIAS, out);
+}
+
+void QtRasterizer::addScreenTriangle(const float sx[3], const float sy[3], const float sz[3],
+        const float iw[3], const float color[3][4], float bias,
+        std::vector<ScreenTriangle> &out) const
+{
+    float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sy[1] - sy[0]) * (sx[2] - sx[0]);
+    if (qAbs(area) < 1e-8f)
+        return;
+
+    // Both windings are drawn, the edge functions want a positive area
+    int order[3] = { 0, 1, 2 };
+    if (area < 0)
+    {
+        order[1] = 2;
+        order[2] = 1;
+        area = -area;
+    }
+
+    ScreenTriangle t;
+    t.opaque = true;
+    for (int j = 0; j < 3; j++)
+    {
+        int k = order[j];
+        t.x[j] = sx[k];
+        t.y[j] = sy[k];
+        t.z[j] = sz[k];
+        t.iw[j] = iw[k];
+        for (int c = 0; c < 4; c++)
+            t.c[j][c] = color[k][c] * iw[k];
+        if (color[k][3] < 1)
+            t.opaque = false;
+    }
+    t.area = area;
+    t.bias = bias;
+
+    float minX = qMin(t.x[0], qMin(t.x[1], t.x[2]));
+    float maxX = qMax(t.x[0], qMax(t.x[1], t.x[2]));
+    float minY = qMin(t.y[0], qMin(t.y[1], t.y[2]));
+    float maxY = qMax(t.y[0], qMax(t.y[1], t.y[2]));
+    t.minX = qMax(0, (int) qFloor(minX));
+    t.minY = qMax(0, (int) qFloor(minY));
+    t.maxX = qMin((int) viewWidth - 1, (int) qCeil(maxX));
+    t.maxY = qMin((int) viewHeight - 1, (int) qCeil(maxY));
+    if (t.minX > t.maxX || t.minY > t.maxY)
+        return;
+    out.push_back(t);
+}
+
+static inline quint32 premultiply(float r, float g, float b, float a)
+{
+    int ia = qBound(0, (int) (a * 255 + 0.5f), 255);
+    int ir = qBound(0, (int) (r * a * 255 + 0.5f), 255);
+    int ig = qBound(0, (int) (g * a * 255 + 0.5f), 255);
+    int ib = qBound(0, (int) (b * a * 255 + 0.5f), 255);
+    return (ia << 24) | (ir << 16) | (ig << 8) | ib;
+}
+
+static inline quint32 blend(quint32 src, quint32 dst)
+{
+    // Source over with premultiplied alpha, two channels at a time
+    quint32 inverse = 255 - (src >> 24);
+    quint32 rb = (dst & 0x00FF00FF) * inverse;
+    quint32 ag = ((dst >> 8) & 0x00FF00FF) * inverse;
+    rb = ((rb + ((rb >> 8) & 0x00FF00FF) + 0x00800080) >> 8) & 0x00FF00FF;
+    ag = (ag + ((ag >> 8) & 0x00FF00FF) + 0x00800080) & 0xFF00FF00;
+    return src + rb + ag;
+}
+
+void QtRasterizer::rasterizeTile(int tile)
+{
+    int tx = tile % tilesX;
+    int ty = tile / tilesX;
+    int x0 = tx * P_RASTER_TILE;
+    int y0 = ty * P_RASTER_TILE;
+    int x1 = qMin(x0 + P_RASTER_TILE, (int) viewWidth);
+    int y1 = qMin(y0 + P_RASTER_TILE, (int) viewHeight);
+    float *zbuffer = &depth[(size_t) tile * P_RASTER_TILE * P_RASTER_TILE];
+    std::fill(zbuffer, zbuffer + P_RASTER_TILE * P_RASTER_TILE, 1.0f);
+
+    if (clearPending)
+    {
+        quint32 pixel = premultiply(clearColor.redF(), clearColor.greenF(),
+                clearColor.blueF(), opaqueTarget ? 1.0f : clearColor.alphaF());
+        for (int y = y0; y < y1; y++)
+        {
+            quint32 *line = (quint32 *) (targetBits + (size_t) y * targetStride);
+            std::fill(line + x0, line + x1, pixel);
+        }
+    }
+
+    const std::vector<const ScreenTriangle *> &bin = bins[tile];
+    for (size_t i = 0; i < bin.size(); i++)
+    {
+        const ScreenTriangle &t = *bin[i];
+        int bx0 = qMax(t.minX, x0);
+        int by0 = qMax(t.minY, y0);
+        int bx1 = qMin(t.maxX + 1, x1);
+        int by1 = qMin(t.maxY + 1, y1);
+        if (bx0 >= bx1 || by0 >= by1)
+            continue;
+
+        // Edge functions at the first pixel center, stepped along the rows
+        float inverseArea = 1.0f / t.area;
+        float px = bx0 + 0.5f;
+        float py = by0 + 0.5f;
+        float e0dx = -(t.y[2] - t.y[1]), e0dy = t.x[2] - t.x[1];
+        float e1dx = -(t.y[0] - t.y[2]), e1dy = t.x[0] - t.x[2];
+        float e2dx = -(t.y[1] - t.y[0]), e2dy = t.x[1] - t.x[0];
+        float e0row = e0dy * (py - t.y[1]) + e0dx * (px - t.x[1]);
+        float e1row = e1dy * (py - t.y[2]) + e1dx * (px - t.x[2]);
+        float e2row = e2dy * (py - t.y[0]) + e2dx * (px - t.x[0]);
+
+        for (int y = by0; y < by1; y++)
+        {
+            quint32 *line = (quint32 *) (targetBits + (size_t) y * targetStride);
+            float *zline = zbuffer + (y - y0) * P_RASTER_TILE - x0;
+            float e0 = e0row, e1 = e1row, e2 = e2row;
+            for (int x = bx0; x < bx1; x++, e0 += e0dx, e1 += e1dx, e2 += e2dx)
+            {
+                if (e0 < 0 || e1 < 0 || e2 < 0)
+                    continue;
+                float b0 = e0 * inverseArea;
+                float b1 = e1 * inverseArea;
+                float b2 = e2 * inverseArea;
+                float z = b0 * t.z[0] + b1 * t.z[1] + b2 * t.z[2] - t.bias;
+                if (z > zline[x] || (t.bias == 0 && z == zline[x]))
+                    continue;
+                zline[x] = z;
+
+                // Perspective correct: interpolate c/w and 1/w, then divide
+                float w = 1.0f / (b0 * t.iw[0] + b1 * t.iw[1] + b2 * t.iw[2]);
+                float c[4];
+                for (int k = 0; k < 4; k++)
+                    c[k] = (b0 * t.c[0][k] + b1 * t.c[1][k] + b2 * t.c[2][k]) * w;
+                quint32 src = premultiply(c[0], c[1], c[2], c[3]);
+                line[x] = (t.opaque ? src : blend(src, line[x]));
+                if (opaqueTarget)
+                    line[x] |= 0xFF000000;
+            }
+            e0row += e0dy;
+            e1row += e1dy;
+            e2row += e2dy;
+        }
+    }
+}
+
+void QtRasterizer::render(QImage &image, float lineScale_)
+{
+    if (primitives.empty() && !clearPending)
+        return;
+
+    viewWidth = image.width();
+    viewHeight = image.height();
+    lineScale = lineScale_;
+    tilesX = (image.width() + P_RASTER_TILE - 1) / P_RASTER_TILE;
+    tilesY = (image.height() + P_RASTER_TILE - 1) / P_RASTER_TILE;
+    int tiles = tilesX * tilesY;
+    depth.resize((size_t) tiles * P_RASTER_TILE * P_RASTER_TILE);
+
+    // Setup runs over chunks of primitives, binning keeps their order
+    int chunkCount = qBound(1, (int) primitives.size() / 256, pool.maxThreadCount() * 4);
+    chunks.resize(chunkCount);
+    runParallel(Worker::SETUP, chunkCount);
+
+    bins.resize(tiles);
+    for (int i = 0; i < tiles; i++)
+        bins[i].clear();
+    renderedTriangles = 0;
+    for (int i = 0; i < chunkCount; i++)
+    {
+        const std::vector<ScreenTriangle> &chunk = chunks[i];
+        renderedTriangles += chunk.size();
+        for (size_t j = 0; j < chunk.size(); j++)
+        {
+            const ScreenTriangle &t = chunk[j];
+            for (int ty = t.minY / P_RASTER_TILE; ty <= t.maxY / P_RASTER_TILE; ty++)
+                for (int tx = t.minX / P_RASTER_TILE; tx <= t.maxX / P_RASTER_TILE; tx++)
+                    bins[ty * tilesX + tx].push_back(&t);
+        }
+    }
+
+    // bits() detaches the image, once here rather than from every tile
+    targetBits = image.bits();
+    targetStride = image.bytesPerLine();
+    opaqueTarget = !image.hasAlphaChannel();
+    runParallel(Worker::RASTER, tiles);
+
+    vertices.clear();
+    primitives.clear();
+    clearPending = false;
+    targetBits = 0;
+}
+
+PROCESSING_END_NAMESPACE
@@ -0,0 +1,99 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef P_QTRASTERIZER_H
+#define P_QTRASTERIZER_H
+
+#include "pglobal.h"
+#include <QMatrix4x4>
+#include <QThreadPool>
+#include <QImage>
+#include <QColor>
+#include <vector>
+
+PROCESSING_BEGIN_NAMESPACE
+
+struct QtVertex3D
+{
+    float x, y, z, w;       // clip space
+    float r, g, b, a;       // 0..1
+};
+
+/**
+ * Software triangle rasterizer for P3D.
+ *
+ * Vertices are transformed to clip space as they are added. At render()
+ * the primitives are clipped to the view volume, set up in screen space
+ * and binned into tiles. Worker threads then rasterize the tiles, each
+ * against its own slice of the depth buffer. Colors are interpolated with
+ * perspective correction. Within a tile primitives are drawn in submission
+ * order, so blending matches the order of the sketch.
+ */
+class QtRasterizer
+{
+public:
+    QtRasterizer();
+    ~QtRasterizer();
+
+    int addVertices(const QMatrix4x4 &matrix, const float *points, const float *colors, int count);
+    void addTriangle(int a, int b, int c);
+    void addLine(int a, int b, const QColor &color, float weight);
+    void clear(const QColor &color);
+
+    void render(QImage &image, float lineScale);
+    int triangleCount() const { return renderedTriangles; }
+
+private:
+    struct Primitive
+    {
+        int a, b, c;        // c < 0 for a line
+        float color[4];
+        float weight;
+    };
+
+    struct ScreenTriangle
+    {
+        float x[3], y[3], z[3];
+        float iw[3];
+        float c[3][4];      // color divided by w
+        int minX, minY, maxX, maxY;
+        float area;
+        float bias;
+        bool opaque;
+    };
+
+    class Worker;
+    friend class Worker;
+
+    void runParallel(int stage, int count);
+    void setup(int first, int last, std::vector<ScreenTriangle> &out) const;
+    void setupTriangle(const QtVertex3D *v, int count, std::vector<ScreenTriangle> &out) const;
+    void setupLine(const Primitive &p, std::vector<ScreenTriangle> &out) const;
+    void addScreenTriangle(const float sx[3], const float sy[3], const float sz[3],
+            const float iw[3], const float color[3][4], float bias,
+            std::vector<ScreenTriangle> &out) const;
+    void rasterizeTile(int tile);
+
+    std::vector<QtVertex3D> vertices;
+    std::vector<Primitive> primitives;
+    std::vector<std::vector<ScreenTriangle> > chunks;
+    std::vector<std::vector<const ScreenTriangle *> > bins;
+    std::vector<float> depth;
+    QThreadPool pool;
+
+    uchar *targetBits;
+    int targetStride;
+    bool opaqueTarget;
+    int tilesX;
+    int tilesY;
+    float viewWidth;
+    float viewHeight;
+    float lineScale;
+    QColor clearColor;
+    bool clearPending;
+    int renderedTriangles;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // P_QTRASTERIZER_H
@@ -0,0 +1,288 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "qtshapecache.h"
+#include <QtMath>
+#include <algorithm>
+
+PROCESSING_BEGIN_NAMESPACE
+
+// Total cost of the cached shapes, about one per path element
+#define P_SHAPE_CACHE_COST (1 << 16)
+
+static void addPolygon(QPainterPath &path, const float *xy, const int *index, int count)
+{
+    path.moveTo(xy[2 * index[0]], xy[2 * index[0] + 1]);
+    for (int i = 1; i < count; i++)
+        path.lineTo(xy[2 * index[i]], xy[2 * index[i] + 1]);
+    path.closeSubpath();
+}
+
+static void addRoundedRect(QPainterPath &path, const float *p, int count)
+{
+    QRectF r = QRectF(p[0], p[1], p[2], p[3]).normalized();
+    float tl = 0, tr = 0, br = 0, bl = 0;
+    if (count == 5)
+        tl = tr = br = bl = p[4];
+    else if (count == 8)
+    {
+        tl = p[4];
+        tr = p[5];
+        br = p[6];
+        bl = p[7];
+    }
+
+    // As in Processing, no corner takes more than half the shorter side
+    float most = 0.5 * qMin(r.width(), r.height());
+    tl = qBound(0.0f, tl, most);
+    tr = qBound(0.0f, tr, most);
+    br = qBound(0.0f, br, most);
+    bl = qBound(0.0f, bl, most);
+    if (tl == 0 && tr == 0 && br == 0 && bl == 0)
+    {
+        path.addRect(r);
+        return;
+    }
+
+    // Clockwise from the top left, each corner a quarter of an ellipse
+    float x = r.x(), y = r.y(), w = r.width(), h = r.height();
+    path.moveTo(x + tl, y);
+    path.lineTo(x + w - tr, y);
+    if (tr > 0)
+        path.arcTo(x + w - 2 * tr, y, 2 * tr, 2 * tr, 90, -90);
+    path.lineTo(x + w, y + h - br);
+    if (br > 0)
+        path.arcTo(x + w - 2 * br, y + h - 2 * br, 2 * br, 2 * br, 0, -90);
+    path.lineTo(x + bl, y + h);
+    if (bl > 0)
+        path.arcTo(x, y + h - 2 * bl, 2 * bl, 2 * bl, 270, -90);
+    path.lineTo(x, y + tl);
+    if (tl > 0)
+        path.arcTo(x, y, 2 * tl, 2 * tl, 180, -90);
+    path.closeSubpath();
+}
+
+static void addArc(QtShapeGeometry &g, const float *p, ArcMode mode)
+{
+    // Angles run clockwise on screen, Qt's run the other way
+    QRectF r(p[0] - 0.5 * p[2], p[1] - 0.5 * p[3], p[2], p[3]);
+    qreal start = -qRadiansToDegrees(p[4]);
+    qreal sweep = -qRadiansToDegrees(p[5] - p[4]);
+
+    QPainterPath outline;
+    if (mode == OPEN_PIE || mode == PIE)
+        outline.moveTo(r.center());
+    else
+        outline.arcMoveTo(r, start);
+    outline.arcTo(r, start, sweep);
+    outline.closeSubpath();
+    g.fill = outline;
+
+    if (mode == OPEN_PIE || mode == OPEN)
+    {
+        g.stroke.arcMoveTo(r, start);
+        g.stroke.arcTo(r, start, sweep);
+        g.shared = false;
+    }
+}
+
+static void unite(QRectF &bounds, bool &empty, const QRectF &r)
+{
+    // QRectF::united() skips empty rects, the bounds of a line or a
+    // point would be lost
+    if (empty)
+        bounds = r;
+    else
+    {
+        bounds.setLeft(qMin(bounds.left(), r.left()));
+        bounds.setTop(qMin(bounds.top(), r.top()));
+        bounds.setRight(qMax(bounds.right(), r.right()));
+        bounds.setBottom(qMax(bounds.bottom(), r.bottom()));
+    }
+    empty = false;
+}
+
+static void finish(QtShapeGeometry &g)
+{
+    if (g.shared)
+        g.stroke = g.fill;
+    bool empty = true;
+    if (!g.fill.isEmpty())
+        unite(g.bounds, empty, g.fill.boundingRect());
+    if (!g.shared && !g.stroke.isEmpty())
+        unite(g.bounds, empty, g.stroke.boundingRect());
+    if (!g.points.isEmpty())
+        unite(g.bounds, empty, g.points.boundingRect());
+}
+
+QtShapeCache::QtShapeCache()
+    : cache(P_SHAPE_CACHE_COST)
+{
+}
+
+QtShapeCache::Entry & QtShapeCache::find(const PShape &s)
+{
+    if (s.getFamily() != PATH)
+    {
+        const std::vector<float> &params = s.getParams();
+        return find(s.getFamily(), params.data(), params.size(), s.getArcMode());
+    }
+
+    // The key changes with the vertices
+    Entry *entry = cache.object(s.cacheKey());
+    if (entry)
+        return *entry;
+    entry = new Entry;
+    entry->family = PATH;
+    entry->mode = OPEN;
+    build(s.getKind(), s.getVertices().data(), s.getVertexCount(), s.getEndMode(), entry->geometry);
+    return insert(s.cacheKey(), entry);
+}
+
+QtShapeCache::Entry & QtShapeCache::find(ShapeFamily family, const float *params, int count, ArcMode mode)
+{
+    unsigned long long key = PShape::cacheKey(family, params, count, mode);
+    Entry *entry = cache.object(key);
+    if (entry && entry->family == family && entry->mode == mode
+            && entry->params.size() == (size_t) count
+            && std::equal(params, params + count, entry->params.begin()))
+        return *entry;
+
+    entry = new Entry;
+    entry->family = family;
+    entry->mode = mode;
+    entry->params.assign(params, params + count);
+    build(family, params, count, mode, entry->geometry);
+    return insert(key, entry);
+}
+
+QtShapeCache::Entry & QtShapeCache::insert(unsigned long long key, Entry *entry)
+{
+    // An entry costing more than the whole cache would be deleted
+    // right away
+    const QtShapeGeometry &g = entry->geometry;
+    int cost = 1 + g.fill.elementCount() + g.points.size();
+    if (!g.shared)
+        cost += g.stroke.elementCount();
+    cache.insert(key, entry, qMin(cost, cache.maxCost()));
+    return *entry;
+}
+
+void QtShapeCache::build(ShapeFamily family, const float *p, int count, ArcMode mode, QtShapeGeometry &g)
+{
+    static const int corners[4] = { 0, 1, 2, 3 };
+    g = QtShapeGeometry();
+    g.fill.setFillRule(Qt::WindingFill);
+    switch (family)
+    {
+    case POINT:
+        g.points << QPointF(p[0], p[1]);
+        break;
+
+    case LINE:
+        g.stroke.moveTo(p[0], p[1]);
+        g.stroke.lineTo(p[2], p[3]);
+        g.shared = false;
+        break;
+
+    case TRIANGLE:
+        addPolygon(g.fill, p, corners, 3);
+        break;
+
+    case QUAD:
+        addPolygon(g.fill, p, corners, 4);
+        break;
+
+    case RECT:
+        addRoundedRect(g.fill, p, count);
+        break;
+
+    case ELLIPSE:
+        g.fill.addEllipse(QPointF(p[0], p[1]), 0.5 * p[2], 0.5 * p[3]);
+        break;
+
+    case ARC:
+        addArc(g, p, mode);
+        break;
+
+    case PATH:
+        break;
+    }
+    finish(g);
+}
+
+void QtShapeCache::build(ShapeKind kind, const float *xy, int count, EndMode mode, QtShapeGeometry &g)
+{
+    g = QtShapeGeometry();
+    g.fill.setFillRule(Qt::WindingFill);
+    switch (kind)
+    {
+    case POLYGON:
+        // Filling closes the outline either way, the stroke only on CLOSE
+        if (count < 1)
+            break;
+        g.fill.moveTo(xy[0], xy[1]);
+        for (int i = 1; i < count; i++)
+            g.fill.lineTo(xy[2 * i], xy[2 * i + 1]);
+        if (mode == CLOSE)
+            g.fill.closeSubpath();
+        break;
+
+    case POINTS:
+        for (int i = 0; i < count; i++)
+            g.points << QPointF(xy[2 * i], xy[2 * i + 1]);
+        break;
+
+    case LINES:
+        for (int i = 0; i + 1 < count; i += 2)
+        {
+            g.stroke.moveTo(xy[2 * i], xy[2 * i + 1]);
+            g.stroke.lineTo(xy[2 * i + 2], xy[2 * i + 3]);
+        }
+        g.shared = false;
+        break;
+
+    case TRIANGLES:
+        for (int i = 0; i + 2 < count; i += 3)
+        {
+            int t[3] = { i, i + 1, i + 2 };
+            addPolygon(g.fill, xy, t, 3);
+        }
+        break;
+
+    case TRIANGLE_FAN:
+        for (int i = 1; i + 1 < count; i++)
+        {
+            int t[3] = { 0, i, i + 1 };
+            addPolygon(g.fill, xy, t, 3);
+        }
+        break;
+
+    case TRIANGLE_STRIP:
+        for (int i = 0; i + 2 < count; i++)
+        {
+            int t[3] = { i, i + 1, i + 2 };
+            addPolygon(g.fill, xy, t, 3);
+        }
+        break;
+
+    case QUADS:
+        for (int i = 0; i + 3 < count; i += 4)
+        {
+            int q[4] = { i, i + 1, i + 2, i + 3 };
+            addPolygon(g.fill, xy, q, 4);
+        }
+        break;
+
+    case QUAD_STRIP:
+        for (int i = 0; i + 3 < count; i += 2)
+        {
+            int q[4] = { i, i + 1, i + 3, i + 2 };
+            addPolygon(g.fill, xy, q, 4);
+        }
+        break;
+    }
+    finish(g);
+}
+
+PROCESSING_END_NAMESPACE
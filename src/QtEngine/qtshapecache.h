@@ -0,0 +1,85 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef P_QTSHAPECACHE_H
+#define P_QTSHAPECACHE_H
+
+#include <QCache>
+#include <QPainterPath>
+#include <QPolygonF>
+#include <QPen>
+#include <vector>
+#include <climits>
+#include "pglobal.h"
+#include "pshape.h"
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * A shape in its own coordinates. Fill and stroke differ where only part
+ * of the outline is stroked, as with open arcs.
+ */
+struct QtShapeGeometry
+{
+    QtShapeGeometry() : shared(true) {}
+
+    QPainterPath fill;
+    QPainterPath stroke;
+    QPolygonF points;
+    QRectF bounds;
+    bool shared;
+};
+
+/**
+ * Triangles of a shape in its own coordinates as x, y pairs, fine enough
+ * for a scale of up to 2^level. The stroke holds for the pen it was built
+ * with.
+ */
+struct QtShapeMesh
+{
+    QtShapeMesh() : level(INT_MIN) {}
+
+    std::vector<float> fill;
+    std::vector<float> stroke;
+    int level;
+    QPen pen;
+};
+
+/**
+ * Built shapes, least recently used ones are dropped. Paths are found by
+ * their key, primitives by their parameters, so the rounded rects and arcs
+ * drawn every frame are built once as well.
+ */
+class QtShapeCache
+{
+public:
+    struct Entry
+    {
+        Entry() : family(PATH), mode(OPEN) {}
+
+        QtShapeGeometry geometry;
+        QtShapeMesh mesh;
+        ShapeFamily family;
+        ArcMode mode;
+        std::vector<float> params;
+    };
+
+public:
+    QtShapeCache();
+
+    Entry & find(const PShape &s);
+    Entry & find(ShapeFamily family, const float *params, int count, ArcMode mode=OPEN);
+    void clear() { cache.clear(); }
+
+    static void build(ShapeFamily family, const float *params, int count, ArcMode mode, QtShapeGeometry &g);
+    static void build(ShapeKind kind, const float *xy, int count, EndMode mode, QtShapeGeometry &g);
+
+private:
+    Entry & insert(unsigned long long key, Entry *entry);
+
+    QCache<unsigned long long, Entry> cache;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // P_QTSHAPECACHE_H
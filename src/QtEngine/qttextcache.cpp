@@ -0,0 +1,165 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "qttextcache.h"
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QTextLayout>
+#include <QtMath>
+
+PROCESSING_BEGIN_NAMESPACE
+
+// Total glyphs of the cached runs
+#define P_TEXT_RUN_CACHE_COST (1 << 15)
+
+// Side of the square glyph atlas in pixels
+#define P_TEXT_ATLAS_SIZE 1024
+
+// Lines are not wrapped, this only bounds the layout
+#define P_TEXT_LINE_WIDTH 1e6
+
+QtTextCache::QtTextCache()
+    : runs(P_TEXT_RUN_CACHE_COST),
+      image(P_TEXT_ATLAS_SIZE, P_TEXT_ATLAS_SIZE, QImage::Format_ARGB32_Premultiplied)
+{
+    resetAtlas();
+}
+
+int QtTextCache::findFont(const PFont &font, float size, qreal scale)
+{
+    QString name = QString::fromStdString(font.getName());
+    QString key = QString("%1|%2|%3|%4").arg(name).arg(size).arg(font.isSmooth()).arg(scale);
+    QHash<QString, int>::const_iterator it = fontIds.constFind(key);
+    if (it != fontIds.constEnd())
+        return it.value();
+
+    Font f;
+    if (!name.isEmpty())
+        f.font.setFamily(name);
+    f.font.setPixelSize(qMax(1, qRound(size * scale)));
+    f.font.setStyleStrategy(font.isSmooth() ? QFont::PreferAntialias : QFont::NoAntialias);
+    QFontMetricsF metrics(f.font);
+    f.ascent = metrics.ascent();
+    f.descent = metrics.descent();
+    f.smooth = font.isSmooth();
+    fonts.push_back(f);
+    fontIds.insert(key, fonts.size() - 1);
+    return fonts.size() - 1;
+}
+
+const QtTextCache::Run & QtTextCache::run(int font, const QString &text)
+{
+    RunKey key(font, text);
+    Run *r = runs.object(key);
+    if (r)
+        return *r;
+
+    // Shaped once, a new line starts at every '\n'
+    QString lines = text;
+    lines.replace(QChar('\n'), QChar(QChar::LineSeparator));
+    QTextLayout layout(lines, fonts[font].font);
+    QTextOption option;
+    option.setWrapMode(QTextOption::NoWrap);
+    layout.setTextOption(option);
+
+    r = new Run;
+    r->width = 0;
+    r->height = 0;
+    r->ascent = fonts[font].ascent;
+    r->smooth = fonts[font].smooth;
+    layout.beginLayout();
+    for (QTextLine line = layout.createLine(); line.isValid(); line = layout.createLine())
+    {
+        line.setLineWidth(P_TEXT_LINE_WIDTH);
+        line.setPosition(QPointF(0, r->height));
+        if (r->height == 0)
+            r->ascent = line.ascent();
+        r->height += line.height();
+        r->width = qMax(r->width, line.naturalTextWidth());
+    }
+    layout.endLayout();
+    r->glyphs = layout.glyphRuns();
+
+    int cost = 1;
+    for (int i = 0; i < r->glyphs.size(); i++)
+        cost += r->glyphs[i].glyphIndexes().size();
+    runs.insert(key, r, qMin(cost, runs.maxCost()));
+    return *r;
+}
+
+int QtTextCache::faceOf(const QRawFont &raw, bool smooth)
+{
+    // Fallback fonts in a run number their glyphs on their own. Faces are
+    // told apart by all of what they are, a hash could collide.
+    QString key = QString("%1|%2|%3|%4").arg(raw.familyName()).arg(raw.styleName())
+            .arg(raw.pixelSize()).arg(smooth);
+    QHash<QString, int>::const_iterator it = faceIds.constFind(key);
+    if (it != faceIds.constEnd())
+        return it.value();
+    int id = faceIds.size();
+    faceIds.insert(key, id);
+    return id;
+}
+
+bool QtTextCache::glyph(int face, const QRawFont &raw, quint32 index, QRgb color, bool smooth, Glyph &out)
+{
+    GlyphKey key((quint64(face) << 32) | index, color);
+    QHash<GlyphKey, Glyph>::const_iterator it = glyphs.constFind(key);
+    if (it != glyphs.constEnd())
+    {
+        out = it.value();
+        return true;
+    }
+
+    // A pixel of margin around the glyph's box for antialiasing
+    QRectF box = raw.boundingRect(index);
+    int w = qCeil(box.width()) + 3;
+    int h = qCeil(box.height()) + 3;
+    if (w > image.width() || h > image.height())
+        return false;
+    if (shelfX + w > image.width())
+    {
+        shelfX = 0;
+        shelfY += shelfHeight;
+        shelfHeight = 0;
+    }
+    if (shelfY + h > image.height())
+        resetAtlas();
+
+    Glyph g;
+    g.rect = QRect(shelfX, shelfY, w, h);
+    g.offset = QPoint(qFloor(box.x()) - 1, qFloor(box.y()) - 1);
+    QGlyphRun single;
+    single.setRawFont(raw);
+    single.setGlyphIndexes(QVector<quint32>() << index);
+    single.setPositions(QVector<QPointF>() << QPointF(g.rect.x() - g.offset.x(), g.rect.y() - g.offset.y()));
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::TextAntialiasing, smooth);
+    painter.setClipRect(g.rect);
+    painter.setPen(QColor::fromRgba(color));
+    painter.drawGlyphRun(QPointF(0, 0), single);
+    painter.end();
+
+    shelfX += w;
+    shelfHeight = qMax(shelfHeight, h);
+    glyphs.insert(key, g);
+    out = g;
+    return true;
+}
+
+void QtTextCache::clear()
+{
+    runs.clear();
+    resetAtlas();
+}
+
+void QtTextCache::resetAtlas()
+{
+    image.fill(Qt::transparent);
+    glyphs.clear();
+    shelfX = 0;
+    shelfY = 0;
+    shelfHeight = 0;
+}
+
+PROCESSING_END_NAMESPACE
@@ -0,0 +1,97 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef P_QTTEXTCACHE_H
+#define P_QTTEXTCACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QPair>
+#include <QFont>
+#include <QGlyphRun>
+#include <QRawFont>
+#include <QImage>
+#include <QString>
+#include <vector>
+#include "pglobal.h"
+#include "pfont.h"
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * Text shaped and rasterized once. Fonts are resolved per device scale,
+ * so every size here is in device pixels.
+ *
+ * A run is a string laid out in a font, kept with its glyphs and width
+ * until it has not been drawn for a while. Glyphs are rendered into an
+ * atlas in their color, a label drawn again is copied out of it glyph by
+ * glyph. The atlas starts over once it is full.
+ */
+class QtTextCache
+{
+public:
+    struct Font
+    {
+        QFont font;
+        qreal ascent;
+        qreal descent;
+        bool smooth;
+    };
+
+    // Glyph positions are from the top left, the first baseline is
+    // ascent below it
+    struct Run
+    {
+        QList<QGlyphRun> glyphs;
+        qreal width;
+        qreal height;
+        qreal ascent;
+        bool smooth;
+    };
+
+    struct Glyph
+    {
+        QRect rect;
+        QPoint offset;
+    };
+
+public:
+    QtTextCache();
+
+    int findFont(const PFont &font, float size, qreal scale);
+    const Font & font(int id) const { return fonts[id]; }
+    const Run & run(int font, const QString &text);
+
+    // A glyph of the face is copied from rect in the atlas to offset from
+    // the pen position. False when it is larger than the whole atlas.
+    int faceOf(const QRawFont &raw, bool smooth);
+    bool glyph(int face, const QRawFont &raw, quint32 index, QRgb color, bool smooth, Glyph &out);
+    const QImage & atlas() const { return image; }
+
+    void clear();
+
+private:
+    typedef QPair<int, QString> RunKey;
+
+    // The face in the upper half of the first, the glyph in the lower
+    typedef QPair<quint64, QRgb> GlyphKey;
+
+    void resetAtlas();
+
+    std::vector<Font> fonts;
+    QHash<QString, int> fontIds;
+    QCache<RunKey, Run> runs;
+
+    // Glyphs are packed left to right in shelves as tall as their
+    // tallest glyph
+    QImage image;
+    QHash<QString, int> faceIds;
+    QHash<GlyphKey, Glyph> glyphs;
+    int shelfX;
+    int shelfY;
+    int shelfHeight;
+};
+
+PROCESSING_END_NAMESPACE
+
+#endif // P_QTTEXTCACHE_H
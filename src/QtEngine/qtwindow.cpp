@@ -2,11 +2,12 @@
  * Author: Gary Huang <gh.nctu+code@gmail.com>
  */
 #include <QHBoxLayout>
+#include <QWindow>
 
 #include "qtwindow.h"
 #include "qtcanvas.h"
 #include "qtglcanvas.h"
-#include "qtgl3dcanvas.h"
+#include "qt3dcanvas.h"
 #include <iostream>
 
 PROCESSING_BEGIN_NAMESPACE
@@ -14,7 +15,12 @@ PROCESSING_BEGIN_NAMESPACE
 extern int frameRate;
 
 QtWindow::QtWindow()
-    : Window(), QWidget(0), timer(0)
+    : Window(), QWidget(0), timer(0), layout(0),
+      fps(P_FRAMERATE_DEFAULT),
+      looping(true),
+      inputDriven(false),
+      redrawPending(false),
+      exposed(true)
 {
 }
 
@@ -33,8 +39,7 @@ static QtCanvas *createQtCanvas(enum Renderer renderer, QWidget *parent=0)
             return new QtGLCanvas(parent);
 
         case P3D:
-            throw "P3D is not support yet";
-            return new QtGL3DCanvas(parent);
+            return new Qt3DCanvas(parent);
 
         case PDF:
             throw "PDF is not support yet";
@@ -53,6 +58,7 @@ Canvas * QtWindow::replaceCanvas(enum Renderer renderer)
     QtCanvas *qtcanvas_last = (QtCanvas *) canvas;
 
     qtcanvas->setMouseTracking(true);
+    qtcanvas->installEventFilter(this);
     qtcanvas->copyAllElementsFrom(*qtcanvas_last);
 
     layout->removeWidget(qtcanvas_last);
@@ -69,6 +75,7 @@ Canvas * QtWindow::createCanvas(enum Renderer renderer)
 {
     QtCanvas *qtcanvas = createQtCanvas(renderer, this);
     qtcanvas->setMouseTracking(true);
+    qtcanvas->installEventFilter(this);
 
     layout = new QHBoxLayout;
     layout->setContentsMargins(0, 0, 0, 0);
@@ -79,12 +86,136 @@ Canvas * QtWindow::createCanvas(enum Renderer renderer)
     return canvas;
 }
 
-void QtWindow::start(int fps)
+void QtWindow::setResizable(bool resizable)
 {
-    QtCanvas *qtcanvas = (QtCanvas *) canvas;
+    if (resizable)
+    {
+        setMinimumSize(P_WIDTH_MINIMUM, P_HEIGHT_MINIMUM);
+        setMaximumSize(QWIDGETSIZE_MAX, QWIDGETSIZE_MAX);
+    }
+    else
+        QWidget::setFixedSize(size());
+    if (canvas)
+        canvas->setResizable(resizable);
+}
+
+void QtWindow::start(int fps_)
+{
+    fps = (fps_ < P_FRAMERATE_MINIMUM ? P_FRAMERATE_MINIMUM : fps_);
     timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, qtcanvas, &QtCanvas::animate);
-    timer->start(1000.0 / fps);
+    connect(timer, &QTimer::timeout, this, &QtWindow::animate);
+    updateTimer();
+
+    // noLoop() in setup() still draws the first frame
+    if (!looping)
+        redraw();
+}
+
+void QtWindow::loop()
+{
+    looping = true;
+    inputDriven = false;
+    updateTimer();
+}
+
+void QtWindow::noLoop()
+{
+    looping = false;
+    inputDriven = false;
+    updateTimer();
+}
+
+void QtWindow::loopOnInput()
+{
+    looping = false;
+    inputDriven = true;
+    updateTimer();
+}
+
+void QtWindow::redraw()
+{
+    // Several requests before the next event loop turn are one frame, and
+    // a running loop renders the next frame anyway.
+    if (looping || redrawPending || !canvas)
+        return;
+    redrawPending = true;
+    QTimer::singleShot(0, this, &QtWindow::animate);
+}
+
+void QtWindow::animate()
+{
+    redrawPending = false;
+    canvas->animate();
+}
+
+void QtWindow::updateTimer()
+{
+    if (!timer)
+        return;
+
+    // Nothing to present while hidden or minimized
+    if (!looping || !isVisible() || isMinimized())
+    {
+        timer->stop();
+        return;
+    }
+
+    // Keep the sketch ticking slowly while the window is obscured
+    int interval = 1000 / (exposed ? fps : P_FRAMERATE_IDLE);
+    if (!timer->isActive() || timer->interval() != interval)
+        timer->start(interval);
+}
+
+bool QtWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == windowHandle())
+    {
+        if (event->type() == QEvent::Expose)
+        {
+            exposed = windowHandle()->isExposed();
+            updateTimer();
+        }
+    }
+    else if (inputDriven)
+    {
+        switch (event->type())
+        {
+            case QEvent::MouseButtonPress:
+            case QEvent::MouseButtonRelease:
+            case QEvent::MouseMove:
+            case QEvent::Wheel:
+            case QEvent::KeyPress:
+            case QEvent::KeyRelease:
+                redraw();
+                break;
+            default:
+                break;
+        }
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+void QtWindow::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::WindowStateChange)
+        updateTimer();
+    QWidget::changeEvent(event);
+}
+
+void QtWindow::showEvent(QShowEvent *event)
+{
+    // The native window only exists once shown
+    if (windowHandle())
+        windowHandle()->installEventFilter(this);
+    exposed = true;
+    updateTimer();
+    QWidget::showEvent(event);
+}
+
+void QtWindow::hideEvent(QHideEvent *event)
+{
+    updateTimer();
+    QWidget::hideEvent(event);
 }
 
 PROCESSING_END_NAMESPACE
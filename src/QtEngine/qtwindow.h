@@ -21,18 +21,36 @@ public:
 
     void setWindowTitle(const char *title) OVERRIDE { QWidget::setWindowTitle(title); }
     void setFixedSize(int width, int height) OVERRIDE { QWidget::setFixedSize(width, height); }
+    void setResizable(bool resizable) OVERRIDE;
     bool hasParent() const { return true; }
     void show() OVERRIDE { QWidget::show(); }
     void start(int fps) OVERRIDE;
     Canvas * createCanvas(enum Renderer) OVERRIDE;
     Canvas * replaceCanvas(enum Renderer) OVERRIDE;
 
-    void loop() { timer->start(); }
-    void noLoop() { timer->stop(); }
+    void loop() OVERRIDE;
+    void noLoop() OVERRIDE;
+    void loopOnInput() OVERRIDE;
+    void redraw() OVERRIDE;
+    bool isLooping() const OVERRIDE { return looping; }
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) Q_DECL_OVERRIDE;
+    void changeEvent(QEvent *event) Q_DECL_OVERRIDE;
+    void showEvent(QShowEvent *event) Q_DECL_OVERRIDE;
+    void hideEvent(QHideEvent *event) Q_DECL_OVERRIDE;
 
 private:
+    void animate();
+    void updateTimer();
+
     QTimer *timer;
     QHBoxLayout *layout;
+    int fps;
+    bool looping;
+    bool inputDriven;
+    bool redrawPending;
+    bool exposed;
 };
 
 PROCESSING_END_NAMESPACE
@@ -0,0 +1,270 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include "spatialgrid.h"
+#include "pparallel.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+PROCESSING_BEGIN_NAMESPACE
+
+SpatialGrid::SpatialGrid(float cellSize)
+    : requested(cellSize), cell(cellSize), dims(2)
+{
+    if (!(cellSize > 0))
+        throw "SpatialGrid(): cell size must be positive";
+    clear();
+}
+
+SpatialGrid::SpatialGrid(float cellSize, const PVectorArray &points)
+    : SpatialGrid(cellSize)
+{
+    build(points);
+}
+
+void SpatialGrid::build(const PVectorArray &points)
+{
+    int n = points.size();
+    if (!n)
+    {
+        clear();
+        return;
+    }
+
+    dims = (points.is3D() ? 3 : 2);
+    const float *source[3] = { points.xData(), points.yData(), points.zData() };
+    float high[3] = { 0, 0, 0 };
+    for (int k = 0; k < 3; k++)
+    {
+        low[k] = 0;
+        if (k >= dims)
+            continue;
+        const float *v = source[k];
+        low[k] = high[k] = v[0];
+        for (int i = 1; i < n; i++)
+        {
+            low[k] = std::min(low[k], v[i]);
+            high[k] = std::max(high[k], v[i]);
+        }
+    }
+
+    // The bounds are taken in float below, so they must span a float
+    double span[3] = { 0, 0, 0 };
+    for (int k = 0; k < dims; k++)
+    {
+        span[k] = (double) high[k] - low[k];
+        if (!(span[k] <= FLT_MAX))
+            throw "SpatialGrid::build(): points out of range";
+    }
+
+    // Spread out points would make mostly empty cells, take larger ones.
+    // A cell as large as the span gives one cell, so the loop ends.
+    double limit = std::max((double) n * P_SPATIAL_GRID_CELLS, 1.0);
+    double size = requested;
+    for (;;)
+    {
+        double cells = 1;
+        for (int k = 0; k < dims; k++)
+            cells *= std::floor(span[k] / size) + 1;
+        if (cells <= limit)
+            break;
+        size *= 2;
+    }
+    cell = (float) std::min(size, (double) FLT_MAX);
+    scale = 1 / cell;
+    for (int k = 0; k < 3; k++)
+        extent[k] = (k < dims ? (int) ((high[k] - low[k]) * scale) + 1 : 1);
+
+    keys.resize(n);
+    parallelFor(n, P_PARALLEL_GRAIN, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+        {
+            int key = 0;
+            for (int k = dims - 1; k >= 0; k--)
+            {
+                int c = std::min((int) ((source[k][i] - low[k]) * scale), extent[k] - 1);
+                key = key * extent[k] + c;
+            }
+            keys[i] = key;
+        }
+    });
+
+    // Counting sort, stable so the points of a cell keep their order.
+    // Scattering moves every start to the next cell's, shifted back after.
+    int cells = extent[0] * extent[1] * extent[2];
+    starts.assign(cells + 1, 0);
+    for (int i = 0; i < n; i++)
+        starts[keys[i]]++;
+    int sum = 0;
+    for (int c = 0; c <= cells; c++)
+    {
+        int count = starts[c];
+        starts[c] = sum;
+        sum += count;
+    }
+    order.resize(n);
+    for (int i = 0; i < n; i++)
+        order[starts[keys[i]]++] = i;
+    for (int c = cells; c > 0; c--)
+        starts[c] = starts[c - 1];
+    starts[0] = 0;
+
+    sx.resize(n);
+    sy.resize(n);
+    sz.resize(dims == 3 ? n : 0);
+    parallelFor(n, P_PARALLEL_GRAIN, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+        {
+            sx[i] = source[0][order[i]];
+            sy[i] = source[1][order[i]];
+        }
+        if (dims == 3)
+            for (int i = begin; i < end; i++)
+                sz[i] = source[2][order[i]];
+    });
+}
+
+void SpatialGrid::clear()
+{
+    cell = requested;
+    scale = 1 / cell;
+    for (int k = 0; k < 3; k++)
+    {
+        low[k] = 0;
+        extent[k] = 1;
+    }
+    starts.assign(1, 0);
+    order.clear();
+    keys.clear();
+    sx.clear();
+    sy.clear();
+    sz.clear();
+}
+
+int SpatialGrid::cellOf(const PVector &p) const
+{
+    float q[3] = { p.x(), p.y(), p.is3D() ? p.z() : 0.0f };
+    int from[3], to[3];
+    if (!cellRange(q, 0, from, to))
+        return -1;
+    return (from[2] * extent[1] + from[1]) * extent[0] + from[0];
+}
+
+bool SpatialGrid::cellRange(const float *q, float radius, int *from, int *to) const
+{
+    if (!size() || radius < 0)
+        return false;
+    for (int k = 0; k < 3; k++)
+    {
+        from[k] = to[k] = 0;
+        if (k >= dims)
+            continue;
+        float a = std::floor((q[k] - radius - low[k]) * scale);
+        float b = std::floor((q[k] + radius - low[k]) * scale);
+        if (b < 0 || a >= extent[k])
+            return false;
+        from[k] = (int) std::max(a, 0.0f);
+        to[k] = (int) std::min(b, (float) (extent[k] - 1));
+    }
+    return true;
+}
+
+void SpatialGrid::within(const PVector &p, float radius, std::vector<int> &result) const
+{
+    result.clear();
+    forEachNeighbor(p, radius, [&result](int i) {
+        result.push_back(i);
+    });
+}
+
+void SpatialGrid::within(const PVectorArray &queries, float radius, std::vector< std::vector<int> > &result) const
+{
+    const float *x = queries.xData();
+    const float *y = queries.yData();
+    const float *z = (queries.is3D() ? queries.zData() : 0);
+    result.resize(queries.size());
+    parallelFor(queries.size(), P_SPATIAL_GRID_QUERY_GRAIN, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+        {
+            float q[3] = { x[i], y[i], z ? z[i] : 0 };
+            std::vector<int> &found = result[i];
+            found.clear();
+            visit(q, radius, [&found](int j) {
+                found.push_back(j);
+            });
+        }
+    });
+}
+
+void SpatialGrid::pairs(float radius, std::vector< std::pair<int, int> > &result) const
+{
+    result.clear();
+    if (!size() || radius < 0)
+        return;
+
+    // Runs of cells go to threads, each keeping its pairs apart so they
+    // join in cell order
+    int reach = (int) std::min(std::ceil(radius * scale),
+                               (float) std::max(std::max(extent[0], extent[1]), extent[2]));
+    int cells = cellCount();
+    int runs = std::max(1, std::min(cells, size() / P_SPATIAL_GRID_QUERY_GRAIN));
+    std::vector< std::vector< std::pair<int, int> > > found(runs);
+    parallelFor(runs, 1, [&](int begin, int end) {
+        for (int r = begin; r < end; r++)
+        {
+            int last = (int) ((long long) cells * (r + 1) / runs);
+            for (int c = (int) ((long long) cells * r / runs); c < last; c++)
+                cellPairs(c, reach, radius * radius, found[r]);
+        }
+    });
+    for (int r = 0; r < runs; r++)
+        result.insert(result.end(), found[r].begin(), found[r].end());
+}
+
+// Pairs within the cell, then with the cells after it: the rest of its
+// row and the rows in front, so every pair of cells is seen once
+void SpatialGrid::cellPairs(int c, int reach, float r2, std::vector< std::pair<int, int> > &result) const
+{
+    int begin = starts[c];
+    int end = starts[c + 1];
+    if (begin == end)
+        return;
+
+    int cx = c % extent[0];
+    int cy = (c / extent[0]) % extent[1];
+    int cz = c / (extent[0] * extent[1]);
+    for (int i = begin; i < end; i++)
+    {
+        float q[3] = { sx[i], sy[i], dims == 3 ? sz[i] : 0 };
+        for (int j = i + 1; j < end; j++)
+            if (dist2(j, q) <= r2)
+                result.push_back(std::make_pair(std::min(order[i], order[j]), std::max(order[i], order[j])));
+    }
+
+    int zReach = (dims == 3 ? reach : 0);
+    for (int dz = 0; dz <= zReach && cz + dz < extent[2]; dz++)
+    {
+        for (int dy = (dz ? -reach : 0); dy <= reach && cy + dy < extent[1]; dy++)
+        {
+            if (cy + dy < 0)
+                continue;
+            int x0 = std::max((dz || dy) ? cx - reach : cx + 1, 0);
+            int x1 = std::min(cx + reach, extent[0] - 1);
+            if (x0 > x1)
+                continue;
+            int row = ((cz + dz) * extent[1] + cy + dy) * extent[0];
+            int from = starts[row + x0];
+            int to = starts[row + x1 + 1];
+            for (int i = begin; i < end; i++)
+            {
+                float q[3] = { sx[i], sy[i], dims == 3 ? sz[i] : 0 };
+                for (int j = from; j < to; j++)
+                    if (dist2(j, q) <= r2)
+                        result.push_back(std::make_pair(std::min(order[i], order[j]), std::max(order[i], order[j])));
+            }
+        }
+    }
+}
+
+PROCESSING_END_NAMESPACE
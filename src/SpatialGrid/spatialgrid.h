@@ -0,0 +1,125 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include "pglobal.h"
+#include "pvector.h"
+#include <utility>
+#include <vector>
+
+// Most cells per point, a larger cell size is taken beyond that
+#define P_SPATIAL_GRID_CELLS 2
+// Queries per thread below which a batch query stays on one thread
+#define P_SPATIAL_GRID_QUERY_GRAIN 1024
+
+PROCESSING_BEGIN_NAMESPACE
+
+/**
+ * Uniform grid over a set of 2D or 3D points for neighbor search and
+ * collision broadphase among particles that all move every frame.
+ *
+ * build() counting-sorts the points by cell in linear time, so the points
+ * of a cell, and of a row of cells, lie next to each other and a query
+ * reads a few short runs of memory. A cell size near the interaction
+ * radius works best, any radius is answered. The grid covers the bounds
+ * of the points, and when that needs more than P_SPATIAL_GRID_CELLS cells
+ * a point the cells are made larger, see cellSize().
+ *
+ * Results are indices into the points as given, and a 2D vector has z 0.
+ */
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(float cellSize);
+    SpatialGrid(float cellSize, const PVectorArray &points);
+
+    void build(const PVectorArray &points);
+    void clear();
+
+    int size() const { return (int) order.size(); }
+    bool is3D() const { return dims == 3; }
+    float cellSize() const { return cell; }
+
+    // Points of cell c are indices()[cellStart(c)] to before cellEnd(c)
+    int cellCount() const { return (int) starts.size() - 1; }
+    int cellOf(const PVector &p) const;
+    int cellStart(int c) const { return starts[c]; }
+    int cellEnd(int c) const { return starts[c + 1]; }
+    const int * indices() const { return order.data(); }
+
+    // Calls fn(index) for every point within radius of p
+    template <class F> void forEachNeighbor(const PVector &p, float radius, F fn) const;
+
+    void within(const PVector &p, float radius, std::vector<int> &result) const;
+    void within(const PVectorArray &queries, float radius, std::vector< std::vector<int> > &result) const;
+
+    // Every pair closer than radius once, the lower index first
+    void pairs(float radius, std::vector< std::pair<int, int> > &result) const;
+
+private:
+    template <class F> void visit(const float *q, float radius, F fn) const;
+    bool cellRange(const float *q, float radius, int *from, int *to) const;
+    void cellPairs(int c, int reach, float r2, std::vector< std::pair<int, int> > &result) const;
+    float dist2(int i, const float *q) const;
+
+    float requested;
+    float cell;
+    float scale;
+    int dims;
+    float low[3];
+    int extent[3];
+    std::vector<int> starts;
+    std::vector<int> order;
+    std::vector<int> keys;
+    std::vector<float> sx;
+    std::vector<float> sy;
+    std::vector<float> sz;
+};
+
+inline float SpatialGrid::dist2(int i, const float *q) const
+{
+    float dx = sx[i] - q[0];
+    float dy = sy[i] - q[1];
+    float d = dx * dx + dy * dy;
+    if (dims == 3)
+    {
+        float dz = sz[i] - q[2];
+        d += dz * dz;
+    }
+    return d;
+}
+
+template <class F>
+void SpatialGrid::forEachNeighbor(const PVector &p, float radius, F fn) const
+{
+    float q[3] = { p.x(), p.y(), p.is3D() ? p.z() : 0.0f };
+    visit(q, radius, fn);
+}
+
+template <class F>
+void SpatialGrid::visit(const float *q, float radius, F fn) const
+{
+    int from[3], to[3];
+    if (!cellRange(q, radius, from, to))
+        return;
+
+    // The cells of a row are one run of points
+    float r2 = radius * radius;
+    for (int z = from[2]; z <= to[2]; z++)
+    {
+        for (int y = from[1]; y <= to[1]; y++)
+        {
+            int row = (z * extent[1] + y) * extent[0];
+            int end = starts[row + to[0] + 1];
+            for (int i = starts[row + from[0]]; i < end; i++)
+                if (dist2(i, q) <= r2)
+                    fn(order[i]);
+        }
+    }
+}
+
+PROCESSING_END_NAMESPACE
+
+#endif // SPATIALGRID_H
@@ -6,12 +6,20 @@ DESTDIR = ../lib
 #CONFIG += debug
 CONFIG -= debug_and_release debug_and_release_target
 
-INCLUDEPATH += PArgs PGlobal PString Exception Processing Mouse GuiEngine QtEngine
+INCLUDEPATH += PArgs PGlobal PStats PString PVector PMatrix PShape PFont ColorRamp FastMath KdTree SpatialGrid Exception Processing Mouse GuiEngine QtEngine
 
 include(PArgs/pargs.pri)
 include(PGlobal/pglobal.pri)
+include(PStats/pstats.pri)
 include(Processing/processing.pri)
 include(PVector/pvector.pri)
+include(PMatrix/pmatrix.pri)
+include(PShape/pshape.pri)
+include(PFont/pfont.pri)
+include(ColorRamp/colorramp.pri)
+include(FastMath/fastmath.pri)
+include(KdTree/kdtree.pri)
+include(SpatialGrid/spatialgrid.pri)
 include(GuiEngine/guiengine.pri)
 include(QtEngine/qtengine.pri)
 
@@ -22,14 +30,30 @@ copy_headers.depends = FORCE
 win32: copy_headers.commands = \
     copy PArgs\\pargs.h ..\\include & \
     copy PGlobal\\pglobal.h ..\\include & \
+    copy PStats\\pstats.h ..\\include & \
     copy PString\\pstring.h ..\\include & \
     copy PVector\\pvector.h ..\\include & \
+    copy PMatrix\\pmatrix.h ..\\include & \
+    copy PShape\\pshape.h ..\\include & \
+    copy PFont\\pfont.h ..\\include & \
+    copy ColorRamp\\colorramp.h ..\\include & \
+    copy FastMath\\fastmath.h ..\\include & \
+    copy KdTree\\kdtree.h ..\\include & \
+    copy SpatialGrid\\spatialgrid.h ..\\include & \
     copy Processing\\processing.h ..\\include
 unix: copy_headers.commands = \
     cp PArgs/pargs.h ../include; \
     cp PGlobal/pglobal.h ../include; \
+    cp PStats/pstats.h ../include; \
     cp PString/pstring.h ../include; \
     cp PVector/pvector.h ../include; \
+    cp PMatrix/pmatrix.h ../include; \
+    cp PShape/pshape.h ../include; \
+    cp PFont/pfont.h ../include; \
+    cp ColorRamp/colorramp.h ../include; \
+    cp FastMath/fastmath.h ../include; \
+    cp KdTree/kdtree.h ../include; \
+    cp SpatialGrid/spatialgrid.h ../include; \
     cp Processing/processing.h ../include
 
 clean.depends = extraclean
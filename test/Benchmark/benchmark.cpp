@@ -0,0 +1,151 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include <QtTest/QtTest>
+#include "qtcanvas.h"
+#include "qtglcanvas.h"
+#include "pshape.h"
+
+using namespace processing;
+
+class Benchmark : public QObject
+{
+    Q_OBJECT
+private slots:
+    void bench_present();
+    void bench_present_scaled();
+    void bench_draw_present();
+    void bench_gl_batch();
+    void bench_cull();
+    void bench_shape();
+
+private:
+    void prepare(QtCanvas &canvas);
+};
+
+void Benchmark::prepare(QtCanvas &canvas)
+{
+    canvas.setFixedSize(800, 600);
+    canvas.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&canvas));
+    canvas.stroke(0);
+    canvas.fill(255);
+    canvas.background(204);
+
+    // The first paint settles the buffer onto the backing store format
+    canvas.repaint();
+}
+
+void Benchmark::bench_present()
+{
+    QtCanvas canvas;
+    prepare(canvas);
+    QBENCHMARK {
+        canvas.repaint();
+    }
+}
+
+void Benchmark::bench_present_scaled()
+{
+    QtCanvas canvas;
+    prepare(canvas);
+    canvas.renderScale(0.5);
+    QBENCHMARK {
+        canvas.repaint();
+    }
+}
+
+void Benchmark::bench_draw_present()
+{
+    QtCanvas canvas;
+    prepare(canvas);
+    QBENCHMARK {
+        canvas.animate();
+        canvas.background(204);
+        for (int i = 0; i < 100; i++)
+            canvas.ellipse(8 * i, 6 * i, 40, 40);
+        canvas.repaint();
+    }
+}
+
+void Benchmark::bench_gl_batch()
+{
+    QtGLCanvas canvas;
+    prepare(canvas);
+    QBENCHMARK {
+        canvas.animate();
+        canvas.background(204);
+        for (int i = 0; i < 1000; i++)
+        {
+            canvas.fill(i % 256, 255 - i % 256, 128, (i % 2 ? 255 : 128));
+            canvas.ellipse(i % 800, (i * 7) % 600, 20, 20);
+            canvas.rect((i * 3) % 800, (i * 11) % 600, 10, 10);
+        }
+    }
+
+    // Opaque shapes collapse into one call per kind and the translucent
+    // ones alternate between two runs at most per shape
+    canvas.animate();
+    QVERIFY(canvas.getStats().primitives >= 4000);
+    QVERIFY(canvas.getStats().drawCalls < canvas.getStats().primitives / 2);
+}
+
+void Benchmark::bench_cull()
+{
+    // A map ten times the size of the canvas, scrolled to one corner
+    QtCanvas canvas;
+    prepare(canvas);
+    QBENCHMARK {
+        canvas.animate();
+        canvas.background(204);
+        canvas.translate(-400, -300);
+        for (int i = 0; i < 1000; i++)
+        {
+            float x = (i % 40) * 80;
+            float y = (i / 40) * 72;
+            canvas.ellipse(x, y, 30, 30);
+            canvas.rect(x + 20, y + 20, 20, 10);
+        }
+    }
+
+    canvas.animate();
+    const PStats &stats = canvas.getStats();
+    QCOMPARE(stats.drawnShapes + stats.culledShapes, 2000);
+    QVERIFY(stats.culledShapes > stats.drawnShapes * 4);
+}
+
+void Benchmark::bench_shape()
+{
+    // One star built once, drawn under a different transform each time
+    PShape star;
+    star.beginShape();
+    for (int i = 0; i < 10; i++)
+    {
+        float r = (i % 2 ? 8 : 20);
+        star.vertex(r * qCos(M_PI * i / 5), r * qSin(M_PI * i / 5));
+    }
+    star.endShape(CLOSE);
+
+    QtGLCanvas canvas;
+    prepare(canvas);
+    QBENCHMARK {
+        canvas.animate();
+        canvas.background(204);
+        for (int i = 0; i < 2000; i++)
+        {
+            canvas.pushMatrix();
+            canvas.translate(20 + (i * 37) % 760, 20 + (i * 53) % 560);
+            canvas.rotate(0.01 * i);
+            canvas.shape(star, 0, 0);
+            canvas.popMatrix();
+        }
+    }
+
+    // Every star lands in the same two runs as the rects and ellipses do
+    canvas.animate();
+    QVERIFY(canvas.getStats().primitives >= 4000);
+    QVERIFY(canvas.getStats().drawCalls < 10);
+}
+
+QTEST_MAIN(Benchmark)
+#include "benchmark.moc"
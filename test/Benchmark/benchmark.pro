@@ -0,0 +1,23 @@
+# Author: Gary Huang <gh.nctu+code@gmail.com>
+
+QT += testlib opengl
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+CONFIG -= debug_and_release debug_and_release_target
+TARGET = Benchmark
+processing_dir = ../..
+LIBS += -L$${processing_dir}/lib -lProcessing
+INCLUDEPATH += $${processing_dir}/include
+
+# The benchmarks drive engine classes directly
+src_dir = $${processing_dir}/src
+INCLUDEPATH += $${src_dir}/PGlobal $${src_dir}/PStats $${src_dir}/GuiEngine $${src_dir}/QtEngine
+
+# Input
+SOURCES += benchmark.cpp
+
+PRE_TARGETDEPS += $${processing_dir}/lib/libProcessing.a
+QMAKE_EXTRA_TARGETS += processing
+
+processing.target = $${processing_dir}/lib/libProcessing.a
+processing.depends = FORCE
+processing.commands = cd $${processing_dir}/src && qmake && make
@@ -0,0 +1,121 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include <QtTest/QtTest>
+#define P_USE_USER_MAIN
+#include <Processing>
+
+using namespace processing;
+
+class TestColorRamp : public QObject
+{
+    Q_OBJECT
+private slots:
+    void test_rgb();
+    void test_hsb();
+    void test_stops();
+    void test_map();
+    void test_errors();
+};
+
+void TestColorRamp::test_rgb()
+{
+    ColorRamp ramp(color(0, 0, 0), color(255, 100, 50, 0));
+    QCOMPARE(ramp.size(), 256);
+    QCOMPARE(ramp.getMode(), RGB);
+    QVERIFY(ramp.get(0) == color(0, 0, 0));
+    QVERIFY(ramp.get(1) == color(255, 100, 50, 0));
+    QVERIFY(ramp.get(-1) == ramp.get(0));
+    QVERIFY(ramp.get(2) == ramp.get(1));
+    QCOMPARE(red(ramp.get(0.2)), 51.0f);
+    QCOMPARE(green(ramp.get(0.2)), 20.0f);
+    QCOMPARE(blue(ramp.get(0.2)), 10.0f);
+    QCOMPARE(alpha(ramp.get(0.2)), 204.0f);
+}
+
+void TestColorRamp::test_hsb()
+{
+    // Red to blue goes the short way round, through magenta
+    ColorRamp ramp(color(255, 0, 0), color(0, 0, 255), 4096, HSB);
+    QCOMPARE(ramp.size(), 4096);
+    QCOMPARE(ramp.data()[0], 0xFFFF0000u);
+    QCOMPARE(ramp.data()[4095], 0xFF0000FFu);
+    QCOMPARE(ramp.get(0.5).argb(), 0xFFFF00FFu);
+
+    // Black keeps the hue and saturation of the other end
+    ColorRamp fade(color(0, 255, 0), color(0), 256, HSB);
+    QCOMPARE(red(fade.get(0.5)), 0.0f);
+    QCOMPARE(blue(fade.get(0.5)), 0.0f);
+    QVERIFY(green(fade.get(0.5)) > 100);
+}
+
+void TestColorRamp::test_stops()
+{
+    ColorRamp ramp(5);
+    QCOMPARE(ramp.data()[2], 0u);
+    ramp.addStop(0.5, color(255));
+    QVERIFY(ramp.get(0) == color(255));
+    QVERIFY(ramp.get(1) == color(255));
+
+    // Two stops at one position make a hard edge
+    ramp.addStop(0.5, color(0));
+    ramp.addStop(0, color(255, 0, 0));
+    ramp.addStop(1, color(0, 0, 255));
+    QCOMPARE(ramp.data()[0], 0xFFFF0000u);
+    QCOMPARE(ramp.data()[2], 0xFF000000u);
+    QCOMPARE(ramp.data()[4], 0xFF0000FFu);
+    QCOMPARE(red(ramp.get(0.25)), 255.0f);
+    QCOMPARE(green(ramp.get(0.25)), 128.0f);
+
+    ramp.clearStops();
+    QCOMPARE(ramp.data()[0], 0u);
+}
+
+void TestColorRamp::test_map()
+{
+    ColorRamp ramp(color(0), color(255));
+    const int n = 100003;
+    std::vector<float> values(n);
+    std::vector<unsigned int> out(n);
+    for (int i = 0; i < n; i++)
+        values[i] = -10 + 20.0f * i / (n - 1);
+    ramp.map(values.data(), n, out.data(), -5, 5);
+    QCOMPARE(out[0], 0xFF000000u);
+    QCOMPARE(out[n / 2], ramp.data()[128]);
+    QCOMPARE(out[n - 1], 0xFFFFFFFFu);
+    for (int i = 1; i < n; i++)
+        QVERIFY(out[i] >= out[i - 1]);
+
+    float odd[5] = { 0, 0.25f, 1, 2, -1 };
+    unsigned int mapped[5];
+    ramp.map(odd, 5, mapped);
+    QCOMPARE(mapped[0], ramp.data()[0]);
+    QCOMPARE(mapped[1], ramp.get(0.25f).argb());
+    QCOMPARE(mapped[2], ramp.data()[255]);
+    QCOMPARE(mapped[3], ramp.data()[255]);
+    QCOMPARE(mapped[4], ramp.data()[0]);
+}
+
+void TestColorRamp::test_errors()
+{
+    bool thrown = false;
+    try {
+        ColorRamp ramp(1);
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+
+    thrown = false;
+    try {
+        float v = 0;
+        unsigned int c;
+        ColorRamp().map(&v, 1, &c, 1, 1);
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+}
+
+QTEST_MAIN(TestColorRamp)
+#include "testcolorramp.moc"
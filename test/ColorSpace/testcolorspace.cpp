@@ -0,0 +1,125 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include <QtTest/QtTest>
+#define P_USE_USER_MAIN
+#include <Processing>
+#include "colorspace.h"
+#include <cstdlib>
+#include <vector>
+
+using namespace processing;
+
+class TestColorSpace : public QObject
+{
+    Q_OBJECT
+private slots:
+    void test_rgb();
+    void test_hsb();
+    void test_roundTrip();
+    void test_arrays();
+};
+
+// Every channel within one step of the other color's
+static bool near(unsigned int a, unsigned int b)
+{
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int d = (int) ((a >> shift) & 0xFF) - (int) ((b >> shift) & 0xFF);
+        if (d < -1 || d > 1)
+            return false;
+    }
+    return true;
+}
+
+void TestColorSpace::test_rgb()
+{
+    ColorSpace colors;
+    QCOMPARE(colors.mode(), RGB);
+    QCOMPARE(colors.toARGB(255, 128, 0, 255), 0xFFFF8000u);
+    QCOMPARE(colors.toARGB(-10, 300, 12, 1000), 0xFF00FF0Cu);
+
+    colors.setMode(RGB, 1, 1, 1, 1);
+    QCOMPARE(colors.toARGB(1, 0.5, 0, 0.5), 0x80FF8000u);
+}
+
+void TestColorSpace::test_hsb()
+{
+    ColorSpace colors;
+    colors.setMode(HSB, 360, 100, 100, 255);
+    QCOMPARE(colors.toARGB(0, 100, 100, 255), 0xFFFF0000u);
+    QCOMPARE(colors.toARGB(120, 100, 100, 255), 0xFF00FF00u);
+    QCOMPARE(colors.toARGB(240, 100, 100, 255), 0xFF0000FFu);
+    QCOMPARE(colors.toARGB(60, 100, 100, 255), 0xFFFFFF00u);
+
+    // All the way round is red again
+    QCOMPARE(colors.toARGB(360, 100, 100, 255), 0xFFFF0000u);
+    QCOMPARE(colors.toARGB(200, 0, 50, 255), 0xFF808080u);
+    QCOMPARE(colors.toARGB(200, 100, 0, 255), 0xFF000000u);
+
+    // setMode() keeping the ranges
+    colors.setMode(RGB);
+    QCOMPARE(colors.toARGB(360, 50, 100, 255), 0xFFFF80FFu);
+}
+
+void TestColorSpace::test_roundTrip()
+{
+    ColorSpace colors;
+    colors.setMode(HSB, 360, 100, 100, 255);
+    std::srand(43);
+    for (int i = 0; i < 10000; i++)
+    {
+        unsigned int argb = 0xFF000000u | ((unsigned int) std::rand() & 0xFFFFFF);
+        float hsb[3];
+        colors.toHSB(argb, hsb);
+        QVERIFY(hsb[0] >= 0 && hsb[0] < 360);
+        QVERIFY(hsb[1] >= 0 && hsb[1] <= 100);
+        QVERIFY(hsb[2] >= 0 && hsb[2] <= 100);
+        QVERIFY(near(colors.toARGB(hsb[0], hsb[1], hsb[2], 255), argb));
+    }
+
+    // The ranges scale the values whatever the mode is
+    colors.setMode(RGB, 1, 2, 4, 255);
+    float hsb[3];
+    colors.toHSB(0xFF00FF00u, hsb);
+    QCOMPARE(hsb[0], 1.0f / 3);
+    QCOMPARE(hsb[1], 2.0f);
+    QCOMPARE(hsb[2], 4.0f);
+}
+
+void TestColorSpace::test_arrays()
+{
+    // Counts that leave a tail after the groups of four, values beyond
+    // the ranges on either side
+    ColorSpace colors;
+    std::srand(7);
+    for (int mode = 0; mode < 2; mode++)
+    {
+        if (mode)
+            colors.setMode(HSB, 360, 100, 100, 1);
+        for (int channels = 3; channels <= 4; channels++)
+        {
+            for (int count = 1; count <= 11; count += 3)
+            {
+                std::vector<float> values(count * channels);
+                for (size_t k = 0; k < values.size(); k++)
+                    values[k] = std::rand() % 4200 / 10.0f - 20;
+                if (channels == 4)
+                    for (int i = 0; i < count; i++)
+                        values[i * 4 + 3] = std::rand() % 120 / 100.0f - 0.1f;
+
+                std::vector<unsigned int> out(count);
+                colors.toARGB(values.data(), channels, count, out.data());
+                for (int i = 0; i < count; i++)
+                {
+                    const float *v = &values[i * channels];
+                    float a = (channels == 4 ? v[3] : (mode ? 1 : 255));
+                    QCOMPARE(out[i], colors.toARGB(v[0], v[1], v[2], a));
+                }
+            }
+        }
+    }
+}
+
+QTEST_MAIN(TestColorSpace)
+#include "testcolorspace.moc"
@@ -0,0 +1,97 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include <QtTest/QtTest>
+#define P_USE_USER_MAIN
+#include <Processing>
+
+using namespace processing;
+
+class TestFastMath : public QObject
+{
+    Q_OBJECT
+private slots:
+    void test_sinCos();
+    void test_table();
+    void test_atan2();
+    void test_arrays();
+};
+
+void TestFastMath::test_sinCos()
+{
+    for (int i = -20000; i <= 20000; i++)
+    {
+        float x = i * 0.5f;
+        QVERIFY(std::fabs(fastSin(x) - std::sin((double) x)) < 1e-7);
+        QVERIFY(std::fabs(fastCos(x) - std::cos((double) x)) < 1e-7);
+    }
+    QCOMPARE(fastSin(0), 0.0f);
+    QCOMPARE(fastCos(0), 1.0f);
+    float s, c;
+    fastSinCos(1, s, c);
+    QCOMPARE(s, fastSin(1));
+    QCOMPARE(c, fastCos(1));
+}
+
+void TestFastMath::test_table()
+{
+    for (int i = -1000; i <= 1000; i++)
+    {
+        float x = i * 0.01f;
+        QVERIFY(std::fabs(tableSin(x) - std::sin((double) x)) < 1e-6);
+        QVERIFY(std::fabs(tableCos(x) - std::cos((double) x)) < 1e-6);
+    }
+
+    // The bound stated past 10, up to 1000
+    for (int i = -100000; i <= 100000; i++)
+    {
+        float x = i * 0.01f + 0.003f;
+        double bound = 1.5e-7 * std::max(std::fabs(x), 10.0f);
+        QVERIFY(std::fabs(tableSin(x) - std::sin((double) x)) < bound);
+        QVERIFY(std::fabs(tableCos(x) - std::cos((double) x)) < bound);
+    }
+}
+
+void TestFastMath::test_atan2()
+{
+    for (int i = 0; i < 3600; i++)
+    {
+        float a = i * (float) (TWO_PI / 3600);
+        for (float r = 0.001f; r < 2000; r *= 10)
+        {
+            float y = r * std::sin(a);
+            float x = r * std::cos(a);
+            QVERIFY(std::fabs(fastAtan2(y, x) - std::atan2((double) y, (double) x)) < 2e-6);
+        }
+    }
+    QCOMPARE(fastAtan2(0, 0), 0.0f);
+    QCOMPARE(fastAtan2(0, -1), (float) PI);
+    QCOMPARE(fastAtan2(-1, 0), (float) -HALF_PI);
+}
+
+void TestFastMath::test_arrays()
+{
+    // Every length around the width of a vector, the same values as one
+    // at a time
+    float x[11], y[11], out[11];
+    for (int i = 0; i < 11; i++)
+    {
+        x[i] = i * 1.7f - 9;
+        y[i] = 4 - i * 0.9f;
+    }
+    for (int n = 0; n <= 11; n++)
+    {
+        fastSin(x, out, n);
+        for (int i = 0; i < n; i++)
+            QCOMPARE(out[i], fastSin(x[i]));
+        fastCos(x, out, n);
+        for (int i = 0; i < n; i++)
+            QCOMPARE(out[i], fastCos(x[i]));
+        fastAtan2(y, x, out, n);
+        for (int i = 0; i < n; i++)
+            QCOMPARE(out[i], fastAtan2(y[i], x[i]));
+    }
+}
+
+QTEST_MAIN(TestFastMath)
+#include "testfastmath.moc"
@@ -0,0 +1,207 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include <QtTest/QtTest>
+#define P_USE_USER_MAIN
+#include <Processing>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace processing;
+
+class TestKdTree : public QObject
+{
+    Q_OBJECT
+private slots:
+    void test_nearest();
+    void test_within();
+    void test_update();
+    void test_batch();
+    void test_empty();
+};
+
+// Tight clusters over 0 to 100 where the median split meets runs of equal
+// values: every fifth point sits on its cluster's center, every fifth
+// after that shares the center's x, the rest are a few units off it
+static PVectorArray clustered(int count, PVector::Type type)
+{
+    std::srand(count);
+    PVectorArray points(count, type);
+    for (int i = 0; i < count; i++)
+    {
+        int c = std::rand() % 8;
+        float center[3] = { 10 + c * 11.0f, 10 + (c * 3 % 8) * 11.0f, 10 + (c * 5 % 8) * 11.0f };
+        float p[3];
+        for (int k = 0; k < 3; k++)
+            p[k] = center[k] + (i % 5 == 0 || (i % 5 == 1 && k == 0) ? 0 : std::rand() % 600 / 100.0f - 3);
+        if (type == PVector::V3D)
+            points.set(i, p[0], p[1], p[2]);
+        else
+            points.set(i, p[0], p[1]);
+    }
+    return points;
+}
+
+static float dist2(const PVectorArray &points, int i, const PVector &p)
+{
+    float dx = points.x(i) - p.x();
+    float dy = points.y(i) - p.y();
+    float dz = (points.is3D() ? points.z(i) - p.z() : 0);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Distances of the k nearest by comparing every point
+static std::vector<float> bruteNearest(const PVectorArray &points, const PVector &p, int k)
+{
+    std::vector<float> d;
+    for (int i = 0; i < points.size(); i++)
+        d.push_back(dist2(points, i, p));
+    std::sort(d.begin(), d.end());
+    d.resize(std::min(k, points.size()));
+    return d;
+}
+
+static int bruteWithin(const PVectorArray &points, const PVector &p, float radius)
+{
+    int count = 0;
+    for (int i = 0; i < points.size(); i++)
+        count += (dist2(points, i, p) <= radius * radius);
+    return count;
+}
+
+void TestKdTree::test_nearest()
+{
+    PVectorArray points = clustered(2000, PVector::V2D);
+    KdTree tree(points);
+    QCOMPARE(tree.size(), 2000);
+    QVERIFY(!tree.is3D());
+    // Point 120 has copies on its cluster's center, any of them will do
+    QCOMPARE(dist2(points, tree.nearest(points.get(123)), points.get(123)), 0.0f);
+    QCOMPARE(dist2(points, tree.nearest(points.get(120)), points.get(120)), 0.0f);
+
+    std::vector<int> result;
+    for (int i = 0; i < 50; i++)
+    {
+        PVector p(i * 2.1f, 100 - i * 1.7f);
+        tree.nearest(p, 7, result);
+        std::vector<float> expected = bruteNearest(points, p, 7);
+        QCOMPARE((int) result.size(), 7);
+        for (int j = 0; j < 7; j++)
+            QCOMPARE(dist2(points, result[j], p), expected[j]);
+    }
+
+    std::vector<PVector> few;
+    few.push_back(PVector(0.0, 0.0));
+    few.push_back(PVector(5.0, 5.0));
+    few.push_back(PVector(1.0, 1.0));
+    KdTree small(few);
+    small.nearest(PVector(4.0, 4.0), 5, result);
+    QCOMPARE((int) result.size(), 3);
+    QCOMPARE(result[0], 1);
+    QCOMPARE(result[1], 2);
+    QCOMPARE(result[2], 0);
+}
+
+void TestKdTree::test_within()
+{
+    PVectorArray points = clustered(3000, PVector::V3D);
+    KdTree tree(points);
+    QVERIFY(tree.is3D());
+    std::vector<int> result;
+    for (int i = 0; i < 30; i++)
+    {
+        PVector p(i * 3.0f, 50, 100 - i * 3.0f);
+        float radius = 2.0f + i;
+        tree.within(p, radius, result);
+        QCOMPARE((int) result.size(), bruteWithin(points, p, radius));
+        for (size_t j = 0; j < result.size(); j++)
+            QVERIFY(dist2(points, result[j], p) <= radius * radius);
+    }
+
+    // Everything is inside a large enough circle
+    tree.within(PVector(50.0, 50.0, 50.0), 1000, result);
+    std::sort(result.begin(), result.end());
+    QCOMPARE((int) result.size(), 3000);
+    QCOMPARE(result[2999], 2999);
+}
+
+void TestKdTree::test_update()
+{
+    PVectorArray points = clustered(5000, PVector::V2D);
+    KdTree tree(points);
+    PVectorArray velocity = clustered(5000, PVector::V2D);
+    points += velocity * 0.1f - PVector(5.0, 5.0);
+    tree.update(points);
+    QCOMPARE(tree.size(), 5000);
+
+    std::vector<int> result;
+    for (int i = 0; i < 20; i++)
+    {
+        PVector p(i * 5.0f, i * 4.0f);
+        tree.nearest(p, 3, result);
+        std::vector<float> expected = bruteNearest(points, p, 3);
+        for (int j = 0; j < 3; j++)
+            QCOMPARE(dist2(points, result[j], p), expected[j]);
+        tree.within(p, 4, result);
+        QCOMPARE((int) result.size(), bruteWithin(points, p, 4));
+    }
+
+    // A different count builds again
+    tree.update(clustered(10, PVector::V3D));
+    QCOMPARE(tree.size(), 10);
+    QVERIFY(tree.is3D());
+}
+
+void TestKdTree::test_batch()
+{
+    PVectorArray points = clustered(20000, PVector::V3D);
+    KdTree tree(points);
+    const int k = 4;
+    std::vector<int> neighbors(points.size() * k);
+    tree.nearest(points, k, neighbors.data());
+    std::vector<int> result;
+    for (int i = 0; i < points.size(); i += 997)
+    {
+        tree.nearest(points.get(i), k, result);
+        for (int j = 0; j < k; j++)
+            QCOMPARE(neighbors[i * k + j], result[j]);
+    }
+
+    std::vector< std::vector<int> > near;
+    tree.within(points, 3, near);
+    QCOMPARE((int) near.size(), 20000);
+    for (int i = 0; i < points.size(); i += 997)
+    {
+        tree.within(points.get(i), 3, result);
+        QVERIFY(near[i] == result);
+    }
+}
+
+void TestKdTree::test_empty()
+{
+    KdTree tree;
+    QCOMPARE(tree.size(), 0);
+    QCOMPARE(tree.nearest(PVector(1.0, 2.0)), -1);
+    std::vector<int> result(3);
+    tree.within(PVector(1.0, 2.0), 10, result);
+    QVERIFY(result.empty());
+    int neighbors[2];
+    PVectorArray queries(1);
+    tree.nearest(queries, 2, neighbors);
+    QCOMPARE(neighbors[1], -1);
+
+    tree.build(clustered(100, PVector::V2D));
+    tree.clear();
+    QCOMPARE(tree.size(), 0);
+
+    bool thrown = false;
+    try {
+        tree.nearest(PVector(1.0, 2.0), 0, result);
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+}
+
+QTEST_MAIN(TestKdTree)
+#include "testkdtree.moc"
@@ -0,0 +1,52 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include <QtTest/QtTest>
+#define P_USE_USER_MAIN
+#include <Processing>
+
+using namespace processing;
+
+class TestPFont : public QObject
+{
+    Q_OBJECT
+private slots:
+    void test_default();
+    void test_createFont();
+    void test_errors();
+};
+
+void TestPFont::test_default()
+{
+    PFont font;
+    QVERIFY(font.getName().empty());
+    QCOMPARE(font.getSize(), 12.0f);
+    QVERIFY(font.isSmooth());
+}
+
+void TestPFont::test_createFont()
+{
+    PFont a = createFont("Courier", 16);
+    QCOMPARE(a.getName(), std::string("Courier"));
+    QCOMPARE(a.getSize(), 16.0f);
+    QVERIFY(a.isSmooth());
+
+    PFont b = createFont("Courier", 16, false);
+    QVERIFY(!b.isSmooth());
+    QVERIFY(a != b);
+    QVERIFY(a == createFont("Courier", 16));
+}
+
+void TestPFont::test_errors()
+{
+    bool thrown = false;
+    try {
+        createFont("Courier", 0);
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+}
+
+QTEST_MAIN(TestPFont)
+#include "testpfont.moc"
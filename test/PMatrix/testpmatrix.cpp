@@ -0,0 +1,296 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include <QtTest/QtTest>
+#define P_USE_USER_MAIN
+#include <Processing>
+
+using namespace processing;
+
+class TestPMatrix : public QObject
+{
+    Q_OBJECT
+private slots:
+    void test_translate();
+    void test_rotate();
+    void test_scale();
+    void test_apply();
+    void test_preApply();
+    void test_invert();
+    void test_mult();
+    void test_rotate3D();
+    void test_invert3D();
+    void test_mult3D();
+    void test_multArray();
+    void test_quaternion();
+    void test_slerp();
+};
+
+static bool fuzzyEqual(const PMatrix3D &a, const PMatrix3D &b)
+{
+    float x[16], y[16];
+    a.get(x);
+    b.get(y);
+    for (int i = 0; i < 16; i++)
+        if (qAbs(x[i] - y[i]) > 1e-5)
+            return false;
+    return true;
+}
+
+void TestPMatrix::test_translate()
+{
+    PMatrix2D m;
+    m.translate(10, 20);
+    QCOMPARE(m.multX(1, 2), 11.0f);
+    QCOMPARE(m.multY(1, 2), 22.0f);
+
+    m.scale(2);
+    m.translate(1, 1);
+    QCOMPARE(m.multX(0, 0), 12.0f);
+    QCOMPARE(m.multY(0, 0), 22.0f);
+}
+
+void TestPMatrix::test_rotate()
+{
+    PMatrix2D m;
+    m.rotate(HALF_PI);
+    QVERIFY(qAbs(m.multX(1, 0)) < 1e-6);
+    QCOMPARE(m.multY(1, 0), 1.0f);
+    QCOMPARE(m.multX(0, 1), -1.0f);
+}
+
+void TestPMatrix::test_scale()
+{
+    PMatrix2D m;
+    m.scale(2, 3);
+    QCOMPARE(m.multX(4, 5), 8.0f);
+    QCOMPARE(m.multY(4, 5), 15.0f);
+    QCOMPARE(m.determinant(), 6.0f);
+    QVERIFY(m.isAxisAligned());
+    m.rotate(0.5);
+    QVERIFY(!m.isAxisAligned());
+}
+
+void TestPMatrix::test_apply()
+{
+    PMatrix2D a;
+    a.translate(5, 0);
+    a.apply(PMatrix2D(2, 0, 0, 0, 2, 0));
+
+    PMatrix2D b;
+    b.translate(5, 0);
+    b.scale(2);
+    QVERIFY(a == b);
+}
+
+void TestPMatrix::test_preApply()
+{
+    // Applied in front, the translation is not scaled
+    PMatrix2D m;
+    m.scale(2);
+    m.preApply(PMatrix2D(1, 0, 5, 0, 1, 7));
+    QCOMPARE(m.multX(1, 1), 7.0f);
+    QCOMPARE(m.multY(1, 1), 9.0f);
+}
+
+void TestPMatrix::test_invert()
+{
+    PMatrix2D m;
+    m.translate(10, -4);
+    m.rotate(0.7);
+    m.scale(3, 0.5);
+    PMatrix2D inverse = m;
+    QVERIFY(inverse.invert());
+    float x = m.multX(2, 3), y = m.multY(2, 3);
+    QVERIFY(qAbs(inverse.multX(x, y) - 2) < 1e-5);
+    QVERIFY(qAbs(inverse.multY(x, y) - 3) < 1e-5);
+
+    PMatrix2D singular(1, 2, 0, 2, 4, 0);
+    QVERIFY(!singular.invert());
+}
+
+void TestPMatrix::test_mult()
+{
+    PMatrix2D m;
+    m.translate(1, 2);
+    m.rotate(0.3);
+    float points[8] = { 0, 0, 1, 0, 0, 1, 3, 4 };
+    float mapped[8];
+    m.mult(points, mapped, 4);
+    for (int i = 0; i < 4; i++)
+    {
+        QCOMPARE(mapped[2 * i], m.multX(points[2 * i], points[2 * i + 1]));
+        QCOMPARE(mapped[2 * i + 1], m.multY(points[2 * i], points[2 * i + 1]));
+    }
+
+    PVector v = m.mult(PVector(3, 4));
+    QCOMPARE(v.x(), mapped[6]);
+    QCOMPARE(v.y(), mapped[7]);
+}
+
+void TestPMatrix::test_rotate3D()
+{
+    PMatrix3D a;
+    a.rotate(0.4, 0, 0, 1);
+    PMatrix3D b;
+    b.rotateZ(0.4);
+    QVERIFY(fuzzyEqual(a, b));
+
+    PMatrix3D c(PMatrix2D(1, 0, 0, 0, 1, 0));
+    c.rotate(0.4);
+    QVERIFY(fuzzyEqual(b, c));
+
+    PMatrix3D x;
+    x.rotateX(HALF_PI);
+    QVERIFY(qAbs(x.multY(0, 1, 0)) < 1e-6);
+    QCOMPARE(x.multZ(0, 1, 0), 1.0f);
+}
+
+void TestPMatrix::test_invert3D()
+{
+    PMatrix3D m;
+    m.translate(1, 2, 3);
+    m.rotateY(0.3);
+    m.rotate(0.7, 1, 1, 0);
+    m.scale(2, 3, 4);
+    QVERIFY(qAbs(m.determinant() - 24) < 1e-4);
+
+    PMatrix3D inverse = m;
+    QVERIFY(inverse.invert());
+    PMatrix3D product = m;
+    product.apply(inverse);
+    QVERIFY(fuzzyEqual(product, PMatrix3D()));
+
+    // Not affine, through the full cofactors
+    PMatrix3D projective = m;
+    projective.m30 = 0.5;
+    inverse = projective;
+    QVERIFY(inverse.invert());
+    product = projective;
+    product.apply(inverse);
+    QVERIFY(fuzzyEqual(product, PMatrix3D()));
+
+    PMatrix3D transposed = m;
+    transposed.transpose();
+    transposed.transpose();
+    QVERIFY(transposed == m);
+}
+
+void TestPMatrix::test_mult3D()
+{
+    PMatrix3D m;
+    m.translate(1, 2, 3);
+    m.rotateX(0.5);
+    m.scale(2);
+    float points[9] = { 1, 2, 3, -1, 0, 4, 0, 0, 0 };
+    float mapped[9];
+    m.mult(points, mapped, 3);
+    for (int i = 0; i < 3; i++)
+    {
+        const float *p = points + 3 * i;
+        QCOMPARE(mapped[3 * i], m.multX(p[0], p[1], p[2]));
+        QCOMPARE(mapped[3 * i + 1], m.multY(p[0], p[1], p[2]));
+        QCOMPARE(mapped[3 * i + 2], m.multZ(p[0], p[1], p[2]));
+    }
+
+    // In place
+    m.mult(points, points, 3);
+    for (int i = 0; i < 9; i++)
+        QCOMPARE(points[i], mapped[i]);
+}
+
+void TestPMatrix::test_multArray()
+{
+    PVectorArray points(7);
+    for (int i = 0; i < points.size(); i++)
+        points.set(i, i, 2 * i);
+
+    PMatrix2D m;
+    m.translate(10, 20);
+    m.rotate(0.3);
+    PVectorArray mapped;
+    m.mult(points, mapped);
+    QCOMPARE(mapped.size(), 7);
+    for (int i = 0; i < points.size(); i++)
+    {
+        QCOMPARE(mapped.x(i), m.multX(points.x(i), points.y(i)));
+        QCOMPARE(mapped.y(i), m.multY(points.x(i), points.y(i)));
+    }
+
+    // 2D points come out 3D, in place
+    PMatrix3D m3;
+    m3.translate(1, 2, 3);
+    m3.rotateX(0.5);
+    m3.mult(points, points);
+    QVERIFY(points.is3D());
+    for (int i = 0; i < points.size(); i++)
+    {
+        QCOMPARE(points.x(i), m3.multX(i, 2 * i, 0));
+        QCOMPARE(points.y(i), m3.multY(i, 2 * i, 0));
+        QCOMPARE(points.z(i), m3.multZ(i, 2 * i, 0));
+    }
+}
+
+void TestPMatrix::test_quaternion()
+{
+    PQuaternion q = PQuaternion::fromAxisAngle(HALF_PI, 0, 0, 2);
+    PVector v = q.rotate(PVector(1.0, 0.0, 0.0));
+    QVERIFY(qAbs(v.x()) < 1e-6);
+    QVERIFY(qAbs(v.y() - 1) < 1e-6);
+
+    PMatrix3D m;
+    m.rotate(0.7, 1, 2, 3);
+    PQuaternion r = PQuaternion::fromAxisAngle(0.7, PVector(1.0, 2.0, 3.0));
+    QVERIFY(fuzzyEqual(r.toMatrix(), m));
+    PQuaternion back = PQuaternion::fromMatrix(m);
+    QVERIFY(qAbs(qAbs(back.dot(r)) - 1) < 1e-6);
+
+    // Composition matches the matrices, the right one first
+    PQuaternion s = PQuaternion::fromAxisAngle(-1.2, 0, 1, 0);
+    PMatrix3D ms = m;
+    ms.rotateY(-1.2);
+    QVERIFY(fuzzyEqual((r * s).toMatrix(), ms));
+    PQuaternion t = r;
+    t.mult(s);
+    QVERIFY(t == r * s);
+    t = s;
+    t.preMult(r);
+    QVERIFY(t == r * s);
+
+    PQuaternion inverse = r;
+    QVERIFY(inverse.invert());
+    QVERIFY(fuzzyEqual((r * inverse).toMatrix(), PMatrix3D()));
+    QVERIFY(!PQuaternion(0, 0, 0, 0).invert());
+
+    PVectorArray points(5, PVector::V3D);
+    for (int i = 0; i < points.size(); i++)
+        points.set(i, i, 1, -i);
+    PVectorArray turned;
+    r.rotate(points, turned);
+    PVector p = r.rotate(points.get(3));
+    QVERIFY(qAbs(turned.x(3) - p.x()) < 1e-5);
+    QVERIFY(qAbs(turned.y(3) - p.y()) < 1e-5);
+    QVERIFY(qAbs(turned.z(3) - p.z()) < 1e-5);
+}
+
+void TestPMatrix::test_slerp()
+{
+    PQuaternion a;
+    PQuaternion b = PQuaternion::fromAxisAngle(2, 0, 0, 1);
+    PQuaternion half = PQuaternion::slerp(a, b, 0.5);
+    PQuaternion expected = PQuaternion::fromAxisAngle(1, 0, 0, 1);
+    QVERIFY(qAbs(half.dot(expected) - 1) < 1e-6);
+    QVERIFY(qAbs(half.mag() - 1) < 1e-6);
+    QVERIFY(qAbs(PQuaternion::slerp(a, b, 1).dot(b) - 1) < 1e-6);
+
+    // -b is the same rotation, the result takes the short way still
+    PQuaternion minus(-b.x, -b.y, -b.z, -b.w);
+    QVERIFY(qAbs(qAbs(PQuaternion::slerp(a, minus, 0.5).dot(expected)) - 1) < 1e-6);
+
+    PQuaternion c = a;
+    c.slerp(a, 0.3);
+    QVERIFY(qAbs(c.dot(a) - 1) < 1e-6);
+}
+
+QTEST_MAIN(TestPMatrix)
+#include "testpmatrix.moc"
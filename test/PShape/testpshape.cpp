@@ -0,0 +1,135 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include <QtTest/QtTest>
+#define P_USE_USER_MAIN
+#include <Processing>
+
+using namespace processing;
+
+class TestPShape : public QObject
+{
+    Q_OBJECT
+private slots:
+    void test_vertices();
+    void test_size();
+    void test_cacheKey();
+    void test_matrix();
+    void test_errors();
+};
+
+void TestPShape::test_vertices()
+{
+    PShape s = createShape();
+    QCOMPARE(s.getFamily(), PATH);
+    s.beginShape(TRIANGLES);
+    s.vertex(0, 0);
+    s.vertex(10, 0);
+    s.vertex(5, 8);
+    s.endShape(CLOSE);
+    QCOMPARE(s.getKind(), TRIANGLES);
+    QCOMPARE(s.getEndMode(), CLOSE);
+    QCOMPARE(s.getVertexCount(), 3);
+    QCOMPARE(s.getVertex(2).x(), 5.0f);
+    QCOMPARE(s.getVertex(2).y(), 8.0f);
+
+    s.setVertex(1, 12, -2);
+    QCOMPARE(s.getVertex(1).x(), 12.0f);
+    QCOMPARE(s.getVertex(1).y(), -2.0f);
+}
+
+void TestPShape::test_size()
+{
+    PShape s = createShape();
+    s.beginShape();
+    s.vertex(-5, 2);
+    s.vertex(15, 2);
+    s.vertex(0, 32);
+    s.endShape();
+    QCOMPARE(s.getWidth(), 20.0f);
+    QCOMPARE(s.getHeight(), 30.0f);
+
+    PShape r = createShape(RECT, 10, 10, -40, 30);
+    QCOMPARE(r.getWidth(), 40.0f);
+    QCOMPARE(r.getHeight(), 30.0f);
+
+    PShape q = createShape(QUAD, 0, 0, 4, 1, 5, 6, -1, 3);
+    QCOMPARE(q.getWidth(), 6.0f);
+    QCOMPARE(q.getHeight(), 6.0f);
+}
+
+void TestPShape::test_cacheKey()
+{
+    // Primitives with the same parameters share their geometry
+    PShape a = createShape(RECT, 0, 0, 50, 20, 4);
+    PShape b = createShape(RECT, 0, 0, 50, 20, 4);
+    PShape c = createShape(RECT, 0, 0, 50, 20, 5);
+    QCOMPARE(a.cacheKey(), b.cacheKey());
+    QVERIFY(a.cacheKey() != c.cacheKey());
+    PShape open = createShape(ARC, 0, 0, 10, 10, 0, HALF_PI, OPEN);
+    PShape pie = createShape(ARC, 0, 0, 10, 10, 0, HALF_PI, PIE);
+    QVERIFY(open.cacheKey() != pie.cacheKey());
+
+    // Paths get a new key whenever their vertices change
+    PShape s = createShape();
+    s.beginShape();
+    s.vertex(0, 0);
+    s.vertex(1, 1);
+    s.endShape();
+    unsigned long long key = s.cacheKey();
+    PShape copy = s;
+    QCOMPARE(copy.cacheKey(), key);
+    s.setVertex(0, 2, 2);
+    QVERIFY(s.cacheKey() != key);
+    QCOMPARE(copy.cacheKey(), key);
+
+    // The matrix is not part of the geometry
+    key = s.cacheKey();
+    s.translate(10, 10);
+    s.rotate(0.5);
+    QCOMPARE(s.cacheKey(), key);
+}
+
+void TestPShape::test_matrix()
+{
+    PShape s = createShape(ELLIPSE, 0, 0, 10, 10);
+    QVERIFY(s.getMatrix().isIdentity());
+    s.translate(5, 6);
+    s.scale(2);
+    QCOMPARE(s.getMatrix().multX(1, 1), 7.0f);
+    QCOMPARE(s.getMatrix().multY(1, 1), 8.0f);
+    s.resetMatrix();
+    QVERIFY(s.getMatrix().isIdentity());
+}
+
+void TestPShape::test_errors()
+{
+    bool thrown = false;
+    try {
+        createShape(ELLIPSE, 0, 0, 10, 10, 2);
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+
+    thrown = false;
+    try {
+        PShape s = createShape();
+        s.vertex(0, 0);
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+
+    thrown = false;
+    try {
+        PShape r = createShape(RECT, 0, 0, 10, 10);
+        r.beginShape();
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+}
+
+QTEST_MAIN(TestPShape)
+#include "testpshape.moc"
@@ -29,9 +29,12 @@ private slots:
     void test_setMag();
     void test_heading();
     void test_rotate();
+    void test_fastTrig();
     void test_lerp();
     void test_angleBetween();
     void test_array();
+    void test_operators();
+    void test_vectorArray();
 };
 
 void TestPVector::test_set()
@@ -319,6 +322,21 @@ void TestPVector::test_rotate()
     QCOMPARE(v2.z(), 0.0f);
 }
 
+void TestPVector::test_fastTrig()
+{
+    QVERIFY(!PVector::isFastTrig());
+    PVector::setFastTrig(true);
+    QVERIFY(PVector::isFastTrig());
+    PVector v = PVector::fromAngle(0.01);
+    QCOMPARE(v.x(), 0.99995f);
+    QCOMPARE(v.y(), 0.009999833f);
+    PVector r = PVector(10.0, 20.0);
+    r.rotate(HALF_PI);
+    QCOMPARE(r.x(), -20.0f);
+    QVERIFY(std::fabs(r.y() - 10) < 1e-5);
+    PVector::setFastTrig(false);
+}
+
 void TestPVector::test_lerp()
 {
     // Interface 1
@@ -345,5 +363,124 @@ void TestPVector::test_array()
     QCOMPARE(f[2], 30.0f);
 }
 
+void TestPVector::test_operators()
+{
+    PVector a(1.0, 2.0, 3.0);
+    PVector b(4.0, 5.0, 6.0);
+    PVector c = a + b * 2 - a / 2;
+    QCOMPARE(c.x(), 8.5f);
+    QCOMPARE(c.y(), 11.0f);
+    QCOMPARE(c.z(), 13.5f);
+
+    // Storing into a shared vector leaves the others alone
+    PVector shared = c;
+    c = -a;
+    QVERIFY(c != shared);
+    QCOMPARE(shared.x(), 8.5f);
+    PVector d = c;
+    c = 0.5 * (a + b);
+    QVERIFY(c != shared);
+    c += a;
+    QCOMPARE(c.x(), 3.5f);
+    QCOMPARE(c.z(), 7.5f);
+    PVector e = c;
+    c = c - b;
+    QCOMPARE(c.y(), 0.5f);
+    QCOMPARE(e.y(), 5.5f);
+    c -= b - a;
+    c *= 2;
+    c /= 4;
+    QCOMPARE(c.x(), -1.75f);
+    QCOMPARE(d.x(), -1.0f);
+
+    bool thrown = false;
+    try {
+        PVector f = a + PVector(1.0, 2.0);
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+}
+
+void TestPVector::test_vectorArray()
+{
+    PVectorArray position(1001);
+    PVectorArray velocity(1001);
+    QCOMPARE(position.size(), 1001);
+    QVERIFY(position.is2D());
+    for (int i = 0; i < velocity.size(); i++)
+        velocity.set(i, i, -i);
+
+    PVector gravity(0.0, 10.0);
+    position += velocity * 0.5 + gravity;
+    QCOMPARE(position.x(1000), 500.0f);
+    QCOMPARE(position.y(1000), -490.0f);
+    QCOMPARE(position.get(0).y(), 10.0f);
+
+    PVectorArray next = position - velocity;
+    QCOMPARE(next.size(), 1001);
+    QCOMPARE(next.x(10), -5.0f);
+    position = gravity;
+    QCOMPARE(position.y(7), 10.0f);
+    position *= 3;
+    position /= 2;
+    QCOMPARE(position.y(7), 15.0f);
+
+    PVectorArray space(2, PVector::V3D);
+    space.set(1, PVector(1.0, 2.0, 3.0));
+    space -= -space;
+    QCOMPARE(space.zData()[1], 6.0f);
+
+    bool thrown = false;
+    try {
+        space += position;
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+
+    thrown = false;
+    try {
+        PVector v = velocity + velocity;
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+
+    thrown = false;
+    try {
+        next += PVectorArray(5);
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+
+    // An empty array is not a vector applied to every element
+    PVectorArray five(5);
+    const char *errors[3] = { 0, 0, 0 };
+    try {
+        five += PVectorArray();
+    } catch (const char *e) {
+        errors[0] = e;
+    }
+    try {
+        PVectorArray sum = five + PVectorArray();
+    } catch (const char *e) {
+        errors[1] = e;
+    }
+    try {
+        PVector v = PVectorArray();
+    } catch (const char *e) {
+        errors[2] = e;
+    }
+    for (int i = 0; i < 3; i++)
+        QVERIFY(errors[i] != 0);
+    PVectorArray empty;
+    empty = PVectorArray() + PVectorArray();
+    QCOMPARE(empty.size(), 0);
+    five = PVectorArray();
+    QCOMPARE(five.size(), 0);
+}
+
 QTEST_MAIN(TestPVector)
 #include "testpvector.moc"
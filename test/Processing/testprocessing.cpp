@@ -4,6 +4,8 @@
 #include <QtTest/QtTest>
 #define P_USE_USER_MAIN
 #include <Processing>
+#include <cmath>
+#include <limits>
 
 using namespace processing;
 
@@ -12,6 +14,8 @@ class TestProcessing : public QObject
     Q_OBJECT
 private slots:
     void test_color();
+    void test_lerpColor();
+    void test_hsb();
 
     void test_abs();
     void test_ceil();
@@ -30,6 +34,7 @@ private slots:
     void test_round();
     void test_sq();
     void test_sqrt();
+    void test_arrays();
 
     void test_acos();
     void test_asin();
@@ -74,6 +79,66 @@ void TestProcessing::test_color()
     QCOMPARE(green(c), 67.0);
     QCOMPARE(blue(c), 33.0);
     QCOMPARE(alpha(c), 255.0);
+
+    // Packed as in pixels[], also at compile time
+    constexpr color packed = "#336699";
+    static_assert(packed.argb() == 0xFF336699, "packed color");
+    QCOMPARE(color(0xFF336699).argb(), 0xFF336699u);
+    QCOMPARE(color(300, -20, 128).argb(), 0xFFFF0080u);
+    QCOMPARE(color(128).argb(), 0xFF808080u);
+    QCOMPARE(color::fromARGB(0x12).argb(), 0x12u);
+}
+
+void TestProcessing::test_lerpColor()
+{
+    color a(0, 100, 200, 255);
+    color b(255, 0, 100, 55);
+    QVERIFY(lerpColor(a, b, 0) == a);
+    QVERIFY(lerpColor(a, b, 1) == b);
+    QVERIFY(lerpColor(a, b, 2) == b);
+    color half = lerpColor(a, b, 0.5);
+    QCOMPARE(red(half), 127.0f);
+    QCOMPARE(green(half), 50.0f);
+    QCOMPARE(blue(half), 150.0f);
+    QCOMPARE(alpha(half), 155.0f);
+
+    // Arrays give the same colors as one at a time
+    unsigned int from[7], to[7], out[7];
+    for (int i = 0; i < 7; i++)
+    {
+        from[i] = color(i * 30, 255 - i * 30, i, 255).argb();
+        to[i] = color(i, i * 20, 255, i * 40).argb();
+    }
+    lerpColor(from, to, 0.3, out, 7);
+    for (int i = 0; i < 7; i++)
+        QCOMPARE(out[i], lerpColor(color::fromARGB(from[i]), color::fromARGB(to[i]), 0.3).argb());
+
+    unsigned int ramp[9];
+    lerpColor(a, b, ramp, 9);
+    QCOMPARE(ramp[0], a.argb());
+    QCOMPARE(ramp[4], half.argb());
+    QCOMPARE(ramp[8], b.argb());
+    for (int i = 0; i < 9; i++)
+        QCOMPARE(ramp[i], lerpColor(a, b, i / 8.0).argb());
+}
+
+void TestProcessing::test_hsb()
+{
+    // Scaled to the default ranges of 255, hue going once round the circle
+    QCOMPARE(hue(color(255, 0, 0)), 0.0f);
+    QCOMPARE(hue(color(0, 255, 0)), 85.0f);
+    QCOMPARE(hue(color(0, 0, 255)), 170.0f);
+    QCOMPARE(hue(color(255, 0, 255)), 212.5f);
+    QCOMPARE(saturation(color(0, 255, 0)), 255.0f);
+    QCOMPARE(saturation(color(255, 128, 128)), 127.0f);
+    QCOMPARE(brightness(color(0, 0, 128)), 128.0f);
+    QCOMPARE(brightness(color(10, 200, 30)), 200.0f);
+
+    // Greys have no hue or saturation, however bright they are
+    QCOMPARE(hue(color(77)), 0.0f);
+    QCOMPARE(saturation(color(77)), 0.0f);
+    QCOMPARE(brightness(color(77)), 77.0f);
+    QCOMPARE(brightness(color(0)), 0.0f);
 }
 
 void TestProcessing::test_abs()
@@ -131,6 +196,8 @@ void TestProcessing::test_lerp()
     QCOMPARE(lerp(a, b, 0.0), 20.0f);
     QCOMPARE(lerp(a, b, 0.5), 50.0f);
     QCOMPARE(lerp(a, b, 1.0), 80.0f);
+    QCOMPARE(lerp(a, b, 1.5), 110.0f);
+    QCOMPARE(lerp(a, b, -0.5), -10.0f);
 }
 
 void TestProcessing::test_log()
@@ -157,6 +224,30 @@ void TestProcessing::test_map()
     QVERIFY(map( 5, 0, 10, -20, 20) ==   0);
     QVERIFY(map(10, 0, 10, -20, 20) ==  20);
     QVERIFY(map(11, 0, 10, -20, 20) ==  24);
+    QVERIFY(map(15, 10, 20, 0, 100) == 50);
+    QVERIFY(map(10, 20, 10, 0, 1) == 1);
+
+    // The ends of the range map exactly, one value at a time and in arrays
+    float ends[8], out[8];
+    for (int start1 = -30; start1 <= 30; start1 += 3)
+    {
+        for (int stop1 = -100; stop1 <= 100; stop1 += 7)
+        {
+            if (stop1 == start1)
+                continue;
+            for (int k = 0; k < 8; k++)
+                ends[k] = (k % 2 ? stop1 : start1);
+            for (int stop2 = -50; stop2 <= 50; stop2 += 11)
+            {
+                // QCOMPARE() would let floats differ in the last bits
+                QVERIFY(map(start1, start1, stop1, 3, stop2) == 3);
+                QVERIFY(map(stop1, start1, stop1, 3, stop2) == stop2);
+                map(ends, start1, stop1, 3, stop2, out, 7);
+                for (int k = 0; k < 7; k++)
+                    QVERIFY(out[k] == (k % 2 ? stop2 : 3));
+            }
+        }
+    }
 }
 
 void TestProcessing::test_max()
@@ -176,7 +267,9 @@ void TestProcessing::test_min()
 void TestProcessing::test_norm()
 {
     QCOMPARE(norm(20, 0, 50), 0.4);
+    QVERIFY(norm(20, 0, 50) == 0.4f);
     QCOMPARE(norm(-10, 0, 100), -0.1);
+    QCOMPARE(norm(30, 20, 70), 0.2);
 }
 
 void TestProcessing::test_pow()
@@ -208,6 +301,68 @@ void TestProcessing::test_sqrt()
     QVERIFY(sqrt(81) == 9);
 }
 
+void TestProcessing::test_arrays()
+{
+    // Every length around the width of a vector, checked against the
+    // functions one value at a time
+    float a[11], b[11], c[11], d[11], e[11], f[11], out[11];
+    for (int i = 0; i < 11; i++)
+    {
+        a[i] = i * 1.5f - 4;
+        b[i] = 7 - i * 0.75f;
+        c[i] = i * 0.25f;
+        d[i] = i * i * 0.5f;
+        e[i] = -i;
+        f[i] = i * 0.1f;
+    }
+    for (int n = 0; n <= 11; n++)
+    {
+        constrain(a, -2, 5, out, n);
+        for (int i = 0; i < n; i++)
+            QCOMPARE(out[i], constrain(a[i], -2.0f, 5.0f));
+        dist(a, b, c, d, out, n);
+        for (int i = 0; i < n; i++)
+            QCOMPARE(out[i], dist(a[i], b[i], c[i], d[i]));
+        dist(a, b, c, d, e, f, out, n);
+        for (int i = 0; i < n; i++)
+            QCOMPARE(out[i], dist(a[i], b[i], c[i], d[i], e[i], f[i]));
+        lerp(a, b, 0.3f, out, n);
+        for (int i = 0; i < n; i++)
+            QCOMPARE(out[i], lerp(a[i], b[i], 0.3f));
+        lerp(-1, 3, c, out, n);
+        for (int i = 0; i < n; i++)
+            QCOMPARE(out[i], lerp(-1.0f, 3.0f, c[i]));
+        mag(a, b, out, n);
+        for (int i = 0; i < n; i++)
+            QCOMPARE(out[i], mag(a[i], b[i]));
+        mag(a, b, c, out, n);
+        for (int i = 0; i < n; i++)
+            QCOMPARE(out[i], mag(a[i], b[i], c[i]));
+        map(d, 2, 12, -1, 1, out, n);
+        for (int i = 0; i < n; i++)
+            QCOMPARE(out[i], map(d[i], 2, 12, -1, 1));
+        norm(a, -4, 11, out, n);
+        for (int i = 0; i < n; i++)
+            QCOMPARE(out[i], norm(a[i], -4, 11));
+    }
+
+    // NaN passes through and low above high gives low below it, high
+    // elsewhere, in the vector part and the tail alike
+    a[1] = a[9] = std::numeric_limits<float>::quiet_NaN();
+    constrain(a, -2, 5, out, 11);
+    QVERIFY(std::isnan(out[1]) && std::isnan(out[9]));
+    constrain(a, 5, -2, out, 11);
+    for (int i = 0; i < 11; i++)
+    {
+        if (std::isnan(a[i]))
+            QVERIFY(std::isnan(out[i]));
+        else
+            QCOMPARE(out[i], constrain(a[i], 5.0f, -2.0f));
+    }
+    QCOMPARE(out[0], 5.0f);
+    QCOMPARE(out[10], -2.0f);
+}
+
 void TestProcessing::test_acos()
 {
     QVERIFY(acos(1) == 0);
@@ -241,6 +396,8 @@ void TestProcessing::test_degrees()
     QCOMPARE(degrees(HALF_PI),    90.0f);
     QCOMPARE(degrees(PI),         180.0f);
     QCOMPARE(degrees(TWO_PI),     360.0f);
+    QCOMPARE(degrees(-PI),        -180.0f);
+    QCOMPARE(degrees(2 * TWO_PI), 720.0f);
 }
 
 void TestProcessing::test_radians()
@@ -251,6 +408,8 @@ void TestProcessing::test_radians()
     QCOMPARE(radians(90),  (float) HALF_PI);
     QCOMPARE(radians(180), (float) PI);
     QCOMPARE(radians(360), (float) TWO_PI);
+    QCOMPARE(radians(-180), (float) -PI);
+    QCOMPARE(radians(720), (float) (2 * TWO_PI));
 }
 
 void TestProcessing::test_sin()
@@ -0,0 +1,165 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include <QtTest/QtTest>
+#define P_USE_USER_MAIN
+#include <Processing>
+#include "qtcurvecache.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace processing;
+
+class TestQtCurveCache : public QObject
+{
+    Q_OBJECT
+private slots:
+    void test_flatten();
+    void test_find();
+    void test_fromCurve();
+};
+
+static void bezier(const float *c, double t, double *x, double *y)
+{
+    double u = 1 - t;
+    double b0 = u * u * u, b1 = 3 * u * u * t, b2 = 3 * u * t * t, b3 = t * t * t;
+    *x = b0 * c[0] + b1 * c[2] + b2 * c[4] + b3 * c[6];
+    *y = b0 * c[1] + b1 * c[3] + b2 * c[5] + b3 * c[7];
+}
+
+static double segmentDistance(const QPointF &a, const QPointF &b, double x, double y)
+{
+    double dx = b.x() - a.x(), dy = b.y() - a.y();
+    double l2 = dx * dx + dy * dy;
+    double t = (l2 > 0 ? ((x - a.x()) * dx + (y - a.y()) * dy) / l2 : 0);
+    t = std::min(std::max(t, 0.0), 1.0);
+    double ex = a.x() + t * dx - x, ey = a.y() + t * dy - y;
+    return std::sqrt(ex * ex + ey * ey);
+}
+
+// Farthest the curve gets from the polyline, the points being taken at
+// even steps of t so each stretch of the curve is next to one segment
+static double deviation(const float *c, const std::vector<QPointF> &points)
+{
+    int n = points.size() - 1;
+    double worst = 0;
+    for (int i = 0; i < n; i++)
+    {
+        for (int k = 0; k <= 16; k++)
+        {
+            double x, y;
+            bezier(c, (i + k / 16.0) / n, &x, &y);
+            worst = std::max(worst, segmentDistance(points[i], points[i + 1], x, y));
+        }
+    }
+    return worst;
+}
+
+// A point of Processing's curve() segment from p1 to p2 at t, using its
+// curveTightness() basis matrix
+static void processingCurve(const float *p, float s, double t, double *x, double *y)
+{
+    const double m[4][4] = {
+        { (s - 1) / 2, (s + 3) / 2, (-3 - s) / 2, (1 - s) / 2 },
+        { 1 - s, (-5 - s) / 2, s + 2, (s - 1) / 2 },
+        { (s - 1) / 2, 0, (1 - s) / 2, 0 },
+        { 0, 1, 0, 0 }
+    };
+    double powers[4] = { t * t * t, t * t, t, 1 };
+    *x = *y = 0;
+    for (int r = 0; r < 4; r++)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            *x += powers[r] * m[r][k] * p[2 * k];
+            *y += powers[r] * m[r][k] * p[2 * k + 1];
+        }
+    }
+}
+
+void TestQtCurveCache::test_flatten()
+{
+    const float curves[][8] = {
+        { 0, 0, 30, 100, 70, -100, 100, 0 },
+        { 0, 0, 0, 50, 50, 50, 50, 0 },
+        { 10, 10, 200, 10, -100, 300, 400, 400 },
+        // A cusp
+        { 0, 0, 100, 100, 0, 100, 100, 0 },
+        // A straight line is one segment
+        { 0, 0, 10, 10, 20, 20, 30, 30 }
+    };
+    std::vector<QPointF> points;
+    for (int c = 0; c < 5; c++)
+    {
+        for (float tolerance = 1; tolerance >= 0.01f; tolerance /= 4)
+        {
+            QtCurveCache::flatten(curves[c], tolerance, points);
+            QVERIFY(points.size() >= 2);
+            QCOMPARE(points.front(), QPointF(curves[c][0], curves[c][1]));
+            QCOMPARE(points.back(), QPointF(curves[c][6], curves[c][7]));
+            QVERIFY(deviation(curves[c], points) <= tolerance);
+
+            // The points themselves lie on the curve
+            int n = points.size() - 1;
+            for (int i = 0; i <= n; i++)
+            {
+                double x, y;
+                bezier(curves[c], (double) i / n, &x, &y);
+                QVERIFY(std::fabs(points[i].x() - x) < 1e-3 && std::fabs(points[i].y() - y) < 1e-3);
+            }
+        }
+    }
+    QtCurveCache::flatten(curves[4], 0.25f, points);
+    QCOMPARE((int) points.size(), 2);
+}
+
+void TestQtCurveCache::test_find()
+{
+    // Within a quarter pixel at the scale asked for
+    const float c[8] = { 0, 0, 30, 100, 70, -100, 100, 0 };
+    QtCurveCache cache;
+    const float scales[] = { 0.1f, 0.5f, 1, 3, 10 };
+    for (int i = 0; i < 5; i++)
+        QVERIFY(deviation(c, cache.find(c, scales[i])) * scales[i] <= 0.25f);
+
+    // Scales in the same power of two share a polyline
+    const std::vector<QPointF> &a = cache.find(c, 3);
+    QCOMPARE(&cache.find(c, 2.5f), &a);
+    QVERIFY(&cache.find(c, 5) != &a);
+    QVERIFY(cache.find(c, 5).size() > a.size());
+
+    const float d[8] = { 0, 0, 30, 100, 70, -100, 100, 1 };
+    QVERIFY(&cache.find(d, 3) != &cache.find(c, 3));
+}
+
+void TestQtCurveCache::test_fromCurve()
+{
+    const float p[8] = { -20, 50, 0, 0, 100, 30, 140, -60 };
+    const float tightness[] = { 0, 0.5f, -1, 1 };
+    for (int i = 0; i < 4; i++)
+    {
+        float c[8];
+        QtCurveCache::fromCurve(p, tightness[i], c);
+        for (int k = 0; k <= 10; k++)
+        {
+            double x, y, ex, ey;
+            bezier(c, k / 10.0, &x, &y);
+            processingCurve(p, tightness[i], k / 10.0, &ex, &ey);
+            QVERIFY(std::fabs(x - ex) < 1e-3 && std::fabs(y - ey) < 1e-3);
+        }
+    }
+
+    // Tightness 0 is Catmull-Rom, through the middle points at their ends
+    float c[8];
+    QtCurveCache::fromCurve(p, 0, c);
+    QCOMPARE(c[0], p[2]);
+    QCOMPARE(c[1], p[3]);
+    QCOMPARE(c[6], p[4]);
+    QCOMPARE(c[7], p[5]);
+    QCOMPARE(c[2], p[2] + (p[4] - p[0]) / 6);
+    QCOMPARE(c[5], p[5] - (p[7] - p[3]) / 6);
+}
+
+QTEST_MAIN(TestQtCurveCache)
+#include "testqtcurvecache.moc"
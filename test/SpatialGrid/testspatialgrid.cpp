@@ -0,0 +1,206 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include <QtTest/QtTest>
+#define P_USE_USER_MAIN
+#include <Processing>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace processing;
+
+class TestSpatialGrid : public QObject
+{
+    Q_OBJECT
+private slots:
+    void test_build();
+    void test_within();
+    void test_pairs();
+    void test_batch();
+    void test_empty();
+};
+
+// Points over 0 to size on a lattice of half cells, so half of every
+// coordinate lies exactly on a cell edge and many distances come out
+// exactly at the whole and half radii the tests ask for
+static PVectorArray onCellEdges(int count, PVector::Type type, float size, float cell)
+{
+    std::srand(count);
+    int steps = (int) (2 * size / cell) + 1;
+    PVectorArray points(count, type);
+    for (int i = 0; i < count; i++)
+    {
+        float x = std::rand() % steps * 0.5f * cell;
+        float y = std::rand() % steps * 0.5f * cell;
+        float z = std::rand() % steps * 0.5f * cell;
+        if (type == PVector::V3D)
+            points.set(i, x, y, z);
+        else
+            points.set(i, x, y);
+    }
+    return points;
+}
+
+static std::vector<int> bruteWithin(const PVectorArray &points, const PVector &p, float radius)
+{
+    std::vector<int> result;
+    for (int i = 0; i < points.size(); i++)
+    {
+        float dx = points.x(i) - p.x();
+        float dy = points.y(i) - p.y();
+        float dz = (points.is3D() ? points.z(i) - p.z() : 0);
+        if (dx * dx + dy * dy + dz * dz <= radius * radius)
+            result.push_back(i);
+    }
+    return result;
+}
+
+void TestSpatialGrid::test_build()
+{
+    PVectorArray points = onCellEdges(1000, PVector::V2D, 100, 5);
+    SpatialGrid grid(5, points);
+    QCOMPARE(grid.size(), 1000);
+    QVERIFY(!grid.is3D());
+    QCOMPARE(grid.cellSize(), 5.0f);
+    QVERIFY(grid.cellCount() >= 400);
+
+    // Every point is listed once, in its own cell
+    std::vector<int> seen(points.size(), 0);
+    for (int c = 0; c < grid.cellCount(); c++)
+    {
+        for (int i = grid.cellStart(c); i < grid.cellEnd(c); i++)
+        {
+            int index = grid.indices()[i];
+            seen[index]++;
+            QCOMPARE(grid.cellOf(points.get(index)), c);
+        }
+    }
+    QVERIFY(std::count(seen.begin(), seen.end(), 1) == 1000);
+    QCOMPARE(grid.cellOf(PVector(-1.0, 0.0)), -1);
+
+    // Far apart points take larger cells than asked for
+    PVectorArray far(2);
+    far.set(1, 1e6, 1e6);
+    SpatialGrid sparse(1, far);
+    QVERIFY(sparse.cellSize() > 1e5);
+    QVERIFY(sparse.cellCount() <= 2 * P_SPATIAL_GRID_CELLS);
+}
+
+void TestSpatialGrid::test_within()
+{
+    PVectorArray points = onCellEdges(3000, PVector::V3D, 100, 4);
+    SpatialGrid grid(4, points);
+    QVERIFY(grid.is3D());
+    std::vector<int> result;
+    for (int i = 0; i < 30; i++)
+    {
+        PVector p(i * 3.0f, 50, 100 - i * 3.0f);
+        float radius = 1.0f + i * 0.5f;
+        grid.within(p, radius, result);
+        std::sort(result.begin(), result.end());
+        QVERIFY(result == bruteWithin(points, p, radius));
+    }
+
+    int count = 0;
+    grid.forEachNeighbor(PVector(50.0, 50.0, 50.0), 1000, [&count](int) {
+        count++;
+    });
+    QCOMPARE(count, 3000);
+}
+
+void TestSpatialGrid::test_pairs()
+{
+    PVectorArray points = onCellEdges(4000, PVector::V2D, 100, 2);
+    SpatialGrid grid(2, points);
+    for (float radius = 1; radius <= 5; radius += 2)
+    {
+        std::vector< std::pair<int, int> > result;
+        grid.pairs(radius, result);
+        std::sort(result.begin(), result.end());
+        std::vector< std::pair<int, int> > expected;
+        for (int i = 0; i < points.size(); i++)
+        {
+            std::vector<int> near = bruteWithin(points, points.get(i), radius);
+            for (size_t j = 0; j < near.size(); j++)
+                if (near[j] > i)
+                    expected.push_back(std::make_pair(i, near[j]));
+        }
+        QCOMPARE(result.size(), expected.size());
+        QVERIFY(result == expected);
+    }
+
+    PVectorArray space = onCellEdges(2000, PVector::V3D, 50, 3);
+    SpatialGrid grid3D(3, space);
+    std::vector< std::pair<int, int> > result;
+    grid3D.pairs(3, result);
+    int expected = 0;
+    for (int i = 0; i < space.size(); i++)
+        expected += (int) bruteWithin(space, space.get(i), 3).size() - 1;
+    QCOMPARE((int) result.size(), expected / 2);
+}
+
+void TestSpatialGrid::test_batch()
+{
+    PVectorArray points = onCellEdges(20000, PVector::V2D, 1000, 10);
+    SpatialGrid grid(10, points);
+    std::vector< std::vector<int> > near;
+    grid.within(points, 10, near);
+    QCOMPARE((int) near.size(), 20000);
+    std::vector<int> result;
+    for (int i = 0; i < points.size(); i += 997)
+    {
+        grid.within(points.get(i), 10, result);
+        QVERIFY(near[i] == result);
+    }
+}
+
+void TestSpatialGrid::test_empty()
+{
+    SpatialGrid grid(1);
+    QCOMPARE(grid.size(), 0);
+    QCOMPARE(grid.cellCount(), 0);
+    std::vector<int> result(3);
+    grid.within(PVector(1.0, 2.0), 10, result);
+    QVERIFY(result.empty());
+    std::vector< std::pair<int, int> > pairs(1);
+    grid.pairs(1, pairs);
+    QVERIFY(pairs.empty());
+
+    grid.build(onCellEdges(100, PVector::V2D, 10, 1));
+    grid.clear();
+    QCOMPARE(grid.size(), 0);
+    QCOMPARE(grid.cellOf(PVector(1.0, 2.0)), -1);
+
+    bool thrown = false;
+    try {
+        SpatialGrid bad(0);
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+
+    // Bounds wider than a float can hold
+    PVectorArray far(2, PVector::V2D);
+    far.set(0, PVector(-3e38, 0.0));
+    far.set(1, PVector(3e38, 0.0));
+    thrown = false;
+    try {
+        grid.build(far);
+    } catch (const char *) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+
+    // Just inside them the cells grow to the largest float
+    far.set(0, PVector(-1.5e38, 1.0));
+    far.set(1, PVector(1.5e38, -1.0));
+    grid.build(far);
+    QCOMPARE(grid.size(), 2);
+    QCOMPARE(grid.cellOf(PVector(-1.5e38, 1.0)), 0);
+    grid.within(PVector(1.5e38, -1.0), 1, result);
+    QCOMPARE((int) result.size(), 1);
+    QCOMPARE(result[0], 1);
+}
+
+QTEST_MAIN(TestSpatialGrid)
+#include "testspatialgrid.moc"
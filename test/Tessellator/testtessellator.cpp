@@ -0,0 +1,226 @@
+/**
+ * Author: Gary Huang <gh.nctu+code@gmail.com>
+ */
+#include <QtTest/QtTest>
+#define P_USE_USER_MAIN
+#include <Processing>
+#include "tessellator.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace processing;
+
+class TestTessellator : public QObject
+{
+    Q_OBJECT
+private slots:
+    void test_convex();
+    void test_concave();
+    void test_holed();
+    void test_selfIntersecting();
+    void test_joins();
+    void test_caps();
+};
+
+static double polygonArea(const std::vector<float> &xy)
+{
+    double area = 0;
+    int n = xy.size() / 2;
+    for (int i = 0; i < n; i++)
+    {
+        int j = (i + 1) % n;
+        area += (double) xy[2 * i] * xy[2 * j + 1] - (double) xy[2 * j] * xy[2 * i + 1];
+    }
+    return std::fabs(area) / 2;
+}
+
+// Fills never overlap, so the triangles add up to the area covered
+static double trianglesArea(const std::vector<float> &out)
+{
+    double area = 0;
+    for (size_t i = 0; i + 6 <= out.size(); i += 6)
+        area += std::fabs((double) (out[i + 2] - out[i]) * (out[i + 5] - out[i + 1])
+                        - (double) (out[i + 4] - out[i]) * (out[i + 3] - out[i + 1])) / 2;
+    return area;
+}
+
+static double fillArea(const std::vector<float> &xy)
+{
+    Tessellator tessellator;
+    std::vector<float> out;
+    tessellator.fill(xy.data(), xy.size() / 2, out);
+    return trianglesArea(out);
+}
+
+static bool inside(const float *t, double x, double y)
+{
+    double d1 = (t[2] - t[0]) * (y - t[1]) - (t[3] - t[1]) * (x - t[0]);
+    double d2 = (t[4] - t[2]) * (y - t[3]) - (t[5] - t[3]) * (x - t[2]);
+    double d3 = (t[0] - t[4]) * (y - t[5]) - (t[1] - t[5]) * (x - t[4]);
+    return (d1 >= 0 && d2 >= 0 && d3 >= 0) || (d1 <= 0 && d2 <= 0 && d3 <= 0);
+}
+
+// Strokes overlap at the joins, so the area covered is sampled on a fine
+// grid whose sample points never lie on a whole coordinate
+static double coveredArea(const std::vector<float> &out)
+{
+    const double step = 1.0 / 128;
+    float x0 = out[0], y0 = out[1], x1 = out[0], y1 = out[1];
+    for (size_t i = 0; i < out.size(); i += 2)
+    {
+        x0 = std::min(x0, out[i]);
+        x1 = std::max(x1, out[i]);
+        y0 = std::min(y0, out[i + 1]);
+        y1 = std::max(y1, out[i + 1]);
+    }
+    double left = std::floor(x0), top = std::floor(y0);
+    int w = (int) ((std::ceil(x1) - left) / step), h = (int) ((std::ceil(y1) - top) / step);
+    std::vector<char> covered(w * h, 0);
+    for (size_t i = 0; i + 6 <= out.size(); i += 6)
+    {
+        const float *t = &out[i];
+        int c0 = (int) ((std::min(std::min(t[0], t[2]), t[4]) - left) / step);
+        int c1 = (int) ((std::max(std::max(t[0], t[2]), t[4]) - left) / step);
+        int r0 = (int) ((std::min(std::min(t[1], t[3]), t[5]) - top) / step);
+        int r1 = (int) ((std::max(std::max(t[1], t[3]), t[5]) - top) / step);
+        for (int r = r0; r <= std::min(r1, h - 1); r++)
+            for (int c = c0; c <= std::min(c1, w - 1); c++)
+                if (inside(t, left + (c + 0.5) * step, top + (r + 0.5) * step))
+                    covered[r * w + c] = 1;
+    }
+    return std::count(covered.begin(), covered.end(), 1) * step * step;
+}
+
+static double strokeArea(const std::vector<float> &xy, const Tessellator::Stroke &style)
+{
+    Tessellator tessellator;
+    std::vector<float> out;
+    // Scaled up so round parts are split finely
+    tessellator.stroke(xy.data(), xy.size() / 2, false, style, 100, out);
+    return coveredArea(out);
+}
+
+void TestTessellator::test_convex()
+{
+    std::vector<float> hexagon;
+    for (int i = 0; i < 6; i++)
+    {
+        hexagon.push_back(10 * std::cos(i * M_PI / 3));
+        hexagon.push_back(10 * std::sin(i * M_PI / 3));
+    }
+    QVERIFY(Tessellator::isConvex(hexagon.data(), 6));
+    QVERIFY(std::fabs(fillArea(hexagon) - 150 * std::sqrt(3.0)) < 1e-3);
+
+    float square[] = { 0, 0, 10, 0, 10, 10, 0, 10 };
+    QVERIFY(std::fabs(fillArea(std::vector<float>(square, square + 8)) - 100) < 1e-6);
+}
+
+void TestTessellator::test_concave()
+{
+    float arrow[] = { 0, 0, 10, 0, 10, 10, 5, 4, 0, 10 };
+    std::vector<float> xy(arrow, arrow + 10);
+    QVERIFY(!Tessellator::isConvex(xy.data(), 5));
+    QVERIFY(std::fabs(fillArea(xy) - polygonArea(xy)) < 1e-4);
+
+    float comb[] = { 0, 0, 12, 0, 12, 8, 10, 8, 10, 2, 8, 2, 8, 8, 6, 8, 6, 2, 4, 2, 4, 8, 2, 8, 2, 2, 0, 2 };
+    xy.assign(comb, comb + 28);
+    QVERIFY(std::fabs(fillArea(xy) - polygonArea(xy)) < 1e-4);
+
+    // Indices give the same triangles
+    Tessellator tessellator;
+    std::vector<int> indices;
+    QVERIFY(tessellator.triangulate(xy.data(), 14, indices));
+    QCOMPARE((int) indices.size(), 3 * 12);
+}
+
+void TestTessellator::test_holed()
+{
+    // A square with a square hole, one outline going round the hole the
+    // other way along a bridge, so the hole winds to zero
+    float keyhole[] = { 0, 0, 10, 0, 10, 10, 0, 10, 0, 5, 3, 5, 3, 7, 7, 7, 7, 3, 3, 3, 3, 5, 0, 5 };
+    std::vector<float> xy(keyhole, keyhole + 24);
+    QVERIFY(std::fabs(fillArea(xy) - 84) < 1e-4);
+}
+
+void TestTessellator::test_selfIntersecting()
+{
+    float bowtie[] = { 0, 0, 10, 10, 10, 0, 0, 10 };
+    std::vector<float> xy(bowtie, bowtie + 8);
+    QVERIFY(std::fabs(fillArea(xy) - 50) < 1e-4);
+
+    Tessellator tessellator;
+    std::vector<int> indices;
+    QVERIFY(!tessellator.triangulate(xy.data(), 4, indices));
+    QVERIFY(indices.empty());
+
+    // Nonzero fills the middle of a pentagram too, so its area is that of
+    // the outline around it
+    std::vector<float> star, outline;
+    double inner = 10 * std::sin(M_PI / 10) / std::sin(7 * M_PI / 10);
+    for (int i = 0; i < 5; i++)
+    {
+        star.push_back(10 * std::cos(i * 4 * M_PI / 5));
+        star.push_back(10 * std::sin(i * 4 * M_PI / 5));
+    }
+    for (int i = 0; i < 10; i++)
+    {
+        double r = (i % 2 ? inner : 10);
+        outline.push_back(r * std::cos(i * M_PI / 5));
+        outline.push_back(r * std::sin(i * M_PI / 5));
+    }
+    QVERIFY(std::fabs(fillArea(star) - polygonArea(outline)) < 1e-3);
+}
+
+void TestTessellator::test_joins()
+{
+    // Two 2 wide segments turning a right angle cover 39 without a join.
+    // The outer corner is a unit square, cut in half by a bevel.
+    float corner[] = { 0, 0, 10, 0, 10, 10 };
+    std::vector<float> xy(corner, corner + 6);
+    Tessellator::Stroke style;
+    style.weight = 2;
+    style.cap = Tessellator::FLAT_CAP;
+
+    style.join = Tessellator::MITER_JOIN;
+    QVERIFY(std::fabs(strokeArea(xy, style) - 40) < 0.01);
+    style.join = Tessellator::BEVEL_JOIN;
+    QVERIFY(std::fabs(strokeArea(xy, style) - 39.5) < 0.01);
+    style.join = Tessellator::ROUND_JOIN;
+    QVERIFY(std::fabs(strokeArea(xy, style) - (39 + M_PI / 4)) < 0.01);
+
+    // Past the limit a miter is beveled
+    style.join = Tessellator::MITER_JOIN;
+    style.miterLimit = 1.2f;
+    QVERIFY(std::fabs(strokeArea(xy, style) - 39.5) < 0.01);
+
+    // Going straight on needs no join
+    float straight[] = { 0, 0, 5, 0, 10, 0 };
+    style.miterLimit = 4;
+    QVERIFY(std::fabs(strokeArea(std::vector<float>(straight, straight + 6), style) - 20) < 0.01);
+}
+
+void TestTessellator::test_caps()
+{
+    float line[] = { 0, 0, 10, 0 };
+    std::vector<float> xy(line, line + 4);
+    Tessellator::Stroke style;
+    style.weight = 2;
+
+    style.cap = Tessellator::FLAT_CAP;
+    QVERIFY(std::fabs(strokeArea(xy, style) - 20) < 0.01);
+    style.cap = Tessellator::SQUARE_CAP;
+    QVERIFY(std::fabs(strokeArea(xy, style) - 24) < 0.01);
+    style.cap = Tessellator::ROUND_CAP;
+    QVERIFY(std::fabs(strokeArea(xy, style) - (20 + M_PI)) < 0.02);
+
+    // A single point is a cap on its own
+    float point[] = { 3, 4 };
+    xy.assign(point, point + 2);
+    QVERIFY(std::fabs(strokeArea(xy, style) - M_PI) < 0.02);
+    style.cap = Tessellator::SQUARE_CAP;
+    QVERIFY(std::fabs(strokeArea(xy, style) - 4) < 0.01);
+}
+
+QTEST_MAIN(TestTessellator)
+#include "testtessellator.moc"